@@ -0,0 +1,169 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "AgentFixture.hpp"
+
+#include <zmq.h>
+
+#include <array>
+#include <chrono>
+#include <thread>
+
+namespace fs = boost::filesystem;
+
+namespace opentxs::agent::bench
+{
+std::unique_ptr<AgentFixture> AgentFixture::instance_{};
+
+AgentFixture::AgentFixture()
+    : server_keys_(network::zeromq::CurveClient::RandomKeypair())
+    , client_keys_(network::zeromq::CurveClient::RandomKeypair())
+    , directory_(fs::temp_directory_path() / fs::unique_path())
+    , socket_path_("ipc://" + (directory_ / "agent.sock").string())
+    , settings_path_((directory_ / "otagent.ini").string())
+    , endpoints_({"ipc://" + (directory_ / "curve.sock").string()})
+    , config_()
+    , agent_()
+    , context_(zmq_ctx_new())
+    , curve_(nullptr)
+    , local_(nullptr)
+{
+    fs::create_directories(directory_);
+    config_.put("otagent.executor", "synthetic");
+    config_.put("otagent.synthetic-task-delay", 0);
+    // The socket path uses peer credentials and the extra endpoint keeps
+    // CURVE, so both can be measured over the same transport
+    config_.put("otagent.ipc-auth", "peer");
+    agent_ = std::make_unique<Agent>(
+        OT::App(),
+        0,
+        0,
+        socket_path_,
+        endpoints_,
+        server_keys_.first,
+        server_keys_.second,
+        client_keys_.first,
+        client_keys_.second,
+        settings_path_,
+        config_);
+
+    while (false == agent_->Ready()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    OT_ASSERT(nullptr != context_);
+
+    curve_ = zmq_socket(context_, ZMQ_DEALER);
+    local_ = zmq_socket(context_, ZMQ_DEALER);
+
+    OT_ASSERT(nullptr != curve_);
+    OT_ASSERT(nullptr != local_);
+
+    const auto z85 = [](const std::string& key) -> std::string {
+        std::array<char, 41> output{};
+        zmq_z85_encode(
+            output.data(),
+            reinterpret_cast<const std::uint8_t*>(key.data()),
+            key.size());
+
+        return output.data();
+    };
+    const auto serverPublic = z85(server_keys_.second);
+    const auto clientPublic = z85(client_keys_.second);
+    const auto clientSecret = z85(client_keys_.first);
+    const int linger{0};
+    zmq_setsockopt(curve_, ZMQ_LINGER, &linger, sizeof(linger));
+    zmq_setsockopt(local_, ZMQ_LINGER, &linger, sizeof(linger));
+    zmq_setsockopt(
+        curve_,
+        ZMQ_CURVE_SERVERKEY,
+        serverPublic.c_str(),
+        serverPublic.size());
+    zmq_setsockopt(
+        curve_,
+        ZMQ_CURVE_PUBLICKEY,
+        clientPublic.c_str(),
+        clientPublic.size());
+    zmq_setsockopt(
+        curve_,
+        ZMQ_CURVE_SECRETKEY,
+        clientSecret.c_str(),
+        clientSecret.size());
+    auto connected = zmq_connect(curve_, endpoints_.at(0).c_str());
+
+    OT_ASSERT(0 == connected);
+
+    connected = zmq_connect(local_, socket_path_.c_str());
+
+    OT_ASSERT(0 == connected);
+}
+
+AgentFixture& AgentFixture::Get()
+{
+    if (false == bool(instance_)) {
+        instance_.reset(new AgentFixture());
+    }
+
+    return *instance_;
+}
+
+std::vector<std::string> AgentFixture::Receive(const Transport transport)
+{
+    auto* socket = this->socket(transport);
+    std::vector<std::string> output{};
+    bool more{true};
+    bool delimiter{false};
+
+    while (more) {
+        zmq_msg_t frame{};
+        zmq_msg_init(&frame);
+        const auto received = zmq_msg_recv(&frame, socket, 0);
+
+        OT_ASSERT(0 <= received);
+
+        const auto size = zmq_msg_size(&frame);
+
+        if (delimiter || (0 < size)) {
+            output.emplace_back(
+                static_cast<const char*>(zmq_msg_data(&frame)), size);
+        } else {
+            delimiter = true;
+        }
+
+        more = (1 == zmq_msg_more(&frame));
+        zmq_msg_close(&frame);
+    }
+
+    return output;
+}
+
+void AgentFixture::Send(
+    const proto::RPCCommand& command,
+    const Transport transport)
+{
+    auto* socket = this->socket(transport);
+    const auto data = proto::ProtoAsData(command);
+    zmq_send(socket, nullptr, 0, ZMQ_SNDMORE);
+    zmq_send(socket, data->data(), data->size(), 0);
+}
+
+void* AgentFixture::socket(const Transport transport) const
+{
+    return (Transport::Local == transport) ? local_ : curve_;
+}
+
+void AgentFixture::Stop() { instance_.reset(); }
+
+AgentFixture::~AgentFixture()
+{
+    if (nullptr != curve_) { zmq_close(curve_); }
+
+    if (nullptr != local_) { zmq_close(local_); }
+
+    zmq_ctx_term(context_);
+    agent_.reset();
+    fs::remove_all(directory_);
+}
+}  // namespace opentxs::agent::bench
@@ -0,0 +1,72 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef AGENTFIXTURE_HPP_
+#define AGENTFIXTURE_HPP_
+
+#include "opentxs/opentxs.hpp"
+
+#include "Agent.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace opentxs::agent::bench
+{
+// An in-process agent using the synthetic executor, and clients connected to
+// it the same way external clients would be
+class AgentFixture
+{
+public:
+    enum class Transport : int {
+        // CURVE over an ipc endpoint
+        Curve = 0,
+        // The agent's ipc socket with peer credential authentication
+        Local = 1,
+    };
+
+    // Starts the agent on first use
+    static AgentFixture& Get();
+    // Must be called before opentxs is shut down
+    static void Stop();
+
+    // Frames of the next message, without the delimiter
+    std::vector<std::string> Receive(
+        const Transport transport = Transport::Curve);
+    void Send(
+        const proto::RPCCommand& command,
+        const Transport transport = Transport::Curve);
+
+    ~AgentFixture();
+
+private:
+    static std::unique_ptr<AgentFixture> instance_;
+
+    const std::pair<std::string, std::string> server_keys_;
+    const std::pair<std::string, std::string> client_keys_;
+    const boost::filesystem::path directory_;
+    const std::string socket_path_;
+    const std::string settings_path_;
+    const std::vector<std::string> endpoints_;
+    boost::property_tree::ptree config_;
+    std::unique_ptr<Agent> agent_;
+    void* context_;
+    void* curve_;
+    void* local_;
+
+    void* socket(const Transport transport) const;
+
+    AgentFixture();
+    AgentFixture(const AgentFixture&) = delete;
+    AgentFixture(AgentFixture&&) = delete;
+    AgentFixture& operator=(const AgentFixture&) = delete;
+    AgentFixture& operator=(AgentFixture&&) = delete;
+};
+}  // namespace opentxs::agent::bench
+#endif  // AGENTFIXTURE_HPP_
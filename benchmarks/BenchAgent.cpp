@@ -0,0 +1,74 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "opentxs/opentxs.hpp"
+
+#include "AgentFixture.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+using opentxs::agent::bench::AgentFixture;
+
+static opentxs::proto::RPCCommand command(
+    const opentxs::proto::RPCCommandType type,
+    const std::int64_t cookie)
+{
+    opentxs::proto::RPCCommand output{};
+    output.set_version(1);
+    output.set_cookie(std::to_string(cookie));
+    output.set_type(type);
+    output.set_session(0);
+
+    return output;
+}
+
+// Request and reply through the frontend, dispatch and backend path with no
+// wallet work behind it. The argument picks a CURVE connection (0) or a peer
+// credential connection on the local socket (1), both over ipc.
+static void BM_AgentRequest(benchmark::State& state)
+{
+    auto& agent = AgentFixture::Get();
+    const auto transport =
+        static_cast<AgentFixture::Transport>(state.range(0));
+    std::int64_t cookie{0};
+    state.SetLabel(
+        (AgentFixture::Transport::Local == transport) ? "peer" : "curve");
+
+    while (state.KeepRunning()) {
+        agent.Send(
+            command(opentxs::proto::RPCCOMMAND_LISTNYMS, ++cookie), transport);
+        auto reply = agent.Receive(transport);
+        benchmark::DoNotOptimize(reply);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AgentRequest)->Arg(0)->Arg(1)->UseRealTime();
+
+// A queued payment: the reply, then the task complete push once the synthetic
+// task finishes
+static void BM_AgentTask(benchmark::State& state)
+{
+    auto& agent = AgentFixture::Get();
+    std::int64_t cookie{0};
+
+    while (state.KeepRunning()) {
+        auto request =
+            command(opentxs::proto::RPCCOMMAND_SENDPAYMENT, ++cookie);
+        request.mutable_sendpayment()->set_version(1);
+        request.mutable_sendpayment()->set_sourceaccount(
+            "account-" + std::to_string(cookie % 64));
+        agent.Send(request);
+        auto reply = agent.Receive();
+        auto push = agent.Receive();
+        benchmark::DoNotOptimize(reply);
+        benchmark::DoNotOptimize(push);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AgentTask)->UseRealTime();
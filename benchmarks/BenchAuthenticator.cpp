@@ -0,0 +1,48 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "opentxs/opentxs.hpp"
+
+#include "Authenticator.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+// The CURVE public key check done by zap_handler for each new connection
+static void BM_CurveKeyCheck(benchmark::State& state)
+{
+    const auto& ot = opentxs::OT::App();
+    const auto keys = opentxs::network::zeromq::CurveClient::RandomKeypair();
+    const opentxs::agent::Authenticator authenticator(
+        ot, keys.second, {}, {});
+    // Any 32 byte key costs the same to check
+    const std::string pubkey(32, 'k');
+    auto message = opentxs::network::zeromq::Message::Factory();
+    message->AddFrame(pubkey);
+    const auto& frame = message->Body_at(0);
+
+    while (state.KeepRunning()) {
+        auto result = authenticator.CheckCurveKey(frame);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_CurveKeyCheck);
+
+// The uid and gid check done by zap_handler for each new local connection
+static void BM_PeerCheck(benchmark::State& state)
+{
+    const auto& ot = opentxs::OT::App();
+    const opentxs::agent::Authenticator authenticator(
+        ot, "", {1000}, {1000});
+
+    while (state.KeepRunning()) {
+        auto peer = opentxs::agent::Authenticator::ParsePeerAddress(
+            ":1000:1000:4242");
+        auto result = peer.has_value() && authenticator.CheckPeer(peer.value());
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_PeerCheck);
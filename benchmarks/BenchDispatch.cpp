@@ -0,0 +1,44 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "opentxs/opentxs.hpp"
+
+#include "AsyncLog.hpp"
+#include "WorkQueue.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#define OT_METHOD "opentxs::agent::benchmark::"
+
+// Hand off through the queue used by the queue dispatch mode, with one flow
+// per thread
+static void BM_WorkQueue(benchmark::State& state)
+{
+    static opentxs::agent::WorkQueue<int> queue{1, {}, 0};
+    const auto flow = std::to_string(state.thread_index());
+
+    while (state.KeepRunning()) {
+        queue.Push(flow, state.thread_index());
+        auto item = queue.Pop();
+        benchmark::DoNotOptimize(item);
+    }
+}
+BENCHMARK(BM_WorkQueue)->ThreadRange(1, 8);
+
+// A request path log call below the configured level
+static void BM_DisabledLog(benchmark::State& state)
+{
+    static opentxs::agent::AsyncLog log{opentxs::agent::LogLevel::Normal, 100};
+    const std::string nym{"nym"};
+
+    while (state.KeepRunning()) {
+        AGENT_LOG(log, opentxs::agent::LogLevel::Verbose, [nym]() {
+            return "Connection is associated with nym " + nym;
+        });
+    }
+}
+BENCHMARK(BM_DisabledLog);
@@ -0,0 +1,115 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "opentxs/opentxs.hpp"
+
+#include "Protocol.hpp"
+
+#include <benchmark/benchmark.h>
+
+#define ACCOUNT_ID "otwjbJ9pf3tMqiVe3zkzvFw1DFnGcZCMTzfLnZ8nF2jrzAMfYrLb5"
+#define CONNECTION_ID "agent-benchmark"
+#define NYM_ID "ot2AzUQ6AUjY7RpDWuE2Jf8VXU7zP5W1mKWfXGxnZ73aCEqDRp8Sr"
+#define TASK_ID "otw3Qy9Hs1kMWM7KYP7P8SPv2NLC7tMFzSeG3iVkFm9tnKn6WH3Yk"
+
+namespace proto = opentxs::proto;
+namespace zmq = opentxs::network::zeromq;
+
+// Representative of the commands on the payment path
+static proto::RPCCommand send_payment_command()
+{
+    proto::RPCCommand command{};
+    command.set_version(1);
+    command.set_cookie("e4d7c1f0-54a4-4b5f-9c46-1f3f2b5e8c17");
+    command.set_type(proto::RPCCOMMAND_SENDPAYMENT);
+    command.set_session(0);
+    command.add_associatenym(NYM_ID);
+    auto& payment = *command.mutable_sendpayment();
+    payment.set_version(1);
+    payment.set_sourceaccount(ACCOUNT_ID);
+    payment.set_destinationaccount(ACCOUNT_ID);
+    payment.set_memo("benchmark payment");
+    payment.set_amount(100);
+
+    return command;
+}
+
+static proto::RPCResponse queued_response()
+{
+    proto::RPCResponse response{};
+    response.set_version(1);
+    response.set_cookie("e4d7c1f0-54a4-4b5f-9c46-1f3f2b5e8c17");
+    response.set_type(proto::RPCCOMMAND_SENDPAYMENT);
+    response.set_session(0);
+    auto& status = *response.add_status();
+    status.set_version(1);
+    status.set_index(0);
+    status.set_code(proto::RPCRESPONSE_QUEUED);
+    auto& task = *response.add_task();
+    task.set_version(1);
+    task.set_index(0);
+    task.set_id(TASK_ID);
+
+    return response;
+}
+
+// Request frame -> RPCCommand, as done at the top of backend_handler
+static void BM_ParseCommand(benchmark::State& state)
+{
+    const auto raw = proto::ProtoAsData(send_payment_command());
+
+    while (state.KeepRunning()) {
+        const auto data = opentxs::Data::Factory(raw->data(), raw->size());
+        auto command = proto::DataToProto<proto::RPCCommand>(data);
+        benchmark::DoNotOptimize(command);
+    }
+}
+BENCHMARK(BM_ParseCommand);
+
+// RPCResponse -> reply message, as done at the end of backend_handler
+static void BM_SerializeResponse(benchmark::State& state)
+{
+    const auto response = queued_response();
+    auto request = zmq::Message::Factory();
+    request->AddFrame(CONNECTION_ID);
+    request->AddFrame();
+    request->AddFrame(proto::ProtoAsData(send_payment_command()));
+
+    while (state.KeepRunning()) {
+        auto reply = zmq::Message::ReplyFactory(request);
+        reply->AddFrame(proto::ProtoAsData<proto::RPCResponse>(response));
+        benchmark::DoNotOptimize(reply);
+    }
+}
+BENCHMARK(BM_SerializeResponse);
+
+// Push envelope plus an opaque payload, as done in push_handler
+static void BM_InstantiatePush(benchmark::State& state)
+{
+    const auto connection = opentxs::Data::Factory(
+        CONNECTION_ID, sizeof(CONNECTION_ID) - 1);
+    const std::string payload(256, 'x');
+
+    while (state.KeepRunning()) {
+        auto push = opentxs::agent::InstantiatePush(connection);
+        push->AddFrame(payload);
+        benchmark::DoNotOptimize(push);
+    }
+}
+BENCHMARK(BM_InstantiatePush);
+
+// Complete task push, as sent by send_task_push
+static void BM_TaskPush(benchmark::State& state)
+{
+    const auto connection = opentxs::Data::Factory(
+        CONNECTION_ID, sizeof(CONNECTION_ID) - 1);
+
+    while (state.KeepRunning()) {
+        auto push =
+            opentxs::agent::TaskPush(connection, TASK_ID, NYM_ID, true);
+        benchmark::DoNotOptimize(push);
+    }
+}
+BENCHMARK(BM_TaskPush);
@@ -0,0 +1,211 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "opentxs/opentxs.hpp"
+
+#include "AccountOwnerCache.hpp"
+#include "ConcurrentMap.hpp"
+#include "Interner.hpp"
+
+#include <benchmark/benchmark.h>
+#include <malloc.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define CONNECTION_ID "agent-benchmark"
+#define KEYS_PER_THREAD 1024
+
+using Handle = opentxs::agent::Interner::Handle;
+// Same types as Agent::TaskMap and Agent::NymMap
+using TaskData = std::pair<Handle, Handle>;
+using TaskMap = opentxs::agent::ConcurrentMap<std::string, TaskData>;
+using NymMap = opentxs::agent::ConcurrentMap<Handle, Handle>;
+// Task entries before connection and nym ids were interned
+using LegacyTaskData = std::pair<opentxs::OTData, std::string>;
+using LegacyTaskMap =
+    opentxs::agent::ConcurrentMap<std::string, LegacyTaskData>;
+
+static std::vector<std::string> make_keys(
+    const std::string& prefix,
+    const int thread)
+{
+    std::vector<std::string> output{};
+
+    for (int i{0}; i < KEYS_PER_THREAD; ++i) {
+        output.emplace_back(
+            prefix + std::to_string(thread) + "-" + std::to_string(i));
+    }
+
+    return output;
+}
+
+// The life cycle of a task entry: associate_task, then task_handler
+static void BM_TaskRegistry(benchmark::State& state)
+{
+    static TaskMap map{};
+    static opentxs::agent::Interner connections{};
+    static opentxs::agent::Interner nyms{};
+    const auto keys = make_keys("task", state.thread_index());
+    const std::string connection{CONNECTION_ID};
+    const std::string nym{"nym"};
+    std::size_t i{0};
+
+    while (state.KeepRunning()) {
+        const auto& key = keys[i++ % keys.size()];
+        const TaskData data{connections.Intern(connection), nyms.Intern(nym)};
+        map.Set(key, data);
+        auto task = map.Take(key);
+        auto resolved = connections.Resolve(task->first);
+        benchmark::DoNotOptimize(resolved);
+        connections.Release(task->first);
+        nyms.Release(task->second);
+    }
+}
+BENCHMARK(BM_TaskRegistry)->ThreadRange(1, 8);
+
+// Lookups from push_handler against a populated nym map
+static void BM_NymRegistryLookup(benchmark::State& state)
+{
+    static NymMap map{};
+    static opentxs::agent::Interner connections{};
+    static opentxs::agent::Interner nyms{};
+    const auto keys = make_keys("nym", state.thread_index());
+    const auto connection = connections.Intern(CONNECTION_ID);
+
+    for (const auto& key : keys) { map.Add(nyms.Intern(key), connection); }
+
+    std::size_t i{0};
+
+    while (state.KeepRunning()) {
+        const auto nym = nyms.Find(keys[i++ % keys.size()]);
+        auto found = connections.Resolve(map.Find(nym.value()).value());
+        benchmark::DoNotOptimize(found);
+    }
+}
+BENCHMARK(BM_NymRegistryLookup)->ThreadRange(1, 8);
+
+// Owner lookup on the SENDPAYMENT path with a warm cache
+static void BM_AccountOwnerCacheHit(benchmark::State& state)
+{
+    // Large enough for every thread's keys so each lookup is a hit
+    static opentxs::agent::AccountOwnerCache cache{KEYS_PER_THREAD * 8};
+    const auto keys = make_keys("account", state.thread_index());
+
+    for (const auto& key : keys) { cache.Add(key, "owner"); }
+
+    const auto lookup = [](const std::string&) -> std::string { return {}; };
+    std::size_t i{0};
+
+    while (state.KeepRunning()) {
+        auto owner = cache.Get(keys[i++ % keys.size()], lookup);
+        benchmark::DoNotOptimize(owner);
+    }
+}
+BENCHMARK(BM_AccountOwnerCacheHit)->ThreadRange(1, 8);
+
+// Owner lookup on the SENDPAYMENT path without the cache
+static void BM_AccountOwnerStorage(benchmark::State& state)
+{
+    const auto& storage = opentxs::OT::App().Client(0).Storage();
+    const auto keys = make_keys("account", state.thread_index());
+    std::size_t i{0};
+
+    while (state.KeepRunning()) {
+        auto owner = storage.AccountOwner(
+            opentxs::Identifier::Factory(keys[i++ % keys.size()]));
+        benchmark::DoNotOptimize(owner);
+    }
+}
+BENCHMARK(BM_AccountOwnerStorage)->ThreadRange(1, 8);
+
+// Heap bytes per outstanding task with ids shaped like real ones: 5 byte
+// ROUTER identities shared by 1024 tasks each, 43 character nym ids and 256
+// tasks per nym
+template <typename Insert>
+static void task_memory(benchmark::State& state, Insert insert)
+{
+    const auto tasks = static_cast<std::size_t>(state.range(0));
+    const std::string nymPrefix(34, 'n');
+    const std::string taskPrefix(34, 't');
+
+    while (state.KeepRunning()) {
+        const auto before = mallinfo2().uordblks;
+        {
+            auto registry = insert(tasks, nymPrefix, taskPrefix);
+            const auto after = mallinfo2().uordblks;
+            state.counters["bytes_per_task"] =
+                static_cast<double>(after - before) /
+                static_cast<double>(tasks);
+        }
+    }
+}
+
+static std::string connection_id(const std::size_t task)
+{
+    return std::to_string(10000 + (task / 1024) % 1000);
+}
+
+static std::string padded(const std::string& prefix, const std::size_t i)
+{
+    auto output = prefix + std::to_string(i);
+    output.resize(43, '0');
+
+    return output;
+}
+
+static void BM_TaskMemoryLegacy(benchmark::State& state)
+{
+    task_memory(
+        state,
+        [](const std::size_t tasks,
+           const std::string& nymPrefix,
+           const std::string& taskPrefix) {
+            auto output = std::make_unique<LegacyTaskMap>();
+
+            for (std::size_t i{0}; i < tasks; ++i) {
+                const auto connection = connection_id(i);
+                output->Add(
+                    padded(taskPrefix, i),
+                    LegacyTaskData{
+                        opentxs::Data::Factory(
+                            connection.data(), connection.size()),
+                        padded(nymPrefix, i / 256)});
+            }
+
+            return output;
+        });
+}
+BENCHMARK(BM_TaskMemoryLegacy)->Arg(1 << 20)->Iterations(1);
+
+static void BM_TaskMemoryInterned(benchmark::State& state)
+{
+    struct Registry {
+        TaskMap map_{};
+        opentxs::agent::Interner connections_{};
+        opentxs::agent::Interner nyms_{};
+    };
+
+    task_memory(
+        state,
+        [](const std::size_t tasks,
+           const std::string& nymPrefix,
+           const std::string& taskPrefix) {
+            auto output = std::make_unique<Registry>();
+
+            for (std::size_t i{0}; i < tasks; ++i) {
+                output->map_.Add(
+                    padded(taskPrefix, i),
+                    TaskData{
+                        output->connections_.Intern(connection_id(i)),
+                        output->nyms_.Intern(padded(nymPrefix, i / 256))});
+            }
+
+            return output;
+        });
+}
+BENCHMARK(BM_TaskMemoryInterned)->Arg(1 << 20)->Iterations(1);
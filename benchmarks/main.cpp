@@ -0,0 +1,27 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "opentxs/opentxs.hpp"
+
+#include "AgentFixture.hpp"
+
+#include <benchmark/benchmark.h>
+
+int main(int argc, char** argv)
+{
+    opentxs::ArgList args{{OPENTXS_ARG_STORAGE_PLUGIN, {"mem"}}};
+    const auto& ot = opentxs::OT::Start(args);
+    // Client session 0 backs the storage lookups in BenchRegistry.cpp
+    ot.StartClient(args, 0);
+    ::benchmark::Initialize(&argc, argv);
+
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) { return 1; }
+
+    ::benchmark::RunSpecifiedBenchmarks();
+    opentxs::agent::bench::AgentFixture::Stop();
+    opentxs::OT::Cleanup();
+
+    return 0;
+}
@@ -0,0 +1,523 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "AgentClient.hpp"
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zmq.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#define KEY_FILE "/otagent.key"
+#define KEY_CLIENT_PRIVKEY "otagent.client_privkey"
+#define KEY_CLIENT_PUBKEY "otagent.client_pubkey"
+#define KEY_SERVER_PUBKEY "otagent.server_pubkey"
+#define POLL_INTERVAL_MS 100
+#define PUSH_FRAME "PUSH"
+
+namespace pt = boost::property_tree;
+
+namespace opentxs::agent
+{
+// Binary and Z85 keys are both accepted by libzmq
+static bool valid_key(const std::string& key)
+{
+    return (32 == key.size()) || (40 == key.size());
+}
+
+class AgentClient::Connection
+{
+public:
+    struct Request {
+        std::string cookie_{};
+        std::vector<std::string> frames_{};
+        ReplyCallback callback_{};
+    };
+
+    Connection(AgentClient& parent, void* socket);
+
+    // Fails the request if the connection has stopped
+    void Queue(Request&& request);
+    bool Start();
+
+    // Fails every request still waiting
+    ~Connection();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Waiting {
+        Clock::time_point deadline_{};
+        ReplyCallback callback_{};
+    };
+
+    AgentClient& parent_;
+    void* socket_;
+    // Written when the outbox stops being empty so the thread wakes up
+    // from zmq_poll
+    int wake_[2];
+    std::mutex lock_;
+    std::vector<Request> outbox_;
+    bool running_;
+    // The members below are only used by thread_
+    std::map<std::string, std::deque<Waiting>> waiting_;
+    Clock::time_point next_expiry_;
+    std::thread thread_;
+
+    void complete(const ReplyCallback& callback, Reply&& reply);
+    void expire(const Clock::time_point now);
+    void handle(std::vector<std::string>&& frames);
+    bool receive(std::vector<std::string>& output);
+    void run();
+    void send(Request& request);
+
+    Connection() = delete;
+    Connection(const Connection&) = delete;
+    Connection(Connection&&) = delete;
+    Connection& operator=(const Connection&) = delete;
+    Connection& operator=(Connection&&) = delete;
+};
+
+AgentClient::Connection::Connection(AgentClient& parent, void* socket)
+    : parent_(parent)
+    , socket_(socket)
+    , wake_{-1, -1}
+    , lock_()
+    , outbox_()
+    , running_(false)
+    , waiting_()
+    , next_expiry_(Clock::now())
+    , thread_()
+{
+}
+
+void AgentClient::Connection::complete(
+    const ReplyCallback& callback,
+    Reply&& reply)
+{
+    --parent_.pending_;
+
+    if (callback) { callback(std::move(reply)); }
+}
+
+void AgentClient::Connection::expire(const Clock::time_point now)
+{
+    if (now < next_expiry_) { return; }
+
+    next_expiry_ = now + std::chrono::milliseconds(POLL_INTERVAL_MS);
+
+    for (auto it = waiting_.begin(); it != waiting_.end();) {
+        auto& queue = it->second;
+
+        // Requests with the same cookie were queued in order, so they
+        // expire in order
+        while ((false == queue.empty()) &&
+               (queue.front().deadline_ <= now)) {
+            const auto callback = std::move(queue.front().callback_);
+            queue.pop_front();
+            complete(callback, Reply{});
+        }
+
+        it = queue.empty() ? waiting_.erase(it) : std::next(it);
+    }
+}
+
+void AgentClient::Connection::handle(std::vector<std::string>&& frames)
+{
+    if (frames.empty()) { return; }
+
+    if (PUSH_FRAME == frames.front()) {
+        proto::RPCPush push{};
+
+        if ((1 < frames.size()) && push.ParseFromString(frames.at(1))) {
+            parent_.dispatch_push(push);
+        }
+
+        return;
+    }
+
+    Reply reply{};
+
+    if (false == reply.response_.ParseFromString(frames.front())) { return; }
+
+    auto it = waiting_.find(reply.response_.cookie());
+
+    // Already timed out
+    if (waiting_.end() == it) { return; }
+
+    auto& queue = it->second;
+    const auto callback = std::move(queue.front().callback_);
+    queue.pop_front();
+
+    if (queue.empty()) { waiting_.erase(it); }
+
+    reply.received_ = true;
+
+    // Refused requests carry the reason in a second frame
+    if (1 < frames.size()) { reply.reason_ = std::move(frames.at(1)); }
+
+    complete(callback, std::move(reply));
+}
+
+void AgentClient::Connection::Queue(Request&& request)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+
+    if (false == running_) {
+        lock.unlock();
+        complete(request.callback_, Reply{});
+
+        return;
+    }
+
+    const auto wake = outbox_.empty();
+    outbox_.emplace_back(std::move(request));
+    lock.unlock();
+
+    if (wake) {
+        const char byte{0};
+        [[maybe_unused]] const auto written = ::write(wake_[1], &byte, 1);
+    }
+}
+
+bool AgentClient::Connection::receive(std::vector<std::string>& output)
+{
+    bool more{true};
+    bool first{true};
+    bool delimiter{false};
+
+    while (more) {
+        zmq_msg_t frame{};
+        zmq_msg_init(&frame);
+
+        // Only the first frame can be missing. The rest of a message always
+        // arrives with it.
+        if (0 > zmq_msg_recv(&frame, socket_, first ? ZMQ_DONTWAIT : 0)) {
+            zmq_msg_close(&frame);
+
+            return false;
+        }
+
+        first = false;
+        const auto size = zmq_msg_size(&frame);
+
+        if (delimiter || (0 < size)) {
+            output.emplace_back(
+                static_cast<const char*>(zmq_msg_data(&frame)), size);
+        } else {
+            delimiter = true;
+        }
+
+        more = (1 == zmq_msg_more(&frame));
+        zmq_msg_close(&frame);
+    }
+
+    return true;
+}
+
+void AgentClient::Connection::run()
+{
+    std::vector<Request> outgoing{};
+
+    while (true) {
+        zmq_pollitem_t items[] = {
+            {socket_, 0, ZMQ_POLLIN, 0}, {nullptr, wake_[0], ZMQ_POLLIN, 0}};
+        zmq_poll(items, 2, POLL_INTERVAL_MS);
+
+        if (0 != (items[1].revents & ZMQ_POLLIN)) {
+            char buffer[64];
+
+            while (0 < ::read(wake_[0], buffer, sizeof(buffer))) {}
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+
+            if (false == running_) { break; }
+
+            outgoing.swap(outbox_);
+        }
+
+        for (auto& request : outgoing) { send(request); }
+
+        outgoing.clear();
+
+        if (0 != (items[0].revents & ZMQ_POLLIN)) {
+            std::vector<std::string> frames{};
+
+            while (receive(frames)) {
+                handle(std::move(frames));
+                frames = {};
+            }
+        }
+
+        expire(Clock::now());
+    }
+
+    for (auto& request : outbox_) { complete(request.callback_, Reply{}); }
+
+    outbox_.clear();
+
+    for (auto& [cookie, queue] : waiting_) {
+        for (auto& waiting : queue) { complete(waiting.callback_, Reply{}); }
+    }
+
+    waiting_.clear();
+}
+
+void AgentClient::Connection::send(Request& request)
+{
+    // Never block the connection thread if the agent isn't keeping up
+    bool sent =
+        (0 == zmq_send(socket_, nullptr, 0, ZMQ_SNDMORE | ZMQ_DONTWAIT));
+    const auto count = request.frames_.size();
+
+    for (std::size_t i{0}; sent && (i < count); ++i) {
+        const auto& frame = request.frames_.at(i);
+        sent = (0 <= zmq_send(
+                         socket_,
+                         frame.data(),
+                         frame.size(),
+                         ((i + 1) < count) ? ZMQ_SNDMORE : 0));
+    }
+
+    if (false == sent) {
+        complete(request.callback_, Reply{});
+
+        return;
+    }
+
+    waiting_[request.cookie_].push_back(
+        {Clock::now() + parent_.settings_.timeout_,
+         std::move(request.callback_)});
+}
+
+bool AgentClient::Connection::Start()
+{
+    if (0 != ::pipe(wake_)) { return false; }
+
+    for (const auto fd : wake_) {
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    running_ = true;
+    thread_ = std::thread(&Connection::run, this);
+
+    return true;
+}
+
+AgentClient::Connection::~Connection()
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        running_ = false;
+    }
+
+    if (thread_.joinable()) {
+        const char byte{0};
+        [[maybe_unused]] const auto written = ::write(wake_[1], &byte, 1);
+        thread_.join();
+    }
+
+    zmq_close(socket_);
+
+    for (const auto fd : wake_) {
+        if (0 <= fd) { ::close(fd); }
+    }
+}
+
+AgentClient::AgentClient(const Settings& settings)
+    : settings_(settings)
+    , context_(zmq_ctx_new())
+    , connections_()
+    , next_connection_(0)
+    , pending_(0)
+    , cookie_prefix_([]() {
+        // Cookies only have to be unique among this client's requests, but
+        // a random prefix keeps them apart from other clients' in the
+        // agent's logs
+        std::random_device random{};
+        std::stringstream output{};
+        output << std::hex << std::setfill('0') << std::setw(8) << random()
+               << std::setw(8) << random() << ':';
+
+        return output.str();
+    }())
+    , next_cookie_(0)
+    , push_lock_()
+    , push_callbacks_()
+{
+}
+
+std::unique_ptr<AgentClient> AgentClient::Connect(const Settings& settings)
+{
+    std::unique_ptr<AgentClient> output{new AgentClient(settings)};
+
+    if (nullptr == output->context_) { return {}; }
+
+    const auto count = std::max<std::size_t>(settings.connections_, 1);
+    const int linger{0};
+
+    for (std::size_t i{0}; i < count; ++i) {
+        auto* socket = zmq_socket(output->context_, ZMQ_DEALER);
+
+        if (nullptr == socket) { return {}; }
+
+        zmq_setsockopt(socket, ZMQ_LINGER, &linger, sizeof(linger));
+
+        if (false == settings.server_key_.empty()) {
+            const bool keys =
+                (0 == zmq_setsockopt(
+                          socket,
+                          ZMQ_CURVE_SERVERKEY,
+                          settings.server_key_.c_str(),
+                          settings.server_key_.size())) &&
+                (0 == zmq_setsockopt(
+                          socket,
+                          ZMQ_CURVE_PUBLICKEY,
+                          settings.client_public_key_.c_str(),
+                          settings.client_public_key_.size())) &&
+                (0 == zmq_setsockopt(
+                          socket,
+                          ZMQ_CURVE_SECRETKEY,
+                          settings.client_secret_key_.c_str(),
+                          settings.client_secret_key_.size()));
+
+            if (false == keys) {
+                zmq_close(socket);
+
+                return {};
+            }
+        }
+
+        if (0 != zmq_connect(socket, settings.endpoint_.c_str())) {
+            zmq_close(socket);
+
+            return {};
+        }
+
+        // The connection owns the socket from here on
+        auto& connection = output->connections_.emplace_back(
+            std::make_unique<Connection>(*output, socket));
+
+        if (false == connection->Start()) { return {}; }
+    }
+
+    return output;
+}
+
+void AgentClient::dispatch_push(const proto::RPCPush& push) const
+{
+    std::shared_lock<std::shared_mutex> lock(push_lock_);
+    const auto it = push_callbacks_.find(static_cast<int>(push.type()));
+
+    if (push_callbacks_.end() == it) { return; }
+
+    for (const auto& callback : it->second) { callback(push); }
+}
+
+bool AgentClient::LoadKeys(Settings& settings, const std::string& path)
+{
+    auto file = path;
+
+    if (file.empty()) {
+        const char* home = std::getenv("HOME");
+
+        if (nullptr == home) { return false; }
+
+        file = std::string(home) + KEY_FILE;
+    }
+
+    pt::ptree keys{};
+
+    try {
+        pt::read_json(file, keys);
+    } catch (const pt::json_parser_error&) {
+        return false;
+    }
+
+    const auto server = keys.get<std::string>(KEY_SERVER_PUBKEY, "");
+    const auto secret = keys.get<std::string>(KEY_CLIENT_PRIVKEY, "");
+    const auto client = keys.get<std::string>(KEY_CLIENT_PUBKEY, "");
+
+    if ((false == valid_key(server)) || (false == valid_key(secret)) ||
+        (false == valid_key(client))) {
+        return false;
+    }
+
+    settings.server_key_ = server;
+    settings.client_secret_key_ = secret;
+    settings.client_public_key_ = client;
+
+    return true;
+}
+
+void AgentClient::OnPush(
+    const proto::RPCPushType type,
+    const PushCallback& callback)
+{
+    std::unique_lock<std::shared_mutex> lock(push_lock_);
+    push_callbacks_[static_cast<int>(type)].push_back(callback);
+}
+
+std::future<AgentClient::Reply> AgentClient::Send(
+    const proto::RPCCommand& command,
+    const Options& options)
+{
+    auto promise = std::make_shared<std::promise<Reply>>();
+    auto output = promise->get_future();
+    Send(command, options, [promise](Reply&& reply) {
+        promise->set_value(std::move(reply));
+    });
+
+    return output;
+}
+
+void AgentClient::Send(
+    const proto::RPCCommand& command,
+    const Options& options,
+    const ReplyCallback& callback)
+{
+    Connection::Request request{};
+    request.callback_ = callback;
+
+    if (command.cookie().empty()) {
+        auto copy = command;
+        copy.set_cookie(cookie_prefix_ + std::to_string(next_cookie_++));
+        request.cookie_ = copy.cookie();
+        request.frames_.emplace_back(copy.SerializeAsString());
+    } else {
+        request.cookie_ = command.cookie();
+        request.frames_.emplace_back(command.SerializeAsString());
+    }
+
+    for (const auto& [name, value] : options) {
+        request.frames_.emplace_back(name);
+        request.frames_.emplace_back(value);
+    }
+
+    ++pending_;
+    const auto index = next_connection_++ % connections_.size();
+    connections_.at(index)->Queue(std::move(request));
+}
+
+AgentClient::~AgentClient()
+{
+    connections_.clear();
+
+    if (nullptr != context_) { zmq_ctx_term(context_); }
+}
+}  // namespace opentxs::agent
@@ -0,0 +1,113 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef AGENTCLIENT_HPP_
+#define AGENTCLIENT_HPP_
+
+#include "opentxs/opentxs.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace opentxs::agent
+{
+// Client side of the agent's ZeroMQ protocol.
+//
+// Requests are spread round robin over a pool of connections. Each
+// connection has its own thread which sends queued requests as soon as they
+// are submitted and matches replies to them by cookie, so any number of
+// requests can be outstanding at once. Pushes arriving on any connection are
+// passed to the handlers registered for their type.
+//
+// Pushes for a nym arrive on the connection which last sent a command
+// associating the nym, which may be any connection in the pool. Handlers
+// and reply callbacks run on the connection threads and should not block.
+class AgentClient
+{
+public:
+    struct Settings {
+        // e.g. tcp://127.0.0.1:8080 or ipc:///run/user/1000/otagent.sock
+        std::string endpoint_{};
+        // CURVE keys, Z85 or 32 byte binary. Without a server key the
+        // connections use no encryption, for an ipc socket which
+        // authenticates by peer credentials.
+        std::string server_key_{};
+        std::string client_public_key_{};
+        std::string client_secret_key_{};
+        std::size_t connections_{4};
+        // How long a request waits for its reply
+        std::chrono::milliseconds timeout_{std::chrono::seconds(30)};
+    };
+
+    struct Reply {
+        // False if no reply arrived before the timeout or the client closed
+        bool received_{false};
+        proto::RPCResponse response_{};
+        // Why the agent refused to run the request, e.g. DRAINING, or empty
+        // if it ran
+        std::string reason_{};
+    };
+
+    // Option name and value frames sent after the command, e.g.
+    // {"TIMEOUT", "500"}
+    using Options = std::vector<std::pair<std::string, std::string>>;
+    using PushCallback = std::function<void(const proto::RPCPush&)>;
+    using ReplyCallback = std::function<void(Reply&&)>;
+
+    // Returns nothing if the sockets couldn't be set up
+    static std::unique_ptr<AgentClient> Connect(const Settings& settings);
+    // Sets the keys from the key file otagent writes, $HOME/otagent.key
+    // unless path is given. Returns false if the file has no usable keys.
+    static bool LoadKeys(Settings& settings, const std::string& path = "");
+
+    // Adds a handler for pushes of one type
+    void OnPush(const proto::RPCPushType type, const PushCallback& callback);
+    // Requests submitted and not yet answered or timed out
+    std::size_t Pending() const { return pending_.load(); }
+    // Sends a command. A command without a cookie is given one.
+    std::future<Reply> Send(
+        const proto::RPCCommand& command,
+        const Options& options = {});
+    void Send(
+        const proto::RPCCommand& command,
+        const Options& options,
+        const ReplyCallback& callback);
+
+    // Fails any requests still waiting for replies
+    ~AgentClient();
+
+private:
+    class Connection;
+
+    const Settings settings_;
+    void* context_;
+    std::vector<std::unique_ptr<Connection>> connections_;
+    std::atomic<std::size_t> next_connection_;
+    std::atomic<std::size_t> pending_;
+    const std::string cookie_prefix_;
+    std::atomic<std::uint64_t> next_cookie_;
+    mutable std::shared_mutex push_lock_;
+    std::map<int, std::vector<PushCallback>> push_callbacks_;
+
+    void dispatch_push(const proto::RPCPush& push) const;
+
+    explicit AgentClient(const Settings& settings);
+    AgentClient() = delete;
+    AgentClient(const AgentClient&) = delete;
+    AgentClient(AgentClient&&) = delete;
+    AgentClient& operator=(const AgentClient&) = delete;
+    AgentClient& operator=(AgentClient&&) = delete;
+};
+}  // namespace opentxs::agent
+#endif  // AGENTCLIENT_HPP_
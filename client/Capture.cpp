@@ -0,0 +1,184 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "Capture.hpp"
+
+#include <limits>
+
+#define CAPTURE_MAGIC "OTACAP"
+#define CAPTURE_MAGIC_SIZE 6
+// Records are copied into the stdio buffer, so a request only reaches the
+// disk once this much has accumulated
+#define CAPTURE_BUFFER_SIZE (1024 * 1024)
+
+namespace opentxs::agent::capture
+{
+template <typename T>
+static void append(std::string& output, const T value)
+{
+    output.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+static bool read(std::FILE* file, T& output)
+{
+    return 1 == std::fread(&output, sizeof(output), 1, file);
+}
+
+static bool read(std::FILE* file, std::string& output, const std::size_t size)
+{
+    output.resize(size);
+
+    if (0 == size) { return true; }
+
+    return 1 == std::fread(output.data(), size, 1, file);
+}
+
+Writer::Writer(
+    const std::string& path,
+    const std::uint32_t flags,
+    const std::uint64_t maxBytes,
+    std::FILE* file)
+    : path_(path)
+    , flags_(flags)
+    , max_bytes_(maxBytes)
+    , start_(std::chrono::steady_clock::now())
+    , file_(file)
+    , buffer_(CAPTURE_BUFFER_SIZE)
+    , bytes_(0)
+    , records_(0)
+    , full_(false)
+{
+    std::setvbuf(file_, buffer_.data(), _IOFBF, buffer_.size());
+    const auto start = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count());
+    std::string header(CAPTURE_MAGIC, CAPTURE_MAGIC_SIZE);
+    append(header, Version);
+    append(header, flags_);
+    append(header, start);
+    full_ = (1 != std::fwrite(header.data(), header.size(), 1, file_));
+    bytes_ = header.size();
+}
+
+std::unique_ptr<Writer> Writer::Open(
+    const std::string& path,
+    const std::uint32_t flags,
+    const std::uint64_t maxBytes)
+{
+    auto* file = std::fopen(path.c_str(), "wb");
+
+    if (nullptr == file) { return {}; }
+
+    return std::unique_ptr<Writer>(new Writer(path, flags, maxBytes, file));
+}
+
+bool Writer::Write(const std::string& connection, const Frames& frames)
+{
+    if (full_) { return false; }
+
+    // Anything that doesn't fit the record format isn't a request a client
+    // could have sent, so it is skipped rather than ending the capture
+    if ((std::numeric_limits<std::uint8_t>::max() < connection.size()) ||
+        (std::numeric_limits<std::uint16_t>::max() < frames.size())) {
+        return true;
+    }
+
+    const auto time = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_)
+            .count());
+    std::string record{};
+    append(record, time);
+    append(record, static_cast<std::uint8_t>(connection.size()));
+    record.append(connection);
+    append(record, static_cast<std::uint16_t>(frames.size()));
+
+    for (const auto& frame : frames) {
+        append(record, static_cast<std::uint32_t>(frame.size()));
+        record.append(frame);
+    }
+
+    if ((bytes_ + record.size()) > max_bytes_) {
+        full_ = true;
+
+        return false;
+    }
+
+    if (1 != std::fwrite(record.data(), record.size(), 1, file_)) {
+        full_ = true;
+
+        return false;
+    }
+
+    bytes_ += record.size();
+    ++records_;
+
+    return true;
+}
+
+Writer::~Writer() { std::fclose(file_); }
+
+Reader::Reader(
+    std::FILE* file,
+    const std::uint32_t flags,
+    const std::uint64_t start)
+    : file_(file)
+    , flags_(flags)
+    , start_(start)
+{
+}
+
+bool Reader::Next(Record& output)
+{
+    std::uint64_t time{0};
+    std::uint8_t connection{0};
+    std::uint16_t count{0};
+
+    if (false == read(file_, time)) { return false; }
+    if (false == read(file_, connection)) { return false; }
+    if (false == read(file_, output.connection_, connection)) { return false; }
+    if (false == read(file_, count)) { return false; }
+
+    output.time_ = std::chrono::nanoseconds(time);
+    output.frames_.resize(count);
+
+    for (auto& frame : output.frames_) {
+        std::uint32_t size{0};
+
+        if (false == read(file_, size)) { return false; }
+        if (false == read(file_, frame, size)) { return false; }
+    }
+
+    return true;
+}
+
+std::unique_ptr<Reader> Reader::Open(const std::string& path)
+{
+    auto* file = std::fopen(path.c_str(), "rb");
+
+    if (nullptr == file) { return {}; }
+
+    std::string magic{};
+    std::uint16_t version{0};
+    std::uint32_t flags{0};
+    std::uint64_t start{0};
+    const bool valid = read(file, magic, CAPTURE_MAGIC_SIZE) &&
+                       (CAPTURE_MAGIC == magic) &&
+                       read(file, version) && (Version == version) &&
+                       read(file, flags) && read(file, start);
+
+    if (false == valid) {
+        std::fclose(file);
+
+        return {};
+    }
+
+    return std::unique_ptr<Reader>(new Reader(file, flags, start));
+}
+
+Reader::~Reader() { std::fclose(file_); }
+}  // namespace opentxs::agent::capture
@@ -0,0 +1,112 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef CAPTURE_HPP_
+#define CAPTURE_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Request capture files, written by the agent and read by otagent-replay.
+//
+// The file starts with a header:
+//   [6 byte magic "OTACAP"][u16 version][u32 flags][u64 start, unix ns]
+// followed by one record per request:
+//   [u64 ns since start][u8 connection size][connection]
+//   [u16 frame count]([u32 frame size][frame])...
+// The frames are the serialized RPCCommand and any option frames. Integers
+// are in host byte order, so captures are replayed on the same architecture.
+namespace opentxs::agent::capture
+{
+using Frames = std::vector<std::string>;
+
+static const std::uint16_t Version{1};
+// Set when commands were reduced to their type, session and cookie
+static const std::uint32_t FlagRedacted{0x1};
+
+struct Record {
+    std::chrono::nanoseconds time_{0};
+    std::string connection_{};
+    Frames frames_{};
+};
+
+class Writer
+{
+public:
+    // Replaces any existing file. Returns nothing if it can't be created.
+    static std::unique_ptr<Writer> Open(
+        const std::string& path,
+        const std::uint32_t flags,
+        const std::uint64_t maxBytes);
+
+    std::uint64_t Bytes() const { return bytes_; }
+    std::uint32_t Flags() const { return flags_; }
+    const std::string& Path() const { return path_; }
+    std::uint64_t Records() const { return records_; }
+
+    // Returns false without writing once the size limit is reached or after
+    // a write error. Not thread safe.
+    bool Write(const std::string& connection, const Frames& frames);
+
+    ~Writer();
+
+private:
+    const std::string path_;
+    const std::uint32_t flags_;
+    const std::uint64_t max_bytes_;
+    const std::chrono::steady_clock::time_point start_;
+    std::FILE* file_;
+    std::vector<char> buffer_;
+    std::uint64_t bytes_;
+    std::uint64_t records_;
+    bool full_;
+
+    Writer(
+        const std::string& path,
+        const std::uint32_t flags,
+        const std::uint64_t maxBytes,
+        std::FILE* file);
+    Writer() = delete;
+    Writer(const Writer&) = delete;
+    Writer(Writer&&) = delete;
+    Writer& operator=(const Writer&) = delete;
+    Writer& operator=(Writer&&) = delete;
+};
+
+class Reader
+{
+public:
+    // Returns nothing if the file is missing or not a capture
+    static std::unique_ptr<Reader> Open(const std::string& path);
+
+    std::uint32_t Flags() const { return flags_; }
+    // Returns false at the end of the file or at a truncated record
+    bool Next(Record& output);
+    // Unix time in nanoseconds when the capture started
+    std::uint64_t Start() const { return start_; }
+
+    ~Reader();
+
+private:
+    std::FILE* file_;
+    std::uint32_t flags_;
+    std::uint64_t start_;
+
+    Reader(
+        std::FILE* file,
+        const std::uint32_t flags,
+        const std::uint64_t start);
+    Reader() = delete;
+    Reader(const Reader&) = delete;
+    Reader(Reader&&) = delete;
+    Reader& operator=(const Reader&) = delete;
+    Reader& operator=(Reader&&) = delete;
+};
+}  // namespace opentxs::agent::capture
+#endif  // CAPTURE_HPP_
@@ -0,0 +1,118 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "ShmClient.hpp"
+
+#include <unistd.h>
+
+#include <thread>
+
+// Longest a response for the previous owner of a channel can hold up claiming
+// it, which is longer than the agent waits for space in a response ring
+#define CLAIM_TIMEOUT std::chrono::seconds(2)
+
+namespace opentxs::agent
+{
+ShmClient::ShmClient(
+    std::unique_ptr<shm::Segment> segment,
+    const std::uint32_t index)
+    : segment_(std::move(segment))
+    , index_(index)
+    , channel_(segment_->channel(index))
+    , send_lock_()
+    , receive_lock_()
+{
+}
+
+std::unique_ptr<ShmClient> ShmClient::Connect(const std::string& name)
+{
+    auto segment = shm::Segment::Open(name);
+
+    if (false == bool(segment)) { return {}; }
+
+    const auto pid = static_cast<std::uint32_t>(::getpid());
+    const auto channels = segment->header().channels_;
+
+    for (std::uint32_t i{0}; i < channels; ++i) {
+        auto& channel = segment->channel(i);
+        std::uint32_t free{0};
+
+        if (false == channel.owner_.compare_exchange_strong(free, pid)) {
+            continue;
+        }
+
+        // Responses still being written for the previous client see the new
+        // generation and give up. One already past that check is waited for,
+        // so the reset below can't be overwritten by a late head update.
+        ++channel.generation_;
+        shm::Wake(channel.response_.read_);
+        const auto deadline = std::chrono::steady_clock::now() + CLAIM_TIMEOUT;
+
+        while (0 != channel.writing_.load()) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                channel.owner_.store(0);
+
+                return {};
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        // Whatever the previous client left behind is discarded
+        shm::ResetRing(channel.request_);
+        shm::ResetRing(channel.response_);
+
+        return std::unique_ptr<ShmClient>(
+            new ShmClient(std::move(segment), i));
+    }
+
+    return {};
+}
+
+bool ShmClient::Receive(
+    shm::Frames& output,
+    const std::chrono::milliseconds timeout)
+{
+    std::lock_guard<std::mutex> lock(receive_lock_);
+
+    return shm::Read(
+        channel_.response_,
+        segment_->response_data(index_),
+        segment_->header().ring_size_,
+        output,
+        timeout);
+}
+
+bool ShmClient::Send(
+    const shm::Frames& request,
+    const std::chrono::milliseconds timeout)
+{
+    if (request.empty()) { return false; }
+
+    std::lock_guard<std::mutex> lock(send_lock_);
+    auto& header = segment_->header();
+
+    if (1 != header.running_.load()) { return false; }
+
+    const auto sent = shm::Write(
+        channel_.request_,
+        segment_->request_data(index_),
+        header.ring_size_,
+        request,
+        timeout,
+        nullptr,
+        0);
+
+    if (sent) {
+        ++header.doorbell_;
+
+        if (1 == header.server_waiting_.load()) { shm::Wake(header.doorbell_); }
+    }
+
+    return sent;
+}
+
+ShmClient::~ShmClient() { channel_.owner_.store(0); }
+}  // namespace opentxs::agent
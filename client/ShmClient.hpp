@@ -0,0 +1,64 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef SHMCLIENT_HPP_
+#define SHMCLIENT_HPP_
+
+#include "ShmRing.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace opentxs::agent
+{
+// Client side of the shared memory transport. Sends serialized RPCCommand
+// messages to an agent on the same host and receives RPCResponse messages
+// and pushes, without CURVE or socket copies.
+class ShmClient
+{
+public:
+    // Claims a free channel in the named segment. Returns nothing if the
+    // agent isn't running with shared memory enabled or every channel is in
+    // use.
+    static std::unique_ptr<ShmClient> Connect(
+        const std::string& name = shm::Segment::DefaultName());
+
+    // Waits up to timeout for the next message. Responses have the
+    // serialized RPCResponse as their first frame, followed by a reason frame
+    // if the agent refused to run the request. Pushes are a PUSH frame
+    // followed by the serialized RPCPush.
+    bool Receive(
+        shm::Frames& output,
+        const std::chrono::milliseconds timeout = std::chrono::seconds(30));
+    // Sends a request: the serialized RPCCommand, optionally followed by
+    // option name and value frames
+    bool Send(
+        const shm::Frames& request,
+        const std::chrono::milliseconds timeout = std::chrono::seconds(30));
+
+    // Releases the channel
+    ~ShmClient();
+
+private:
+    const std::unique_ptr<shm::Segment> segment_;
+    const std::uint32_t index_;
+    shm::Channel& channel_;
+    std::mutex send_lock_;
+    std::mutex receive_lock_;
+
+    ShmClient(
+        std::unique_ptr<shm::Segment> segment,
+        const std::uint32_t index);
+    ShmClient() = delete;
+    ShmClient(const ShmClient&) = delete;
+    ShmClient(ShmClient&&) = delete;
+    ShmClient& operator=(const ShmClient&) = delete;
+    ShmClient& operator=(ShmClient&&) = delete;
+};
+}  // namespace opentxs::agent
+#endif  // SHMCLIENT_HPP_
@@ -0,0 +1,437 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "ShmRing.hpp"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <new>
+
+// Polls before sleeping. A round trip usually completes within this many
+// polls, which saves two futex calls per message.
+#define SPIN_COUNT 2000
+
+namespace opentxs::agent::shm
+{
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t));
+
+static void copy_in(
+    char* data,
+    const std::uint32_t size,
+    const std::uint64_t position,
+    const void* source,
+    const std::size_t bytes)
+{
+    const auto offset = static_cast<std::size_t>(position & (size - 1));
+    const auto first = std::min<std::size_t>(bytes, size - offset);
+    std::memcpy(data + offset, source, first);
+    std::memcpy(data, static_cast<const char*>(source) + first, bytes - first);
+}
+
+static void copy_out(
+    const char* data,
+    const std::uint32_t size,
+    const std::uint64_t position,
+    void* destination,
+    const std::size_t bytes)
+{
+    const auto offset = static_cast<std::size_t>(position & (size - 1));
+    const auto first = std::min<std::size_t>(bytes, size - offset);
+    std::memcpy(destination, data + offset, first);
+    std::memcpy(static_cast<char*>(destination) + first, data, bytes - first);
+}
+
+static std::size_t encoded_size(const Frames& message)
+{
+    // [u32 body size][u32 frame count]([u32 frame size][frame])...
+    std::size_t output{2 * sizeof(std::uint32_t)};
+
+    for (const auto& frame : message) {
+        output += sizeof(std::uint32_t) + frame.size();
+    }
+
+    return output;
+}
+
+Segment::Segment(
+    const std::string& name,
+    const bool owner,
+    void* address,
+    const std::size_t size)
+    : name_(name)
+    , owner_(owner)
+    , address_(address)
+    , size_(size)
+    , header_(static_cast<Header*>(address))
+{
+}
+
+Channel& Segment::channel(const std::uint32_t index) const
+{
+    auto* channels = reinterpret_cast<Channel*>(
+        static_cast<char*>(address_) + sizeof(Header));
+
+    return channels[index];
+}
+
+std::unique_ptr<Segment> Segment::Create(
+    const std::string& name,
+    const std::uint32_t channels,
+    const std::uint32_t ringSize)
+{
+    if ((0 == channels) || (0 == ringSize) ||
+        (0 != (ringSize & (ringSize - 1)))) {
+        return {};
+    }
+
+    const auto size = data_offset(channels) +
+                      (std::size_t{2} * channels * std::size_t{ringSize});
+    ::shm_unlink(name.c_str());
+    // Only the agent's own user can open the segment, the same as the
+    // /run/user/<uid> directory holding the ipc socket
+    const auto fd =
+        ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+
+    if (0 > fd) { return {}; }
+
+    if (0 != ::ftruncate(fd, static_cast<off_t>(size))) {
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+
+        return {};
+    }
+
+    auto* address =
+        ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (MAP_FAILED == address) {
+        ::shm_unlink(name.c_str());
+
+        return {};
+    }
+
+    std::unique_ptr<Segment> output{new Segment(name, true, address, size)};
+    // ftruncate zero fills, so only the fields with non-zero initial values
+    // and the atomics need constructing
+    auto& header = *new (address) Header{};
+    header.version_ = Version;
+    header.channels_ = channels;
+    header.ring_size_ = ringSize;
+    header.running_.store(1);
+
+    for (std::uint32_t i{0}; i < channels; ++i) {
+        new (&output->channel(i)) Channel{};
+    }
+
+    header.magic_.store(Magic, std::memory_order_release);
+
+    return output;
+}
+
+std::size_t Segment::data_offset(const std::uint32_t channels)
+{
+    const std::size_t page{4096};
+    const auto control = sizeof(Header) + (sizeof(Channel) * channels);
+
+    return ((control + page - 1) / page) * page;
+}
+
+std::string Segment::DefaultName()
+{
+    return "/otagent-" + std::to_string(::getuid());
+}
+
+std::unique_ptr<Segment> Segment::Open(const std::string& name)
+{
+    const auto fd = ::shm_open(name.c_str(), O_RDWR, 0);
+
+    if (0 > fd) { return {}; }
+
+    struct stat info {
+    };
+
+    if ((0 != ::fstat(fd, &info)) ||
+        (static_cast<std::size_t>(info.st_size) < sizeof(Header))) {
+        ::close(fd);
+
+        return {};
+    }
+
+    const auto size = static_cast<std::size_t>(info.st_size);
+    auto* address =
+        ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (MAP_FAILED == address) { return {}; }
+
+    std::unique_ptr<Segment> output{new Segment(name, false, address, size)};
+    const auto& header = output->header();
+    const bool valid =
+        (Magic == header.magic_.load(std::memory_order_acquire)) &&
+        (Version == header.version_) && (1 == header.running_.load()) &&
+        (size >= data_offset(header.channels_) +
+                     (std::size_t{2} * header.channels_ * header.ring_size_));
+
+    if (false == valid) { return {}; }
+
+    return output;
+}
+
+char* Segment::request_data(const std::uint32_t index) const
+{
+    return static_cast<char*>(address_) + data_offset(header_->channels_) +
+           (std::size_t{2} * index * header_->ring_size_);
+}
+
+char* Segment::response_data(const std::uint32_t index) const
+{
+    return request_data(index) + header_->ring_size_;
+}
+
+Segment::~Segment()
+{
+    if (owner_) {
+        header_->running_.store(0);
+        header_->magic_.store(0);
+    }
+
+    ::munmap(address_, size_);
+
+    if (owner_) { ::shm_unlink(name_.c_str()); }
+}
+
+bool Read(
+    Ring& ring,
+    const char* data,
+    const std::uint32_t size,
+    Frames& output,
+    const std::chrono::milliseconds timeout)
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    for (int i{0}; i < SPIN_COUNT; ++i) {
+        if (TryRead(ring, data, size, output)) { return true; }
+    }
+
+    while (true) {
+        const auto seen = ring.written_.load();
+        ring.consumer_waiting_.store(1);
+
+        if (TryRead(ring, data, size, output)) {
+            ring.consumer_waiting_.store(0);
+
+            return true;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+
+        if (now >= deadline) {
+            ring.consumer_waiting_.store(0);
+
+            return false;
+        }
+
+        Wait(
+            ring.written_,
+            seen,
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - now) +
+                std::chrono::milliseconds(1));
+        ring.consumer_waiting_.store(0);
+    }
+}
+
+void ResetRing(Ring& ring)
+{
+    ring.head_.store(0);
+    ring.tail_.store(0);
+}
+
+bool TryRead(
+    Ring& ring,
+    const char* data,
+    const std::uint32_t size,
+    Frames& output)
+{
+    const auto tail = ring.tail_.load(std::memory_order_relaxed);
+    const auto head = ring.head_.load(std::memory_order_acquire);
+
+    if (head == tail) { return false; }
+
+    // The other side can write anything, so sizes are checked before use. A
+    // malformed message discards everything queued.
+    if ((head - tail) > size) {
+        ring.tail_.store(head, std::memory_order_release);
+        ++ring.read_;
+
+        if (1 == ring.producer_waiting_.load()) { Wake(ring.read_); }
+
+        return false;
+    }
+
+    std::uint32_t bytes{0};
+    std::uint32_t count{0};
+    copy_out(data, size, tail, &bytes, sizeof(bytes));
+    copy_out(data, size, tail + sizeof(bytes), &count, sizeof(count));
+    const auto end = tail + bytes;
+    auto position = tail + (2 * sizeof(std::uint32_t));
+    bool valid = (bytes <= size) && (position <= end) && (end <= head) &&
+                 (count <= ((bytes - 2 * sizeof(std::uint32_t)) /
+                            sizeof(std::uint32_t)));
+    output.clear();
+
+    if (valid) { output.reserve(count); }
+
+    for (std::uint32_t i{0}; valid && (i < count); ++i) {
+        std::uint32_t frame{0};
+
+        if ((position + sizeof(frame)) > end) {
+            valid = false;
+
+            break;
+        }
+
+        copy_out(data, size, position, &frame, sizeof(frame));
+        position += sizeof(frame);
+
+        if ((position + frame) > end) {
+            valid = false;
+
+            break;
+        }
+
+        std::string value(frame, '\0');
+        copy_out(data, size, position, value.data(), frame);
+        position += frame;
+        output.emplace_back(std::move(value));
+    }
+
+    ring.tail_.store(valid ? end : head, std::memory_order_release);
+    ++ring.read_;
+
+    if (1 == ring.producer_waiting_.load()) { Wake(ring.read_); }
+
+    return valid;
+}
+
+void Wait(
+    std::atomic<std::uint32_t>& word,
+    const std::uint32_t expected,
+    const std::chrono::milliseconds timeout)
+{
+    const auto seconds =
+        std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    struct timespec wait {
+    };
+    wait.tv_sec = static_cast<time_t>(seconds.count());
+    wait.tv_nsec = static_cast<long>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(timeout - seconds)
+            .count());
+    // Not FUTEX_PRIVATE_FLAG since the word is shared between processes
+    ::syscall(
+        SYS_futex,
+        reinterpret_cast<std::uint32_t*>(&word),
+        FUTEX_WAIT,
+        expected,
+        &wait,
+        nullptr,
+        0);
+}
+
+void Wake(std::atomic<std::uint32_t>& word)
+{
+    ::syscall(
+        SYS_futex,
+        reinterpret_cast<std::uint32_t*>(&word),
+        FUTEX_WAKE,
+        1,
+        nullptr,
+        nullptr,
+        0);
+}
+
+bool Write(
+    Ring& ring,
+    char* data,
+    const std::uint32_t size,
+    const Frames& message,
+    const std::chrono::milliseconds timeout,
+    const std::atomic<std::uint32_t>* generation,
+    const std::uint32_t expected)
+{
+    const auto bytes = encoded_size(message);
+
+    if (bytes > size) { return false; }
+
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    const auto head = ring.head_.load(std::memory_order_relaxed);
+
+    while (true) {
+        const auto seen = ring.read_.load();
+        const auto tail = ring.tail_.load(std::memory_order_acquire);
+
+        if ((nullptr != generation) && (expected != generation->load())) {
+            return false;
+        }
+
+        if ((size - (head - tail)) >= bytes) { break; }
+
+        const auto now = std::chrono::steady_clock::now();
+
+        if (now >= deadline) { return false; }
+
+        ring.producer_waiting_.store(1);
+
+        if (ring.tail_.load() == tail) {
+            Wait(
+                ring.read_,
+                seen,
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - now) +
+                    std::chrono::milliseconds(1));
+        }
+
+        ring.producer_waiting_.store(0);
+    }
+
+    const auto total = static_cast<std::uint32_t>(bytes);
+    const auto count = static_cast<std::uint32_t>(message.size());
+    auto position = head;
+    copy_in(data, size, position, &total, sizeof(total));
+    position += sizeof(total);
+    copy_in(data, size, position, &count, sizeof(count));
+    position += sizeof(count);
+
+    for (const auto& frame : message) {
+        const auto length = static_cast<std::uint32_t>(frame.size());
+        copy_in(data, size, position, &length, sizeof(length));
+        position += sizeof(length);
+        copy_in(data, size, position, frame.data(), frame.size());
+        position += frame.size();
+    }
+
+    if ((nullptr != generation) && (expected != generation->load())) {
+        return false;
+    }
+
+    ring.head_.store(head + bytes, std::memory_order_release);
+    ++ring.written_;
+
+    if (1 == ring.consumer_waiting_.load()) { Wake(ring.written_); }
+
+    return true;
+}
+}  // namespace opentxs::agent::shm
@@ -0,0 +1,144 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef SHMRING_HPP_
+#define SHMRING_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Shared memory transport between the agent and clients on the same host.
+//
+// The segment holds a fixed number of channels. A client claims a free
+// channel and gets a request ring it writes and a response ring the agent
+// writes. Each ring is single producer, single consumer. Messages keep the
+// multipart framing used on the zmq sockets: a request is the command frame
+// followed by any option frames, and a push starts with a PUSH frame.
+//
+// Everything in the segment is accessed from several processes, so it only
+// holds fixed size types and address free lock free atomics. Blocked readers
+// sleep on futexes in the segment.
+namespace opentxs::agent::shm
+{
+using Frames = std::vector<std::string>;
+
+static const std::uint32_t Magic{0x6f746167};
+static const std::uint32_t Version{2};
+
+struct Ring {
+    // Total bytes written and read. The difference is the fill level.
+    std::atomic<std::uint64_t> head_;
+    std::atomic<std::uint64_t> tail_;
+    // Futex words, incremented after each write and each read
+    std::atomic<std::uint32_t> written_;
+    std::atomic<std::uint32_t> read_;
+    // Set while the consumer or producer is asleep so the other side only
+    // makes a wake call when it is needed
+    std::atomic<std::uint32_t> consumer_waiting_;
+    std::atomic<std::uint32_t> producer_waiting_;
+};
+
+struct Channel {
+    // pid of the client using the channel, or zero if it is free
+    std::atomic<std::uint32_t> owner_;
+    // Incremented each time the channel is claimed so pushes meant for an
+    // earlier client are not delivered to a later one
+    std::atomic<std::uint32_t> generation_;
+    // Set by the agent while it writes a response, so a client claiming the
+    // channel waits for the write to finish before resetting the rings
+    std::atomic<std::uint32_t> writing_;
+    Ring request_;
+    Ring response_;
+};
+
+// Aligned so the channels following it keep their 64 bit atomics aligned
+struct alignas(std::atomic<std::uint64_t>) Header {
+    // Written last when the agent creates the segment
+    std::atomic<std::uint32_t> magic_;
+    std::uint32_t version_;
+    std::uint32_t channels_;
+    // Bytes of data in each ring, a power of two
+    std::uint32_t ring_size_;
+    std::atomic<std::uint32_t> running_;
+    // Futex word the agent sleeps on, incremented after each request
+    std::atomic<std::uint32_t> doorbell_;
+    std::atomic<std::uint32_t> server_waiting_;
+};
+
+// A mapping of the segment
+class Segment
+{
+public:
+    // Used by the agent. Replaces any segment left by an earlier run.
+    static std::unique_ptr<Segment> Create(
+        const std::string& name,
+        const std::uint32_t channels,
+        const std::uint32_t ringSize);
+    // Segment name used by default, derived from the uid like the ipc socket
+    static std::string DefaultName();
+    // Used by clients. Returns nothing if there is no usable segment.
+    static std::unique_ptr<Segment> Open(const std::string& name);
+
+    Channel& channel(const std::uint32_t index) const;
+    Header& header() const { return *header_; }
+    char* request_data(const std::uint32_t index) const;
+    char* response_data(const std::uint32_t index) const;
+
+    ~Segment();
+
+private:
+    const std::string name_;
+    const bool owner_;
+    void* address_;
+    const std::size_t size_;
+    Header* header_;
+
+    static std::size_t data_offset(const std::uint32_t channels);
+
+    Segment(
+        const std::string& name,
+        const bool owner,
+        void* address,
+        const std::size_t size);
+    Segment() = delete;
+    Segment(const Segment&) = delete;
+    Segment(Segment&&) = delete;
+    Segment& operator=(const Segment&) = delete;
+    Segment& operator=(Segment&&) = delete;
+};
+
+// Removes and decodes the next message if there is one
+bool TryRead(Ring& ring, const char* data, const std::uint32_t size, Frames&);
+// Waits up to timeout for the next message
+bool Read(
+    Ring& ring,
+    const char* data,
+    const std::uint32_t size,
+    Frames& output,
+    const std::chrono::milliseconds timeout);
+void ResetRing(Ring& ring);
+// Sleeps while word still holds expected, for at most timeout
+void Wait(
+    std::atomic<std::uint32_t>& word,
+    const std::uint32_t expected,
+    const std::chrono::milliseconds timeout);
+void Wake(std::atomic<std::uint32_t>& word);
+// Waits up to timeout for space. Returns false on timeout or if the message
+// could never fit. If generation is given the message is only published while
+// it still holds expected.
+bool Write(
+    Ring& ring,
+    char* data,
+    const std::uint32_t size,
+    const Frames& message,
+    const std::chrono::milliseconds timeout,
+    const std::atomic<std::uint32_t>* generation,
+    const std::uint32_t expected);
+}  // namespace opentxs::agent::shm
+#endif  // SHMRING_HPP_
@@ -0,0 +1,389 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "Soak.hpp"
+
+#include <malloc.h>
+#include <unistd.h>
+#include <zmq.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <future>
+#include <iomanip>
+
+#define OPTION_IDEMPOTENCY_KEY "IDEMPOTENCY_KEY"
+#define SOAK_ACCOUNT_PREFIX "soak-account-"
+#define SOAK_NYM_PREFIX "soak-nym-"
+#define SUBSCRIBE_FRAME "SUBSCRIBE"
+
+namespace fs = boost::filesystem;
+
+namespace opentxs::agent::soak
+{
+Soak::Soak(const api::Native& ot, const Settings& settings)
+    : settings_(settings)
+    , directory_(fs::temp_directory_path() / fs::unique_path())
+    , socket_path_("ipc://" + (directory_ / "agent.sock").string())
+    , settings_path_((directory_ / "otagent.ini").string())
+    , endpoints_({"ipc://" + (directory_ / "curve.sock").string()})
+    , config_()
+    , agent_()
+    , series_({
+          {"resident_kb", "", 8192, {}},
+          {"heap_kb", "", 8192, {}},
+          {"tasks", "registry.tasks", 64, {}},
+          {"nyms", "registry.nyms", 0, {}},
+          {"connections", "registry.interned_connections", 64, {}},
+          {"interned_nyms", "registry.interned_nyms", 0, {}},
+          {"buffered_pushes", "push_buffer.buffered", 64, {}},
+          {"idempotency_keys", "idempotency.size", 64, {}},
+          {"account_owners", "account_owner_cache.size", 0, {}},
+          {"subscriptions", "subscriptions.subscriptions", 64, {}},
+      })
+    , running_(false)
+    , connections_(0)
+    , connect_failures_(0)
+    , replies_(0)
+    , rejected_(0)
+    , timeouts_(0)
+    , pushes_(0)
+    , subscribed_(0)
+    , clients_()
+{
+    fs::create_directories(directory_);
+    const auto ttl = settings_.ttl_.count();
+    config_.put("otagent.executor", "synthetic");
+    config_.put("otagent.synthetic-task-delay", settings_.task_delay_.count());
+    config_.put("otagent.synthetic-task-failure", settings_.task_failure_);
+    config_.put("otagent.synthetic-task-lost", settings_.task_lost_);
+    config_.put("otagent.task-ttl", ttl);
+    config_.put("otagent.push-buffer-age", ttl);
+    config_.put("otagent.idempotency-ttl", ttl);
+    config_.put("otagent.subscription-ttl", ttl);
+    // The clients connect to the ipc socket without CURVE
+    config_.put("otagent.ipc-auth", "peer");
+    const auto serverKeys = network::zeromq::CurveClient::RandomKeypair();
+    const auto clientKeys = network::zeromq::CurveClient::RandomKeypair();
+    agent_ = std::make_unique<Agent>(
+        ot,
+        0,
+        0,
+        socket_path_,
+        endpoints_,
+        serverKeys.first,
+        serverKeys.second,
+        clientKeys.first,
+        clientKeys.second,
+        settings_path_,
+        config_);
+
+    while (false == agent_->Ready()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+bool Soak::check(std::ostream& report) const
+{
+    const auto samples = series_.front().values_.size();
+    const auto skip = static_cast<std::size_t>(
+        std::ceil(static_cast<double>(samples) * settings_.warmup_));
+    const auto measured = (samples > skip) ? samples - skip : 0;
+    report << "\nconnections " << connections_.load() << ", replies "
+           << replies_.load() << ", rejected " << rejected_.load()
+           << ", timeouts " << timeouts_.load() << ", pushes "
+           << pushes_.load() << ", subscriptions " << subscribed_.load()
+           << ", connect failures " << connect_failures_.load() << "\n";
+
+    if (0 == replies_.load()) {
+        report << "FAIL: the agent never replied\n";
+
+        return false;
+    }
+
+    if (4 > measured) {
+        report << "FAIL: " << measured
+               << " samples after warmup, at least 4 are needed\n";
+
+        return false;
+    }
+
+    const auto half = skip + measured / 2;
+    bool output{true};
+    report << "\n"
+           << std::setw(18) << std::left << "series" << std::right
+           << std::setw(12) << "first half" << std::setw(12) << "second half"
+           << std::setw(12) << "limit"
+           << "\n";
+
+    for (const auto& series : series_) {
+        const auto& values = series.values_;
+        const auto first =
+            *std::max_element(values.begin() + skip, values.begin() + half);
+        const auto second =
+            *std::max_element(values.begin() + half, values.end());
+        const auto limit =
+            first +
+            static_cast<std::int64_t>(
+                static_cast<double>(first) * settings_.tolerance_) +
+            series.slack_;
+        const bool growing = (second > limit);
+        report << std::setw(18) << std::left << series.name_ << std::right
+               << std::setw(12) << first << std::setw(12) << second
+               << std::setw(12) << limit << (growing ? "  GROWING" : "")
+               << "\n";
+
+        if (growing) { output = false; }
+    }
+
+    report << "\n" << (output ? "PASS" : "FAIL: unbounded growth") << "\n";
+
+    return output;
+}
+
+void Soak::client(const std::size_t index)
+{
+    std::mt19937_64 random{index};
+    AgentClient::Settings settings{};
+    settings.endpoint_ = socket_path_;
+    settings.connections_ = 1;
+    settings.timeout_ = std::chrono::seconds(10);
+    std::uint64_t sent{0};
+
+    while (running_.load()) {
+        auto client = AgentClient::Connect(settings);
+
+        if (false == bool(client)) {
+            ++connect_failures_;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            continue;
+        }
+
+        ++connections_;
+        client->OnPush(
+            proto::RPCPUSH_TASK, [this](const proto::RPCPush&) { ++pushes_; });
+        std::vector<std::future<AgentClient::Reply>> replies{};
+        replies.reserve(settings_.batch_);
+
+        for (std::size_t i{0}; i < settings_.batch_; ++i) {
+            const auto request = command(random);
+            AgentClient::Options options{};
+
+            // Every payment is kept by the idempotency cache
+            if (proto::RPCCOMMAND_SENDPAYMENT == request.type()) {
+                options.emplace_back(
+                    OPTION_IDEMPOTENCY_KEY,
+                    std::to_string(index) + "-" + std::to_string(++sent));
+            }
+
+            replies.emplace_back(client->Send(request, options));
+        }
+
+        for (auto& future : replies) {
+            const auto reply = future.get();
+
+            if (false == reply.received_) {
+                ++timeouts_;
+            } else if (false == reply.reason_.empty()) {
+                ++rejected_;
+            } else {
+                ++replies_;
+            }
+        }
+
+        // Disconnects while tasks from the batch are still running, so their
+        // pushes are addressed to a connection which has gone away
+    }
+}
+
+proto::RPCCommand Soak::command(std::mt19937_64& random) const
+{
+    const auto nym = std::to_string(random() % settings_.nyms_);
+    proto::RPCCommand output{};
+    output.set_version(1);
+    output.set_session(0);
+
+    switch (random() % 4) {
+        case 0:
+        case 1: {
+            output.set_type(proto::RPCCOMMAND_SENDPAYMENT);
+            auto& payment = *output.mutable_sendpayment();
+            payment.set_version(1);
+            payment.set_sourceaccount(SOAK_ACCOUNT_PREFIX + nym);
+        } break;
+        case 2: {
+            output.set_type(proto::RPCCOMMAND_GETACCOUNTBALANCE);
+            output.add_identifier(SOAK_ACCOUNT_PREFIX + nym);
+        } break;
+        default: {
+            output.set_type(proto::RPCCOMMAND_LISTNYMS);
+            output.add_associatenym(SOAK_NYM_PREFIX + nym);
+        }
+    }
+
+    return output;
+}
+
+int Soak::width(const Series& series)
+{
+    return std::max(10, static_cast<int>(series.name_.size()));
+}
+
+std::int64_t Soak::heap_kb()
+{
+#if defined(__GLIBC__) && \
+    ((2 < __GLIBC__) || ((2 == __GLIBC__) && (33 <= __GLIBC_MINOR__)))
+    const auto info = ::mallinfo2();
+
+    return static_cast<std::int64_t>((info.uordblks + info.hblkhd) / 1024);
+#else
+    return 0;
+#endif
+}
+
+std::int64_t Soak::resident_kb()
+{
+    std::ifstream statm("/proc/self/statm");
+    std::int64_t size{0};
+    std::int64_t resident{0};
+
+    if (false == bool(statm >> size >> resident)) { return 0; }
+
+    return resident * ::sysconf(_SC_PAGESIZE) / 1024;
+}
+
+bool Soak::Run(std::ostream& report)
+{
+    report << std::setw(8) << "seconds";
+
+    for (const auto& series : series_) {
+        report << " " << std::setw(width(series))
+               << series.name_;
+    }
+
+    report << std::endl;
+    running_.store(true);
+
+    for (std::size_t i{0}; i < settings_.clients_; ++i) {
+        clients_.emplace_back(&Soak::client, this, i);
+    }
+
+    for (std::size_t i{0}; i < settings_.subscribers_; ++i) {
+        clients_.emplace_back(&Soak::subscriber, this, i);
+    }
+
+    const auto start = Clock::now();
+    const auto end = start + settings_.duration_;
+    auto next = start + settings_.sample_interval_;
+
+    while (next <= end) {
+        std::this_thread::sleep_until(next);
+        sample(report, Clock::now() - start);
+        next += settings_.sample_interval_;
+    }
+
+    running_.store(false);
+
+    for (auto& thread : clients_) {
+        if (thread.joinable()) { thread.join(); }
+    }
+
+    return check(report);
+}
+
+void Soak::sample(std::ostream& report, const Clock::duration elapsed)
+{
+    boost::property_tree::ptree metrics{};
+    agent_->Metrics(metrics);
+    report << std::setw(8)
+           << std::chrono::duration_cast<std::chrono::seconds>(elapsed)
+                  .count();
+
+    for (auto& series : series_) {
+        std::int64_t value{0};
+
+        if ("resident_kb" == series.name_) {
+            value = resident_kb();
+        } else if ("heap_kb" == series.name_) {
+            value = heap_kb();
+        } else {
+            value = metrics.get<std::int64_t>(series.path_, 0);
+        }
+
+        series.values_.push_back(value);
+        report << " " << std::setw(width(series))
+               << value;
+    }
+
+    report << std::endl;
+}
+
+void Soak::subscriber(const std::size_t index)
+{
+    // AgentClient has no subscription support, so this speaks the SUBSCRIBE
+    // framing on a plain socket
+    std::mt19937_64 random{settings_.clients_ + index};
+    auto* context = zmq_ctx_new();
+    const int linger{0};
+    const int timeout{10000};
+    std::uint64_t sent{0};
+
+    while (running_.load()) {
+        auto* socket = zmq_socket(context, ZMQ_DEALER);
+        zmq_setsockopt(socket, ZMQ_LINGER, &linger, sizeof(linger));
+        zmq_setsockopt(socket, ZMQ_RCVTIMEO, &timeout, sizeof(timeout));
+
+        if (0 != zmq_connect(socket, socket_path_.c_str())) {
+            ++connect_failures_;
+            zmq_close(socket);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            continue;
+        }
+
+        proto::RPCCommand request{};
+        request.set_version(1);
+        request.set_cookie(
+            "soak-subscription-" + std::to_string(index) + "-" +
+            std::to_string(++sent));
+        request.set_session(0);
+        request.set_type(proto::RPCCOMMAND_GETACCOUNTBALANCE);
+        request.add_identifier(
+            SOAK_ACCOUNT_PREFIX + std::to_string(random() % settings_.nyms_));
+        const std::string subscribe{SUBSCRIBE_FRAME};
+        const auto serialized = request.SerializeAsString();
+        zmq_send(socket, nullptr, 0, ZMQ_SNDMORE);
+        zmq_send(socket, subscribe.data(), subscribe.size(), ZMQ_SNDMORE);
+        zmq_send(socket, serialized.data(), serialized.size(), 0);
+        zmq_msg_t frame{};
+        zmq_msg_init(&frame);
+
+        // Only waits for the start of the reply, which shows the request
+        // was handled
+        if (0 <= zmq_msg_recv(&frame, socket, 0)) { ++subscribed_; }
+
+        zmq_msg_close(&frame);
+        // Leaves without unsubscribing
+        zmq_close(socket);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    zmq_ctx_term(context);
+}
+
+Soak::~Soak()
+{
+    running_.store(false);
+
+    for (auto& thread : clients_) {
+        if (thread.joinable()) { thread.join(); }
+    }
+
+    agent_.reset();
+    fs::remove_all(directory_);
+}
+}  // namespace opentxs::agent::soak
@@ -0,0 +1,127 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef SOAK_HPP_
+#define SOAK_HPP_
+
+#include "opentxs/opentxs.hpp"
+
+#include "Agent.hpp"
+#include "AgentClient.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace opentxs::agent::soak
+{
+// Runs an in-process agent on the synthetic executor under churning load for
+// a long time and checks that its memory use levels off.
+//
+// Client threads repeatedly connect, send a batch of commands and disconnect
+// as soon as the replies arrive. Some of the commands queue tasks which
+// finish, fail or are lost, so task completion pushes are sent to
+// connections which have gone away and buffered for nyms which have none.
+// Subscriber threads subscribe and disconnect without unsubscribing.
+// Every expiring structure in the agent is given a short lifetime so it
+// reaches its steady size during warmup.
+//
+// Process memory and the agent's registry and buffer sizes are sampled
+// throughout. The run fails if any of them is higher in the second half of
+// the measured period than the first half allows for.
+class Soak
+{
+public:
+    struct Settings {
+        std::chrono::seconds duration_{300};
+        std::chrono::seconds sample_interval_{5};
+        // Fraction of the run not measured, while caches and buffers fill
+        double warmup_{0.25};
+        // Threads each connecting, sending a batch and disconnecting in turn
+        std::size_t clients_{8};
+        std::size_t batch_{32};
+        // Threads each subscribing on a new connection and abandoning it
+        std::size_t subscribers_{2};
+        // Distinct nyms and source accounts the commands refer to
+        std::size_t nyms_{256};
+        // Relative growth allowed between the halves of the measured period
+        double tolerance_{0.1};
+        // Percentage of synthetic tasks which fail or never finish
+        unsigned int task_failure_{10};
+        unsigned int task_lost_{10};
+        std::chrono::milliseconds task_delay_{20};
+        // Lifetime of lost tasks, undelivered pushes, idempotency keys and
+        // abandoned subscriptions
+        std::chrono::seconds ttl_{10};
+    };
+
+    Soak(const api::Native& ot, const Settings& settings);
+
+    // Returns false if anything kept growing
+    bool Run(std::ostream& report);
+
+    ~Soak();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // A sampled quantity and how much it may grow by beyond the tolerance
+    struct Series {
+        std::string name_{};
+        // Path in the agent's metrics, or empty for process memory
+        std::string path_{};
+        std::int64_t slack_{0};
+        std::vector<std::int64_t> values_{};
+    };
+
+    const Settings settings_;
+    const boost::filesystem::path directory_;
+    const std::string socket_path_;
+    const std::string settings_path_;
+    const std::vector<std::string> endpoints_;
+    boost::property_tree::ptree config_;
+    std::unique_ptr<Agent> agent_;
+    std::vector<Series> series_;
+    std::atomic<bool> running_;
+    std::atomic<std::uint64_t> connections_;
+    std::atomic<std::uint64_t> connect_failures_;
+    std::atomic<std::uint64_t> replies_;
+    std::atomic<std::uint64_t> rejected_;
+    std::atomic<std::uint64_t> timeouts_;
+    std::atomic<std::uint64_t> pushes_;
+    std::atomic<std::uint64_t> subscribed_;
+    std::vector<std::thread> clients_;
+
+    // Bytes the allocator has handed out and not had back, in KiB, or zero
+    // if the allocator doesn't say
+    static std::int64_t heap_kb();
+    static std::int64_t resident_kb();
+    // Report column width
+    static int width(const Series& series);
+
+    // Checks each series and writes the verdict
+    bool check(std::ostream& report) const;
+    void client(const std::size_t index);
+    proto::RPCCommand command(std::mt19937_64& random) const;
+    void sample(std::ostream& report, const Clock::duration elapsed);
+    void subscriber(const std::size_t index);
+
+    Soak() = delete;
+    Soak(const Soak&) = delete;
+    Soak(Soak&&) = delete;
+    Soak& operator=(const Soak&) = delete;
+    Soak& operator=(Soak&&) = delete;
+};
+}  // namespace opentxs::agent::soak
+#endif  // SOAK_HPP_
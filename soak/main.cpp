@@ -0,0 +1,126 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "opentxs/opentxs.hpp"
+
+#include <boost/program_options.hpp>
+
+#include <iostream>
+
+#include "Soak.hpp"
+
+#define OPTION_BATCH "batch"
+#define OPTION_CLIENTS "clients"
+#define OPTION_DURATION "duration"
+#define OPTION_HELP "help"
+#define OPTION_NYMS "nyms"
+#define OPTION_SAMPLE_INTERVAL "sample-interval"
+#define OPTION_SUBSCRIBERS "subscribers"
+#define OPTION_TASK_DELAY "task-delay"
+#define OPTION_TASK_FAILURE "task-failure"
+#define OPTION_TASK_LOST "task-lost"
+#define OPTION_TOLERANCE "tolerance"
+#define OPTION_TTL "ttl"
+#define OPTION_WARMUP "warmup"
+
+namespace po = boost::program_options;
+
+int main(int argc, char** argv)
+{
+    opentxs::agent::soak::Soak::Settings settings{};
+    std::int64_t duration{settings.duration_.count()};
+    std::int64_t interval{settings.sample_interval_.count()};
+    std::int64_t delay{settings.task_delay_.count()};
+    std::int64_t ttl{settings.ttl_.count()};
+    po::options_description options{"soak-otagent"};
+    options.add_options()(OPTION_HELP, "Show this message.")(
+        OPTION_DURATION,
+        po::value<std::int64_t>(&duration)->default_value(duration),
+        "Seconds to run for.")(
+        OPTION_SAMPLE_INTERVAL,
+        po::value<std::int64_t>(&interval)->default_value(interval),
+        "Seconds between samples.")(
+        OPTION_WARMUP,
+        po::value<double>(&settings.warmup_)->default_value(settings.warmup_),
+        "Fraction of the run before measuring starts.")(
+        OPTION_TOLERANCE,
+        po::value<double>(&settings.tolerance_)
+            ->default_value(settings.tolerance_),
+        "Relative growth allowed between the first and second half of the "
+        "measured period.")(
+        OPTION_CLIENTS,
+        po::value<std::size_t>(&settings.clients_)
+            ->default_value(settings.clients_),
+        "Threads connecting, sending a batch and disconnecting in turn.")(
+        OPTION_BATCH,
+        po::value<std::size_t>(&settings.batch_)
+            ->default_value(settings.batch_),
+        "Commands sent on each connection.")(
+        OPTION_SUBSCRIBERS,
+        po::value<std::size_t>(&settings.subscribers_)
+            ->default_value(settings.subscribers_),
+        "Threads subscribing on a connection and abandoning it in turn.")(
+        OPTION_NYMS,
+        po::value<std::size_t>(&settings.nyms_)->default_value(settings.nyms_),
+        "Distinct nyms the commands refer to.")(
+        OPTION_TASK_FAILURE,
+        po::value<unsigned int>(&settings.task_failure_)
+            ->default_value(settings.task_failure_),
+        "Percentage of tasks which fail.")(
+        OPTION_TASK_LOST,
+        po::value<unsigned int>(&settings.task_lost_)
+            ->default_value(settings.task_lost_),
+        "Percentage of tasks which never finish.")(
+        OPTION_TASK_DELAY,
+        po::value<std::int64_t>(&delay)->default_value(delay),
+        "Milliseconds before a task finishes.")(
+        OPTION_TTL,
+        po::value<std::int64_t>(&ttl)->default_value(ttl),
+        "Seconds the agent keeps lost tasks, undelivered pushes, idempotency "
+        "keys and abandoned subscriptions. Should be well inside the "
+        "warmup.");
+
+    try {
+        po::variables_map variables{};
+        po::store(po::parse_command_line(argc, argv, options), variables);
+
+        if (0 < variables.count(OPTION_HELP)) {
+            std::cout << options << std::endl;
+
+            return 0;
+        }
+
+        po::notify(variables);
+    } catch (po::error& e) {
+        std::cerr << "ERROR: " << e.what() << "\n\n" << options << std::endl;
+
+        return 1;
+    }
+
+    if ((0 == settings.nyms_) || (0 >= interval)) {
+        std::cerr << "ERROR: " << OPTION_NYMS << " and "
+                  << OPTION_SAMPLE_INTERVAL << " must be positive" << std::endl;
+
+        return 1;
+    }
+
+    settings.duration_ = std::chrono::seconds(duration);
+    settings.sample_interval_ = std::chrono::seconds(interval);
+    settings.task_delay_ = std::chrono::milliseconds(delay);
+    settings.ttl_ = std::chrono::seconds(ttl);
+    opentxs::ArgList args{{OPENTXS_ARG_STORAGE_PLUGIN, {"mem"}}};
+    const auto& ot = opentxs::OT::Start(args);
+    ot.StartClient(args, 0);
+    bool passed{false};
+
+    {
+        opentxs::agent::soak::Soak soak(ot, settings);
+        passed = soak.Run(std::cout);
+    }
+
+    opentxs::OT::Cleanup();
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "AccountOwnerCache.hpp"
+
+#include <mutex>
+
+namespace opentxs::agent
+{
+AccountOwnerCache::AccountOwnerCache(const std::size_t capacity)
+    : capacity_(capacity)
+    , lock_()
+    , map_()
+    , order_()
+    , hits_(0)
+    , misses_(0)
+    , evicted_(0)
+{
+}
+
+void AccountOwnerCache::Add(
+    const std::string& accountID,
+    const std::string& ownerID)
+{
+    if (accountID.empty() || ownerID.empty() || (0 == capacity_)) { return; }
+
+    std::unique_lock<std::shared_mutex> lock(lock_);
+    const auto [it, added] = map_.try_emplace(accountID);
+    it->second.owner_ = ownerID;
+
+    if (false == added) { return; }
+
+    it->second.position_ = order_.insert(order_.end(), accountID);
+
+    while (capacity_ < map_.size()) {
+        map_.erase(order_.front());
+        order_.pop_front();
+        ++evicted_;
+    }
+}
+
+std::string AccountOwnerCache::Get(
+    const std::string& accountID,
+    const Lookup& lookup)
+{
+    if (accountID.empty()) { return {}; }
+
+    {
+        std::shared_lock<std::shared_mutex> lock(lock_);
+        const auto it = map_.find(accountID);
+
+        if (map_.end() != it) {
+            ++hits_;
+
+            return it->second.owner_;
+        }
+    }
+
+    ++misses_;
+    // Storage lookup happens without holding the lock. Concurrent misses for
+    // the same account will both resolve and store the same value.
+    const auto output = lookup(accountID);
+    Add(accountID, output);
+
+    return output;
+}
+
+void AccountOwnerCache::Remove(const std::vector<std::string>& accountIDs)
+{
+    std::unique_lock<std::shared_mutex> lock(lock_);
+
+    for (const auto& id : accountIDs) {
+        const auto it = map_.find(id);
+
+        if (map_.end() == it) { continue; }
+
+        order_.erase(it->second.position_);
+        map_.erase(it);
+    }
+}
+
+std::size_t AccountOwnerCache::Size() const
+{
+    std::shared_lock<std::shared_mutex> lock(lock_);
+
+    return map_.size();
+}
+}  // namespace opentxs::agent
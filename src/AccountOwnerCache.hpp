@@ -0,0 +1,65 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef ACCOUNTOWNERCACHE_HPP_
+#define ACCOUNTOWNERCACHE_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+namespace opentxs::agent
+{
+// Maps account ids to owner nym ids so the payment paths in backend_handler
+// don't have to go to storage for every queued task
+class AccountOwnerCache
+{
+public:
+    // account id -> owner nym id, empty if the account is unknown
+    using Lookup = std::function<std::string(const std::string&)>;
+
+    // The accounts added longest ago are dropped once there are more than
+    // capacity. A capacity of zero disables caching.
+    explicit AccountOwnerCache(const std::size_t capacity);
+
+    void Add(const std::string& accountID, const std::string& ownerID);
+    std::uint64_t Evicted() const { return evicted_.load(); }
+    // Returns the cached owner, or calls lookup and caches a non-empty result
+    std::string Get(const std::string& accountID, const Lookup& lookup);
+    std::uint64_t Hits() const { return hits_.load(); }
+    std::uint64_t Misses() const { return misses_.load(); }
+    void Remove(const std::vector<std::string>& accountIDs);
+    std::size_t Size() const;
+
+    ~AccountOwnerCache() = default;
+
+private:
+    struct Entry {
+        std::string owner_{};
+        std::list<std::string>::iterator position_{};
+    };
+
+    const std::size_t capacity_;
+    mutable std::shared_mutex lock_;
+    std::map<std::string, Entry> map_;
+    // Account ids in the order they were added, oldest first
+    std::list<std::string> order_;
+    std::atomic<std::uint64_t> hits_;
+    std::atomic<std::uint64_t> misses_;
+    std::atomic<std::uint64_t> evicted_;
+
+    AccountOwnerCache() = delete;
+    AccountOwnerCache(const AccountOwnerCache&) = delete;
+    AccountOwnerCache(AccountOwnerCache&&) = delete;
+    AccountOwnerCache& operator=(const AccountOwnerCache&) = delete;
+    AccountOwnerCache& operator=(AccountOwnerCache&&) = delete;
+};
+}  // namespace opentxs::agent
+#endif  // ACCOUNTOWNERCACHE_HPP_
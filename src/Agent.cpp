@@ -5,31 +5,135 @@
 
 #include <boost/filesystem.hpp>
 #include <boost/property_tree/ini_parser.hpp>
+#include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
 
+#include <unistd.h>
+
 #include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <stdexcept>
 #include <thread>
+#include <tuple>
 
 #include "Agent.hpp"
+#include "NativeExecutor.hpp"
+#include "SyntheticExecutor.hpp"
+#include "Systemd.hpp"
 
 #define CONFIG_SECTION "otagent"
+#define CONFIG_RUNTIME_SECTION "otagent-runtime"
 #define CONFIG_CLIENTS "clients"
 #define CONFIG_SERVERS "servers"
+#define CONFIG_ACCOUNT_OWNER_CACHE_SIZE "account-owner-cache-size"
 #define CONFIG_SERVER_PRIVKEY "server_privkey"
 #define CONFIG_SERVER_PUBKEY "server_pubkey"
 #define CONFIG_CLIENT_PRIVKEY "client_privkey"
 #define CONFIG_CLIENT_PUBKEY "client_pubkey"
-#define RPCPUSH_VERSION 2
-#define TASKCOMPLETE_VERSION 1
+#define CONFIG_DISPATCH "dispatch"
+#define CONFIG_LOG_LEVEL "log-level"
+#define CONFIG_LOG_RATE "log-rate"
+#define CONFIG_DRAIN_TIMEOUT "drain-timeout"
+#define CONFIG_CONNECTION_WEIGHTS "connection-weights"
+#define CONFIG_DEFAULT_WEIGHT "default-weight"
+#define CONFIG_QUEUE_LIMIT "queue-limit"
+#define CONFIG_EXECUTOR "executor"
+#define CONFIG_FRONTEND_SHARDS "frontend-shards"
+#define CONFIG_CAPTURE "capture"
+#define CONFIG_CAPTURE_MAX_SIZE "capture-max-size"
+#define CONFIG_CAPTURE_REDACT "capture-redact"
+#define CONFIG_GC_INTERVAL "gc-interval"
+#define CONFIG_HEAVY_HITTERS "heavy-hitters"
+#define CONFIG_HEAVY_HITTERS_HALF_LIFE "heavy-hitters-half-life"
+#define CONFIG_GC_MAX_DELAY "gc-max-delay"
+#define CONFIG_GC_MAX_IN_FLIGHT "gc-max-in-flight"
+#define CONFIG_GC_MAX_REQUEST_RATE "gc-max-request-rate"
+#define CONFIG_SHM_CHANNELS "shm-channels"
+#define CONFIG_SHM_NAME "shm-name"
+#define CONFIG_SHM_RING_SIZE "shm-ring-size"
+#define CONFIG_SUBSCRIPTION_LIMIT "subscription-limit"
+#define CONFIG_SUBSCRIPTION_TOTAL "subscription-total"
+#define CONFIG_SUBSCRIPTION_TTL "subscription-ttl"
+#define CONFIG_IDEMPOTENCY_CAPACITY "idempotency-capacity"
+#define CONFIG_IDEMPOTENCY_TTL "idempotency-ttl"
+#define CONFIG_IPC_AUTH "ipc-auth"
+#define CONFIG_IPC_GROUPS "ipc-groups"
+#define CONFIG_IPC_USERS "ipc-users"
+#define CONFIG_PUSH_BUFFER_AGE "push-buffer-age"
+#define CONFIG_PUSH_BUFFER_SIZE "push-buffer-size"
+#define CONFIG_PUSH_BUFFER_TOTAL "push-buffer-total"
+#define CONFIG_SESSION_IDLE "session-idle"
+#define CONFIG_SYNTHETIC_LATENCY "synthetic-latency"
+#define CONFIG_SYNTHETIC_TASK_DELAY "synthetic-task-delay"
+#define CONFIG_SYNTHETIC_TASK_FAILURE "synthetic-task-failure"
+#define CONFIG_SYNTHETIC_TASK_LOST "synthetic-task-lost"
+#define CONFIG_TASK_TTL "task-ttl"
+#define CONFIG_WARMUP "warmup"
+#define DISPATCH_QUEUE "queue"
+#define EXECUTOR_SYNTHETIC "synthetic"
+#define HEAVY_HITTERS_REPORTED 10
+#define IPC_AUTH_PEER "peer"
+#define LOCAL_CONNECTION_PREFIX "\0local"
+#define LOCAL_CONNECTION_PREFIX_SIZE 6
+#define MAX_FRONTEND_SHARDS 64
+#define SHARD_CONNECTION_PREFIX "\0shard"
+#define SHARD_CONNECTION_PREFIX_SIZE 6
+#define TASK_EXPIRY_BATCH 1024
+// Seconds between scans for expired tasks and unreachable connections
+#define TASK_EXPIRY_INTERVAL 1
+#define RPCSTATUS_VERSION 1
+#define REJECT_DRAINING "DRAINING"
+#define REJECT_EXPIRED "EXPIRED"
+#define REJECT_IN_PROGRESS "IN_PROGRESS"
+#define REJECT_NOT_READY "NOT_READY"
+#define REJECT_QUEUE_FULL "QUEUE_FULL"
+#define ADMIN_FRAME "ADMIN"
+#define ADMIN_CAPTURE "CAPTURE"
+#define ADMIN_METRICS "METRICS"
+#define ADMIN_PROFILE "PROFILE"
+#define CAPTURE_START "START"
+#define CAPTURE_STATUS "STATUS"
+#define CAPTURE_STOP "STOP"
+#define PROFILE_DUMP "DUMP"
+#define PROFILE_RESET "RESET"
+#define PROFILE_START "START"
+#define PROFILE_STOP "STOP"
+#define SUBSCRIBE_FRAME "SUBSCRIBE"
+#define SUBSCRIBE_DISABLED "DISABLED"
+#define SUBSCRIBE_INVALID "INVALID"
+#define SUBSCRIBE_LIMIT "LIMIT"
+#define SUBSCRIBE_UNSUPPORTED "UNSUPPORTED"
+#define UNSUBSCRIBE_FRAME "UNSUBSCRIBE"
+#define UNSUBSCRIBE_OK "OK"
+#define UNSUBSCRIBE_UNKNOWN "UNKNOWN"
 
 namespace fs = boost::filesystem;
 
 #define ZAP_DOMAIN "otagent"
+#define LOCAL_ZAP_DOMAIN "otagent-local"
 
 #define OT_METHOD "opentxs::Agent::"
 
 namespace opentxs::agent
 {
+// Resident set size of the agent process in KiB, or zero if unknown
+static std::int64_t resident_kb()
+{
+    std::ifstream statm("/proc/self/statm");
+    std::int64_t size{0};
+    std::int64_t resident{0};
+
+    if (false == bool(statm >> size >> resident)) { return 0; }
+
+    return resident * ::sysconf(_SC_PAGESIZE) / 1024;
+}
+
 Agent::Agent(
     const api::Native& app,
     const std::int64_t clients,
@@ -42,15 +146,21 @@ Agent::Agent(
     const std::string& clientPublicKey,
     const std::string& settings_path,
     pt::ptree& config)
-    : ot_(app)
+    : log_(
+          static_cast<LogLevel>(config_value<int>(
+              config, CONFIG_LOG_LEVEL, static_cast<int>(LogLevel::Normal))),
+          config_value<std::uint32_t>(config, CONFIG_LOG_RATE, 100))
+    , ot_(app)
     , zmq_(app.ZMQ())
     , clients_(clients)
+    , dispatch_(dispatch_mode(config))
+    , executor_(executor_factory(app, config))
     , internal_callback_(zmq::ListenCallback::Factory(
           std::bind(&Agent::internal_handler, this, std::placeholders::_1)))
     , internal_(zmq_.DealerSocket(
           internal_callback_,
           zmq::Socket::Direction::Connect))
-    , backend_endpoints_(backend_endpoint_generator())
+    , backend_endpoints_(backend_endpoint_generator(dispatch_))
     , backend_callback_(zmq::ReplyCallback::Factory(
           std::bind(&Agent::backend_handler, this, std::placeholders::_1)))
     , backends_(
@@ -60,6 +170,14 @@ Agent::Agent(
           std::bind(&Agent::frontend_handler, this, std::placeholders::_1)))
     , frontend_(
           zmq_.RouterSocket(frontend_callback_, zmq::Socket::Direction::Bind))
+    , shard_callbacks_()
+    , shards_()
+    , local_auth_(
+          IPC_AUTH_PEER ==
+          config_value<std::string>(config, CONFIG_IPC_AUTH, std::string{}))
+    , local_callback_(zmq::ListenCallback::Factory(
+          std::bind(&Agent::local_handler, this, std::placeholders::_1)))
+    , local_(zmq_.RouterSocket(local_callback_, zmq::Socket::Direction::Bind))
     , servers_(servers)
     , settings_path_(settings_path)
     , socket_path_(socket_path)
@@ -69,16 +187,84 @@ Agent::Agent(
     , server_pubkey_(serverPublicKey)
     , client_privkey_(clientPrivateKey)
     , client_pubkey_(clientPublicKey)
-    , task_lock_()
+    , authenticator_(
+          app,
+          client_pubkey_,
+          id_list(config, CONFIG_IPC_USERS, std::to_string(::getuid())),
+          id_list(config, CONFIG_IPC_GROUPS, std::string{}))
+    , connections_()
+    , nyms_()
     , task_connection_map_()
-    , nym_lock_()
     , nym_connection_map_()
+    , task_ttl_(std::chrono::seconds(
+          config_value<std::int64_t>(config, CONFIG_TASK_TTL, 86400)))
+    , expired_tasks_(0)
+    , unreachable_nyms_(0)
+    , task_expiry_lock_()
+    , task_expiry_cv_()
+    , task_expiry_running_(true)
+    , account_owners_(config_value<std::size_t>(
+          config, CONFIG_ACCOUNT_OWNER_CACHE_SIZE, 100000))
+    , sessions_(std::chrono::seconds(
+          config_value<std::int64_t>(config, CONFIG_SESSION_IDLE, 0)))
+    , push_buffer_(
+          config_value<std::size_t>(config, CONFIG_PUSH_BUFFER_SIZE, 100),
+          config_value<std::size_t>(config, CONFIG_PUSH_BUFFER_TOTAL, 10000),
+          std::chrono::seconds(config_value<std::int64_t>(
+              config, CONFIG_PUSH_BUFFER_AGE, 300)))
+    , push_lock_()
+    , idempotency_(
+          std::chrono::seconds(config_value<std::int64_t>(
+              config, CONFIG_IDEMPOTENCY_TTL, 600)),
+          config_value<std::size_t>(config, CONFIG_IDEMPOTENCY_CAPACITY, 10000))
+    , in_progress_(0)
+    , work_queue_(
+          config_value<std::uint32_t>(config, CONFIG_DEFAULT_WEIGHT, 1),
+          connection_weights(config),
+          config_value<std::size_t>(config, CONFIG_QUEUE_LIMIT, 10000))
+    , workers_()
+    , requests_(0)
+    , dispatch_time_(0)
+    , service_time_(0)
+    , draining_(false)
+    , in_flight_(0)
+    , expired_(0)
+    , top_nyms_(
+          config_value<std::size_t>(config, CONFIG_HEAVY_HITTERS, 64),
+          std::chrono::seconds(config_value<std::int64_t>(
+              config, CONFIG_HEAVY_HITTERS_HALF_LIFE, 60)))
+    , top_connections_(
+          config_value<std::size_t>(config, CONFIG_HEAVY_HITTERS, 64),
+          std::chrono::seconds(config_value<std::int64_t>(
+              config, CONFIG_HEAVY_HITTERS_HALF_LIFE, 60)))
+    , top_commands_(
+          config_value<std::size_t>(config, CONFIG_HEAVY_HITTERS, 64),
+          std::chrono::seconds(config_value<std::int64_t>(
+              config, CONFIG_HEAVY_HITTERS_HALF_LIFE, 60)))
+    , profiler_()
+    , capture_lock_()
+    , capture_()
+    , capturing_(false)
+    , ready_(false)
+    , warmup_time_(0)
+    , preloaded_accounts_(0)
+    , drain_timeout_(
+          config_value<std::int64_t>(config, CONFIG_DRAIN_TIMEOUT, 10))
     , push_callback_(zmq::ListenCallback::Factory(
           std::bind(&Agent::push_handler, this, std::placeholders::_1)))
     , task_callback_(zmq::ListenCallback::Factory(
           std::bind(&Agent::task_handler, this, std::placeholders::_1)))
     , push_subscriber_(zmq_.SubscribeSocket(push_callback_))
     , task_subscriber_(zmq_.SubscribeSocket(task_callback_))
+    , task_endpoint_lock_()
+    , task_endpoints_()
+    , shm_()
+    , gc_()
+    , subscriptions_()
+    , warmup_()
+    , wake_lock_()
+    , wakes_()
+    , task_expiry_()
 {
     {
         Lock lock(config_lock_);
@@ -106,14 +292,25 @@ Agent::Agent(
         ot_.StartClient(ArgList(), i);
     }
 
-    OT_ASSERT(0 < backend_endpoints_.size());
-
     auto started{false};
 
-    for (const auto& endpoint : backend_endpoints_) {
-        started = internal_->Start(endpoint);
+    if (Dispatch::Queue == dispatch_) {
+        const auto threads = worker_count();
+        LogNormal(OT_METHOD)(__FUNCTION__)(": Starting ")(threads)(
+            " worker threads.")
+            .Flush();
+
+        for (unsigned int i{0}; i < threads; ++i) {
+            workers_.emplace_back(&Agent::worker, this);
+        }
+    } else {
+        OT_ASSERT(0 < backend_endpoints_.size());
 
-        OT_ASSERT(started);
+        for (const auto& endpoint : backend_endpoints_) {
+            started = internal_->Start(endpoint);
+
+            OT_ASSERT(started);
+        }
     }
 
     OT_ASSERT(false == socket_path_.empty());
@@ -132,7 +329,36 @@ Agent::Agent(
 
     OT_ASSERT(set);
 
-    started = frontend_->Start(socket_path_);
+    if (local_auth_) {
+        // Without CURVE keys the socket uses the NULL mechanism, and the ZAP
+        // request carries the connecting process's credentials instead
+        const auto local = ot_.ZAP().RegisterDomain(
+            LOCAL_ZAP_DOMAIN,
+            std::bind(&Agent::zap_handler, this, std::placeholders::_1));
+
+        OT_ASSERT(local);
+
+        const auto localDomain = local_->SetDomain(LOCAL_ZAP_DOMAIN);
+
+        OT_ASSERT(localDomain);
+
+        LogNormal(OT_METHOD)(__FUNCTION__)(
+            ": Authenticating local clients by peer credentials on ")(
+            socket_path_)
+            .Flush();
+    } else {
+        // CURVE, the same as the endpoints. The ipc socket still gets its own
+        // ROUTER so admin commands can tell local clients from remote ones.
+        const auto localDomain = local_->SetDomain(ZAP_DOMAIN);
+
+        OT_ASSERT(localDomain);
+
+        const bool localKey = local_->SetPrivateKey(server_privkey_);
+
+        OT_ASSERT(localKey);
+    }
+
+    started = local_->Start(socket_path_);
 
     OT_ASSERT(started);
 
@@ -142,37 +368,202 @@ Agent::Agent(
         OT_ASSERT(started);
     }
 
-    OT_ASSERT(0 <= clients_.load());
+    start_shards(std::clamp<std::size_t>(
+        config_value<std::size_t>(config_, CONFIG_FRONTEND_SHARDS, 1),
+        1,
+        MAX_FRONTEND_SHARDS));
 
-    for (int i = 1; i <= clients_.load(); ++i) {
-        started = task_subscriber_->Start(
-            ot_.Client(i - 1).Endpoints().TaskComplete());
+    OT_ASSERT(0 <= clients_.load());
 
-        OT_ASSERT(started);
+    subscribe_tasks(clients_.load());
 
-        schedule_refresh(i - 1);
-    }
+    for (int i = 1; i <= clients_.load(); ++i) { schedule_refresh(i - 1); }
 
     started =
         push_subscriber_->Start(ot_.ZMQ().BuildEndpoint("rpc/push", -1, 1));
 
     OT_ASSERT(started);
+
+    const auto capturePath =
+        config_value<std::string>(config_, CONFIG_CAPTURE, std::string{});
+
+    if (false == capturePath.empty()) { capture(CAPTURE_START); }
+
+    gc_ = gc_scheduler(config_);
+    const auto subscriptionLimit =
+        config_value<std::size_t>(config_, CONFIG_SUBSCRIPTION_LIMIT, 16);
+
+    if (0 < subscriptionLimit) {
+        subscriptions_ = std::make_unique<Subscriptions>(
+            subscriptionLimit,
+            config_value<std::size_t>(
+                config_, CONFIG_SUBSCRIPTION_TOTAL, 10000),
+            std::chrono::seconds(config_value<std::int64_t>(
+                config_, CONFIG_SUBSCRIPTION_TTL, 600)),
+            std::bind(
+                &Agent::run_subscription,
+                this,
+                std::placeholders::_1,
+                std::placeholders::_2,
+                std::placeholders::_3),
+            std::bind(
+                &Agent::send_subscription,
+                this,
+                std::placeholders::_1,
+                std::placeholders::_2,
+                std::placeholders::_3,
+                std::placeholders::_4,
+                std::placeholders::_5));
+    }
+
+    warmup_ = std::thread(
+        &Agent::warmup, this, config_value<bool>(config_, CONFIG_WARMUP, true));
+
+    if (0 < task_ttl_.count()) {
+        task_expiry_ = std::thread(&Agent::expire_tasks, this);
+    }
+
+    const auto shmChannels =
+        config_value<std::uint32_t>(config_, CONFIG_SHM_CHANNELS, 0);
+
+    if (0 < shmChannels) {
+        const auto name = config_value<std::string>(
+            config_, CONFIG_SHM_NAME, shm::Segment::DefaultName());
+        const auto ringSize =
+            config_value<std::uint32_t>(config_, CONFIG_SHM_RING_SIZE, 1024);
+        shm_ = ShmServer::Factory(
+            name,
+            shmChannels,
+            ringSize * 1024,
+            worker_count(),
+            std::bind(
+                &Agent::shm_handler,
+                this,
+                std::placeholders::_1,
+                std::placeholders::_2));
+
+        if (shm_) {
+            LogNormal(OT_METHOD)(__FUNCTION__)(
+                ": Accepting shared memory clients on ")(name)
+                .Flush();
+        } else {
+            LogOutput(OT_METHOD)(__FUNCTION__)(
+                ": Unable to create shared memory segment ")(name)(
+                ". The ring size must be a power of two.")
+                .Flush();
+        }
+    }
+}
+
+std::string Agent::account_owner(
+    const int clientIndex,
+    const std::string& accountID)
+{
+    return account_owners_.Get(
+        accountID, [this, clientIndex](const std::string& id) -> std::string {
+            return executor_->AccountOwner(clientIndex, id);
+        });
+}
+
+void Agent::admin_handler(const zmq::Message& message)
+{
+    auto reply = zmq::Message::ReplyFactory(message);
+    const std::string command =
+        (1 < message.Body().size()) ? std::string(message.Body_at(1)) : "";
+
+    // Admin commands can write files and read every client's requests, so
+    // they are limited to clients on the ipc socket. Remote clients share the
+    // same CURVE key, so the transport is what sets local clients apart.
+    if (false == is_local(message.Header_at(0))) {
+        LogOutput(OT_METHOD)(__FUNCTION__)(
+            ": Rejected admin command from a remote connection")
+            .Flush();
+        reply->AddFrame("Admin commands are only accepted on the ipc socket");
+        send_message(reply);
+
+        return;
+    }
+
+    if (ADMIN_CAPTURE == command) {
+        const std::string action = (2 < message.Body().size())
+                                       ? std::string(message.Body_at(2))
+                                       : CAPTURE_STATUS;
+
+        // The capture file is always the configured one
+        if (3 < message.Body().size()) {
+            reply->AddFrame("Capture path is set in the configuration");
+        } else {
+            reply->AddFrame(capture(action));
+        }
+    } else if (ADMIN_METRICS == command) {
+        pt::ptree metrics{};
+        collect_metrics(metrics);
+        std::stringstream json{};
+        pt::write_json(json, metrics);
+        reply->AddFrame(json.str());
+    } else if (ADMIN_PROFILE == command) {
+        const std::string action = (2 < message.Body().size())
+                                       ? std::string(message.Body_at(2))
+                                       : PROFILE_DUMP;
+        reply->AddFrame(profile(action));
+    } else {
+        LogOutput(OT_METHOD)(__FUNCTION__)(": Unknown admin command ")(
+            command)
+            .Flush();
+        reply->AddFrame("Unknown admin command");
+    }
+
+    send_message(reply);
+}
+
+std::string Agent::as_bytes(const Data& data)
+{
+    return std::string(static_cast<const char*>(data.data()), data.size());
+}
+
+OTData Agent::as_data(const std::string& bytes)
+{
+    return Data::Factory(bytes.data(), bytes.size());
 }
 
 void Agent::associate_nym(const Data& connection, const std::string& nymID)
 {
     if (nymID.empty()) { return; }
 
-    auto it = nym_connection_map_.find(nymID);
+    const auto nym = nyms_.Intern(nymID);
+    const auto id = connections_.Intern(as_bytes(connection));
 
-    if (nym_connection_map_.end() == it) {
-        Lock lock(task_lock_);
-        nym_connection_map_.emplace(nymID, connection);
-        lock.unlock();
-        LogOutput(OT_METHOD)(__FUNCTION__)(": Connection ")(connection.asHex())(
-            " is associated with nym ")(nymID)
-            .Flush();
+    const auto associated = [&]() {
+        const auto found = nym_connection_map_.Find(nym);
+
+        return found.has_value() && (found.value().first == id);
+    };
+
+    if (nym_connection_map_.Add(nym, {id, 0})) {
+        AGENT_LOG(log_, LogLevel::Output, [id = OTData{connection}, nymID]() {
+            return "Connection " + id->asHex() + " is associated with nym " +
+                   nymID;
+        });
+    } else if (push_buffer_.Contains(nymID) && (false == associated())) {
+        // Pushes to the nym's connection failed, so this is most likely the
+        // same client after a reconnect
+        const auto previous = nym_connection_map_.Set(nym, {id, 0});
+        nyms_.Release(nym);
+
+        if (previous.has_value()) {
+            connections_.Release(previous.value().first);
+        }
+
+        AGENT_LOG(log_, LogLevel::Output, [id = OTData{connection}, nymID]() {
+            return "Connection " + id->asHex() +
+                   " replaces the unreachable connection for nym " + nymID;
+        });
+    } else {
+        nyms_.Release(nym);
+        connections_.Release(id);
     }
+
+    flush_pushes(nymID);
 }
 
 void Agent::associate_task(
@@ -184,22 +575,60 @@ void Agent::associate_task(
     OT_ASSERT(false == nymID.empty());
     OT_ASSERT(false == task.empty());
 
-    LogOutput(OT_METHOD)(__FUNCTION__)(": Connection ")(connection.asHex())(
-        " is waiting for task ")(task)
-        .Flush();
-    Lock lock(task_lock_);
-    task_connection_map_.emplace(task, TaskData{connection, nymID});
+    AGENT_LOG(log_, LogLevel::Output, [id = OTData{connection}, task]() {
+        return "Connection " + id->asHex() + " is waiting for task " + task;
+    });
+    // Replaces any earlier association so a retried request moves the task
+    // to the connection that retried it
+    const TaskData data{
+        connections_.Intern(as_bytes(connection)), nyms_.Intern(nymID), now()};
+    const auto previous = task_connection_map_.Set(task, data);
+
+    if (previous.has_value()) { release_task(previous.value()); }
 }
 
-std::vector<std::string> Agent::backend_endpoint_generator()
+Agent::~Agent()
 {
-    const unsigned int min_threads{1};
-    const auto threads =
-        std::max(std::thread::hardware_concurrency(), min_threads);
+    if (warmup_.joinable()) { warmup_.join(); }
+
+    {
+        Lock lock(task_expiry_lock_);
+        task_expiry_running_ = false;
+    }
+
+    task_expiry_cv_.notify_all();
+
+    if (task_expiry_.joinable()) { task_expiry_.join(); }
+
+    {
+        Lock lock(wake_lock_);
+
+        for (auto& [index, wake] : wakes_) {
+            if (wake.valid()) { wake.wait(); }
+        }
+    }
+
+    subscriptions_.reset();
+    gc_.reset();
+    shm_.reset();
+    work_queue_.Shutdown();
+
+    for (auto& thread : workers_) {
+        if (thread.joinable()) { thread.join(); }
+    }
+}
+
+std::vector<std::string> Agent::backend_endpoint_generator(
+    const Dispatch dispatch)
+{
+    std::vector<std::string> output{};
+
+    if (Dispatch::Queue == dispatch) { return output; }
+
+    const auto threads = worker_count();
     LogNormal(OT_METHOD)(__FUNCTION__)(": Starting ")(threads)(
         " handler threads.")
         .Flush();
-    std::vector<std::string> output{};
     const auto prefix = std::string("inproc://opentxs/agent/backend/");
 
     for (unsigned int i{0}; i < threads; ++i) {
@@ -211,141 +640,258 @@ std::vector<std::string> Agent::backend_endpoint_generator()
 
 OTZMQMessage Agent::backend_handler(const zmq::Message& message)
 {
-    OT_ASSERT(1 < message.Body().size());
+    // [command][option name][option value]...[connection id][received]
+    const auto& body = message.Body();
+
+    OT_ASSERT(2 < body.size());
+
+    const auto start = now();
+    const auto& frame = body.at(body.size() - 1);
+    std::int64_t received{start};
+
+    if (sizeof(received) == frame.size()) {
+        std::memcpy(&received, frame.data(), sizeof(received));
+        dispatch_time_ += static_cast<std::uint64_t>(start - received);
+    }
+
+    const auto options = ParseOptions(body, 1, body.size() - 2);
+
+    // Don't spend time on a request the client has already given up on
+    const auto waited = std::chrono::nanoseconds(start - received);
+
+    if ((0 < options.timeout_.count()) && (waited > options.timeout_)) {
+        ++expired_;
+        AGENT_LOG(log_, LogLevel::Verbose, [waited]() {
+            return "Dropping request which waited " +
+                   std::to_string(
+                       std::chrono::duration_cast<std::chrono::milliseconds>(
+                           waited)
+                           .count()) +
+                   " ms";
+        });
 
-    const auto& request = message.Body().at(0);
+        // Not RETRY, since resending would only expire again
+        return rejection(message, REJECT_EXPIRED, proto::RPCRESPONSE_ERROR);
+    }
+
+    const auto& request = body.at(0);
     const auto data = Data::Factory(request.data(), request.size());
     const auto command =
         opentxs::proto::DataToProto<opentxs::proto::RPCCommand>(data);
-    const auto connectionID = Data::Factory(message.Body().at(1));
+    const auto connectionID = Data::Factory(body.at(body.size() - 2));
+    count_request(command, connectionID);
     for (auto nym : command.associatenym()) {
         associate_nym(connectionID, nym);
     }
-    auto response = ot_.RPC(command);
-    std::string taskNymID{};
+    proto::RPCResponse response{};
+    TaskOwners taskOwners{};
 
-    switch (response.type()) {
-        case proto::RPCCOMMAND_ADDCLIENTSESSION: {
-            if (0 < response.status_size() &&
-                proto::RPCRESPONSE_SUCCESS == response.status(0).code()) {
-                update_clients();
-            }
-        } break;
-        case proto::RPCCOMMAND_ADDSERVERSESSION: {
-            if (0 < response.status_size() &&
-                proto::RPCRESPONSE_SUCCESS == response.status(0).code()) {
-                update_servers();
-            }
-        } break;
-        case proto::RPCCOMMAND_CREATENYM: {
-            for (const auto& nymid : response.identifier()) {
-                associate_nym(connectionID, nymid);
-            }
-        } break;
-        case proto::RPCCOMMAND_REGISTERNYM:
-        case proto::RPCCOMMAND_ISSUEUNITDEFINITION:
-        case proto::RPCCOMMAND_CREATEACCOUNT:
-        case proto::RPCCOMMAND_CREATECOMPATIBLEACCOUNT: {
-            taskNymID = command.owner();
-        } break;
-        case proto::RPCCOMMAND_SENDPAYMENT: {
-            if (0 < response.status_size() &&
-                proto::RPCRESPONSE_QUEUED == response.status(0).code()) {
-                const auto accountID =
-                    Identifier::Factory(command.sendpayment().sourceaccount());
-                taskNymID =
-                    ot_.Client(session_to_client_index(command.session()))
-                        .Storage()
-                        .AccountOwner(accountID)
-                        ->str();
-            }
-        } break;
-        case proto::RPCCOMMAND_ACCEPTPENDINGPAYMENTS: {
-            if (0 < response.status_size() &&
-                proto::RPCRESPONSE_QUEUED == response.status(0).code()) {
-                const auto accountID = Identifier::Factory(
-                    command.acceptpendingpayment(0).destinationaccount());
-                taskNymID =
-                    ot_.Client(session_to_client_index(command.session()))
-                        .Storage()
-                        .AccountOwner(accountID)
-                        ->str();
+    if (options.idempotency_key_.empty()) {
+        response = execute(command, connectionID, taskOwners);
+    } else {
+        // Keys are scoped to the session, owner and command type, and a key
+        // reused for a different command is refused, so one client's key
+        // can't return another client's response
+        const auto key = std::to_string(command.session()) + ":" +
+                         command.owner() + ":" +
+                         std::to_string(static_cast<int>(command.type())) +
+                         ":" + options.idempotency_key_;
+        const auto claim = idempotency_.Start(key, fingerprint(command));
+
+        switch (claim.status_) {
+            case IdempotencyCache::Status::Replay: {
+                // Waiting for the original request would tie up a worker
+                // for each retry. Resending the key is safe since it can
+                // only ever replay.
+                if (std::future_status::ready !=
+                    claim.future_.wait_for(std::chrono::seconds(0))) {
+                    ++in_progress_;
+
+                    return rejection(
+                        message, REJECT_IN_PROGRESS, proto::RPCRESPONSE_RETRY);
+                }
+
+                try {
+                    std::tie(response, taskOwners) = claim.future_.get();
+                    AGENT_LOG(log_, LogLevel::Verbose, [key]() {
+                        return "Replaying response for idempotency key " + key;
+                    });
+                } catch (...) {
+                    // Nothing is known about what the original request did
+                    response =
+                        status_response(command, proto::RPCRESPONSE_ERROR);
+                    taskOwners.clear();
+                }
+            } break;
+            case IdempotencyCache::Status::Conflict: {
+                AGENT_LOG(log_, LogLevel::Normal, [key]() {
+                    return "Idempotency key " + key +
+                           " was already used for a different command";
+                });
+                response = status_response(command, proto::RPCRESPONSE_INVALID);
+            } break;
+            case IdempotencyCache::Status::Run:
+            default: {
+                try {
+                    response = execute(command, connectionID, taskOwners);
+                } catch (...) {
+                    idempotency_.Abandon(key, claim.id_);
+
+                    throw;
+                }
+
+                idempotency_.Finish(key, claim.id_, {response, taskOwners});
             }
-        } break;
-        case proto::RPCCOMMAND_LISTCLIENTSESSIONS:
-        case proto::RPCCOMMAND_LISTSERVERSESSIONS:
-        case proto::RPCCOMMAND_IMPORTHDSEED:
-        case proto::RPCCOMMAND_LISTHDSEEDS:
-        case proto::RPCCOMMAND_GETHDSEED:
-        case proto::RPCCOMMAND_LISTNYMS:
-        case proto::RPCCOMMAND_GETNYM:
-        case proto::RPCCOMMAND_ADDCLAIM:
-        case proto::RPCCOMMAND_DELETECLAIM:
-        case proto::RPCCOMMAND_IMPORTSERVERCONTRACT:
-        case proto::RPCCOMMAND_LISTSERVERCONTRACTS:
-        case proto::RPCCOMMAND_CREATEUNITDEFINITION:
-        case proto::RPCCOMMAND_LISTUNITDEFINITIONS:
-        case proto::RPCCOMMAND_LISTACCOUNTS:
-        case proto::RPCCOMMAND_GETACCOUNTBALANCE:
-        case proto::RPCCOMMAND_GETACCOUNTACTIVITY:
-        case proto::RPCCOMMAND_MOVEFUNDS:
-        case proto::RPCCOMMAND_ADDCONTACT:
-        case proto::RPCCOMMAND_LISTCONTACTS:
-        case proto::RPCCOMMAND_GETCONTACT:
-        case proto::RPCCOMMAND_ADDCONTACTCLAIM:
-        case proto::RPCCOMMAND_DELETECONTACTCLAIM:
-        case proto::RPCCOMMAND_VERIFYCLAIM:
-        case proto::RPCCOMMAND_ACCEPTVERIFICATION:
-        case proto::RPCCOMMAND_SENDCONTACTMESSAGE:
-        case proto::RPCCOMMAND_GETCONTACTACTIVITY:
-        case proto::RPCCOMMAND_GETSERVERCONTRACT:
-        case proto::RPCCOMMAND_GETPENDINGPAYMENTS:
-        case proto::RPCCOMMAND_GETCOMPATIBLEACCOUNTS:
-        case proto::RPCCOMMAND_GETWORKFLOW:
-        case proto::RPCCOMMAND_GETSERVERPASSWORD:
-        case proto::RPCCOMMAND_GETADMINNYM:
-        case proto::RPCCOMMAND_GETUNITDEFINITION:
-        case proto::RPCCOMMAND_GETTRANSACTIONDATA:
-        case proto::RPCCOMMAND_LOOKUPACCOUNTID:
-        case proto::RPCCOMMAND_RENAMEACCOUNT:
-        case proto::RPCCOMMAND_ERROR:
-        default: {
-        }
-    }
-
-    if (0 < response.status_size() &&
-        proto::RPCRESPONSE_QUEUED == response.status(0).code()) {
-
-        if (0 < response.task_size()) {
-            const auto& taskID = response.task(0).id();
-            associate_task(connectionID, taskNymID, taskID);
-            // It's possible for the task subscriber to miss a task
-            // complete message if the task finished quickly before
-            // we added the id to task_connection_map_
-            check_task(
-                connectionID,
-                taskID,
-                taskNymID,
-                session_to_client_index(command.session()));
         }
     }
 
+    register_tasks(command, response, connectionID, taskOwners);
     auto replymessage = zmq::Message::ReplyFactory(message);
     const auto replydata =
         opentxs::proto::ProtoAsData<opentxs::proto::RPCResponse>(response);
     replymessage->AddFrame(replydata);
+    service_time_ += static_cast<std::uint64_t>(now() - start);
+    ++requests_;
 
     return replymessage;
 }
 
+bool Agent::buffer_push(const std::string& nymID, const zmq::Message& push)
+{
+    const auto& payload = push.Body_at(push.Body().size() - 1);
+    const auto buffered = push_buffer_.Add(
+        nymID,
+        std::string(static_cast<const char*>(payload.data()), payload.size()));
+
+    if (buffered) {
+        AGENT_LOG(log_, LogLevel::Normal, [nymID]() {
+            return "Buffered undelivered push notification for " + nymID;
+        });
+    } else {
+        AGENT_LOG(log_, LogLevel::Output, []() {
+            return std::string("Push notification delivery failed");
+        });
+    }
+
+    return buffered;
+}
+
+std::string Agent::capture(const std::string& action)
+{
+    Lock lock(capture_lock_);
+    const auto status = [this]() -> std::string {
+        pt::ptree output{};
+        output.put("active", bool(capture_));
+
+        if (capture_) {
+            output.put("path", capture_->Path());
+            output.put(
+                "redacted",
+                0 != (capture_->Flags() & capture::FlagRedacted));
+            output.put("records", capture_->Records());
+            output.put("bytes", capture_->Bytes());
+        }
+
+        std::stringstream json{};
+        pt::write_json(json, output);
+
+        return json.str();
+    };
+
+    if (CAPTURE_STATUS == action) { return status(); }
+
+    if (CAPTURE_STOP == action) {
+        const auto output = status();
+
+        if (capture_) {
+            LogNormal(OT_METHOD)(__FUNCTION__)(": Captured ")(
+                capture_->Records())(" requests to ")(capture_->Path())
+                .Flush();
+        }
+
+        capturing_.store(false);
+        capture_.reset();
+
+        return output;
+    }
+
+    if (CAPTURE_START != action) { return "Unknown capture action"; }
+
+    std::string file{};
+    bool redact{false};
+    std::uint64_t maxSize{0};
+
+    {
+        Lock config(config_lock_);
+        file =
+            config_value<std::string>(config_, CONFIG_CAPTURE, std::string{});
+        redact = config_value<bool>(config_, CONFIG_CAPTURE_REDACT, false);
+        maxSize = config_value<std::uint64_t>(
+            config_, CONFIG_CAPTURE_MAX_SIZE, 1024);
+    }
+
+    if (file.empty()) { return "No capture path"; }
+
+    // Replaces any capture already running
+    capture_ = capture::Writer::Open(
+        file, redact ? capture::FlagRedacted : 0, maxSize * 1024 * 1024);
+    capturing_.store(bool(capture_));
+
+    if (false == bool(capture_)) {
+        LogOutput(OT_METHOD)(__FUNCTION__)(": Unable to create capture file ")(
+            file)
+            .Flush();
+
+        return "Unable to create capture file";
+    }
+
+    LogNormal(OT_METHOD)(__FUNCTION__)(": Capturing ")(
+        redact ? "redacted " : "")("requests to ")(file)
+        .Flush();
+
+    return "OK";
+}
+
+void Agent::capture_request(const zmq::Message& message)
+{
+    const auto& body = message.Body();
+    const auto& identity = message.Header_at(message.Header().size() - 1);
+    capture::Frames frames{};
+    frames.reserve(body.size());
+
+    for (std::size_t i{0}; i < body.size(); ++i) {
+        frames.emplace_back(body.at(i));
+    }
+
+    Lock lock(capture_lock_);
+
+    if (false == bool(capture_)) { return; }
+
+    if (0 != (capture_->Flags() & capture::FlagRedacted)) {
+        frames.front() = redact(frames.front());
+    }
+
+    const auto written = capture_->Write(
+        std::string(static_cast<const char*>(identity.data()), identity.size()),
+        frames);
+
+    if (written) { return; }
+
+    LogOutput(OT_METHOD)(__FUNCTION__)(": Stopped capturing to ")(
+        capture_->Path())(" after ")(capture_->Records())(
+        " requests. The size limit was reached or the disk is full.")
+        .Flush();
+    capturing_.store(false);
+    capture_.reset();
+}
+
 void Agent::check_task(
     const Data& connectionID,
     const std::string& taskID,
     const std::string& nymID,
     const int index)
 {
-    const auto status =
-        ot_.Client(index).Sync().Status(Identifier::Factory(taskID));
+    const auto status = executor_->Status(index, taskID);
     bool result{false};
 
     switch (status) {
@@ -363,12 +909,226 @@ void Agent::check_task(
         }
     }
 
-    Lock lock(task_lock_);
-    task_connection_map_.erase(taskID);
-    lock.unlock();
+    // task_handler may have seen the completion after associate_task and
+    // already sent the push
+    const auto task = task_connection_map_.Take(taskID);
+
+    if (false == task.has_value()) { return; }
+
+    release_task(task.value());
+
     send_task_push(connectionID, taskID, nymID, result);
 }
 
+void Agent::collect_metrics(pt::ptree& output) const
+{
+    const auto hits = account_owners_.Hits();
+    const auto misses = account_owners_.Misses();
+    const auto lookups = hits + misses;
+    pt::ptree accountOwners{};
+    accountOwners.put("size", account_owners_.Size());
+    accountOwners.put("hits", hits);
+    accountOwners.put("misses", misses);
+    accountOwners.put("evicted", account_owners_.Evicted());
+    const double rate =
+        (0 == lookups)
+            ? 0.0
+            : static_cast<double>(hits) / static_cast<double>(lookups);
+    accountOwners.put("hit_rate", rate);
+    output.put_child("account_owner_cache", accountOwners);
+
+    const auto requests = requests_.load();
+    const auto average = [requests](const std::uint64_t total) -> double {
+        if (0 == requests) { return 0.0; }
+
+        return static_cast<double>(total) / static_cast<double>(requests) /
+               1000.0;
+    };
+    pt::ptree dispatch{};
+    dispatch.put(
+        "mode", (Dispatch::Queue == dispatch_) ? DISPATCH_QUEUE : "socket");
+    dispatch.put("frontend_shards", shards_.size() + 1);
+    dispatch.put("requests", requests);
+    dispatch.put("queue_depth", work_queue_.Size());
+    dispatch.put("queued_connections", work_queue_.Flows());
+    dispatch.put("in_flight", in_flight_.load());
+    dispatch.put("draining", draining_.load());
+    dispatch.put("expired", expired_.load());
+    dispatch.put("average_dispatch_us", average(dispatch_time_.load()));
+    dispatch.put("average_service_us", average(service_time_.load()));
+    output.put_child("dispatch", dispatch);
+
+    const auto pushes = push_buffer_.Snapshot();
+    pt::ptree pushBuffer{};
+    pushBuffer.put("enabled", push_buffer_.Enabled());
+    pushBuffer.put("nyms", pushes.nyms_);
+    pushBuffer.put("buffered", pushes.buffered_);
+    pushBuffer.put("delivered", pushes.delivered_);
+    pushBuffer.put("evicted", pushes.evicted_);
+    pushBuffer.put("expired", pushes.expired_);
+    output.put_child("push_buffer", pushBuffer);
+
+    pt::ptree subscriptions{};
+    subscriptions.put("enabled", bool(subscriptions_));
+
+    if (subscriptions_) {
+        const auto stats = subscriptions_->Snapshot();
+        subscriptions.put("subscriptions", stats.subscriptions_);
+        subscriptions.put("refreshes", stats.refreshes_);
+        subscriptions.put("deltas", stats.deltas_);
+        subscriptions.put("dropped", stats.dropped_);
+        subscriptions.put("expired", stats.expired_);
+    }
+
+    output.put_child("subscriptions", subscriptions);
+
+    pt::ptree sessions{};
+    pt::ptree clients{};
+    std::size_t hibernating{0};
+
+    for (const auto& session : sessions_.Snapshot()) {
+        const auto reactivations = session.reactivations_;
+        pt::ptree entry{};
+        entry.put("index", session.index_);
+        entry.put("hibernating", session.hibernating_);
+        entry.put("idle_s", session.idle_.count());
+        entry.put("accounts", session.accounts_);
+        entry.put("loaded_kb", session.loaded_kb_);
+        entry.put("hibernations", session.hibernations_);
+        entry.put("reactivations", reactivations);
+        entry.put(
+            "last_reactivation_ms", session.last_reactivation_.count());
+        entry.put("max_reactivation_ms", session.max_reactivation_.count());
+        entry.put(
+            "average_reactivation_ms",
+            (0 == reactivations)
+                ? 0.0
+                : static_cast<double>(session.total_reactivation_.count()) /
+                      static_cast<double>(reactivations));
+        clients.push_back(std::make_pair("", entry));
+
+        if (session.hibernating_) { ++hibernating; }
+    }
+
+    sessions.put("hibernation", sessions_.Enabled());
+    sessions.put("hibernating", hibernating);
+    sessions.put("resident_kb", resident_kb());
+    sessions.put_child("clients", clients);
+    output.put_child("client_sessions", sessions);
+
+    pt::ptree warmup{};
+    warmup.put("ready", ready_.load());
+    warmup.put("duration_ms", warmup_time_.load());
+    warmup.put("accounts", preloaded_accounts_.load());
+    output.put_child("warmup", warmup);
+
+    pt::ptree shm{};
+    shm.put("enabled", bool(shm_));
+    shm.put("connections", shm_ ? shm_->Connections() : 0);
+    output.put_child("shm", shm);
+
+    pt::ptree gc{};
+    gc.put("enabled", bool(gc_));
+
+    if (gc_) {
+        const auto stats = gc_->Snapshot();
+        gc.put("runs", stats.runs_);
+        gc.put("deferred", stats.deferred_);
+        gc.put("forced", stats.forced_);
+        gc.put("waiting_s", stats.waiting_.count());
+        gc.put("total_delay_s", stats.total_delay_.count());
+        gc.put("last_duration_ms", stats.last_duration_.count());
+        gc.put("max_duration_ms", stats.max_duration_.count());
+        gc.put("total_duration_ms", stats.total_duration_.count());
+    }
+
+    output.put_child("storage_gc", gc);
+
+    pt::ptree registry{};
+    registry.put("tasks", task_connection_map_.Size());
+    registry.put("nyms", nym_connection_map_.Size());
+    registry.put("task_ttl_s", task_ttl_.count());
+    registry.put("expired_tasks", expired_tasks_.load());
+    registry.put("unreachable_nyms", unreachable_nyms_.load());
+    registry.put("interned_connections", connections_.Size());
+    registry.put("interned_nyms", nyms_.Size());
+    output.put_child("registry", registry);
+
+    pt::ptree idempotency{};
+    idempotency.put("size", idempotency_.Size());
+    idempotency.put("hits", idempotency_.Hits());
+    idempotency.put("in_progress", in_progress_.load());
+    output.put_child("idempotency", idempotency);
+
+    const auto top = [](const HeavyHitters& sketch, const bool hex) {
+        pt::ptree output{};
+        pt::ptree entries{};
+        output.put("total", sketch.Total());
+
+        for (const auto& entry : sketch.Top(HEAVY_HITTERS_REPORTED)) {
+            pt::ptree item{};
+            item.put("key", hex ? as_data(entry.key_)->asHex() : entry.key_);
+            item.put("count", entry.count_);
+            item.put("error", entry.error_);
+            entries.push_back(std::make_pair("", item));
+        }
+
+        output.put_child("top", entries);
+
+        return output;
+    };
+    pt::ptree heavyHitters{};
+    heavyHitters.put("enabled", top_commands_.Enabled());
+
+    if (top_commands_.Enabled()) {
+        heavyHitters.put_child("nyms", top(top_nyms_, false));
+        heavyHitters.put_child("connections", top(top_connections_, true));
+        heavyHitters.put_child("commands", top(top_commands_, false));
+    }
+
+    output.put_child("heavy_hitters", heavyHitters);
+
+    pt::ptree log{};
+    log.put("dropped", log_.Dropped());
+    log.put("suppressed", log_.Suppressed());
+    output.put_child("log", log);
+}
+
+void Agent::count_request(
+    const proto::RPCCommand& command,
+    const Data& connectionID)
+{
+    if (false == top_commands_.Enabled()) { return; }
+
+    top_commands_.Add(std::to_string(static_cast<int>(command.type())));
+    top_connections_.Add(as_bytes(connectionID));
+
+    if (false == command.owner().empty()) { top_nyms_.Add(command.owner()); }
+
+    for (const auto& nym : command.associatenym()) {
+        if (nym != command.owner()) { top_nyms_.Add(nym); }
+    }
+}
+
+void Agent::copy_frames(
+    const zmq::Message& from,
+    const std::size_t header,
+    zmq::Message& to)
+{
+    const auto headers = from.Header();
+    const auto body = from.Body();
+
+    for (auto i = header; i < headers.size(); ++i) {
+        to.AddFrame(Data::Factory(headers.at(i)));
+    }
+
+    to.AddFrame();
+
+    for (std::size_t i{0}; i < body.size(); ++i) {
+        to.AddFrame(Data::Factory(body.at(i)));
+    }
+}
+
 std::vector<OTZMQReplySocket> Agent::create_backend_sockets(
     const zmq::Context& zmq,
     const std::vector<std::string>& endpoints,
@@ -391,6 +1151,394 @@ std::vector<OTZMQReplySocket> Agent::create_backend_sockets(
     return output;
 }
 
+WorkQueue<OTZMQMessage>::Weights Agent::connection_weights(
+    const pt::ptree& config)
+{
+    // Entries are <hex connection identity>:<weight> separated by commas.
+    // Identities are only stable for clients which set their routing id.
+    const auto value = config_value<std::string>(
+        config, CONFIG_CONNECTION_WEIGHTS, std::string{});
+    WorkQueue<OTZMQMessage>::Weights output{};
+    std::stringstream entries(value);
+    std::string entry{};
+
+    while (std::getline(entries, entry, ',')) {
+        entry.erase(
+            std::remove_if(
+                entry.begin(),
+                entry.end(),
+                [](const char c) { return std::isspace(c); }),
+            entry.end());
+        const auto separator = entry.find(':');
+
+        if ((std::string::npos == separator) || (0 == separator) ||
+            (0 != separator % 2)) {
+            LogOutput(OT_METHOD)(__FUNCTION__)(": Ignoring invalid entry ")(
+                entry)
+                .Flush();
+
+            continue;
+        }
+
+        try {
+            std::string identity{};
+
+            for (std::size_t i{0}; i < separator; i += 2) {
+                const auto byte = std::stoul(entry.substr(i, 2), nullptr, 16);
+                identity.push_back(static_cast<char>(byte));
+            }
+
+            output[identity] = static_cast<std::uint32_t>(
+                std::stoul(entry.substr(separator + 1)));
+        } catch (const std::exception&) {
+            LogOutput(OT_METHOD)(__FUNCTION__)(": Ignoring invalid entry ")(
+                entry)
+                .Flush();
+        }
+    }
+
+    return output;
+}
+
+template <typename T>
+T Agent::config_value(
+    const pt::ptree& config,
+    const char* name,
+    const T& defaultValue)
+{
+    const auto runtime = config.get_optional<T>(
+        pt::ptree::path_type(std::string(CONFIG_RUNTIME_SECTION) + "." + name));
+
+    if (runtime) { return runtime.value(); }
+
+    return config.get<T>(
+        pt::ptree::path_type(std::string(CONFIG_SECTION) + "." + name),
+        defaultValue);
+}
+
+bool Agent::deliver_push(const std::string& nymID, zmq::Message& push)
+{
+    if (push_buffer_.Contains(nymID)) {
+        // Older pushes for the nym are still waiting and have to go first
+        buffer_push(nymID, push);
+        flush_pushes(nymID);
+
+        return false;
+    }
+
+    if (send_message(push)) { return true; }
+
+    buffer_push(nymID, push);
+
+    return false;
+}
+
+void Agent::Drain()
+{
+    draining_.store(true);
+    NotifySystemd("STOPPING=1");
+    LogNormal(OT_METHOD)(__FUNCTION__)(": Draining ")(in_flight_.load())(
+        " requests and ")(pending_tasks())(" tasks.")
+        .Flush();
+    const auto deadline = std::chrono::steady_clock::now() + drain_timeout_;
+    const auto wait = [&deadline](const std::function<bool()>& done) -> bool {
+        while (false == done()) {
+            if (std::chrono::steady_clock::now() > deadline) { return false; }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        return true;
+    };
+
+    // Replies and task pushes are sent synchronously, so once nothing is in
+    // flight and no task is outstanding every push has been handed to the
+    // frontend socket
+    const auto requests = wait([this]() { return 0 == in_flight_.load(); });
+    const auto tasks = wait([this]() { return 0 == pending_tasks(); });
+
+    if (requests && tasks) {
+        LogNormal(OT_METHOD)(__FUNCTION__)(": Drained.").Flush();
+    } else {
+        LogOutput(OT_METHOD)(__FUNCTION__)(": Timed out with ")(
+            in_flight_.load())(" requests and ")(pending_tasks())(
+            " tasks outstanding.")
+            .Flush();
+    }
+}
+
+Agent::Dispatch Agent::dispatch_mode(const pt::ptree& config)
+{
+    const auto mode =
+        config_value<std::string>(config, CONFIG_DISPATCH, std::string{});
+
+    if (DISPATCH_QUEUE == mode) { return Dispatch::Queue; }
+
+    return Dispatch::Socket;
+}
+
+proto::RPCResponse Agent::execute(
+    const proto::RPCCommand& command,
+    const Data& connectionID,
+    TaskOwners& taskOwners)
+{
+    wake_session(command.session());
+    const auto reading = profiler_.Begin();
+    auto response = executor_->RPC(command);
+    profiler_.End(
+        reading, {static_cast<int>(command.type()), command.session()});
+
+    switch (response.type()) {
+        case proto::RPCCOMMAND_ADDCLIENTSESSION: {
+            if (0 < response.status_size() &&
+                proto::RPCRESPONSE_SUCCESS == response.status(0).code()) {
+                update_clients();
+            }
+        } break;
+        case proto::RPCCOMMAND_ADDSERVERSESSION: {
+            if (0 < response.status_size() &&
+                proto::RPCRESPONSE_SUCCESS == response.status(0).code()) {
+                update_servers();
+            }
+        } break;
+        case proto::RPCCOMMAND_CREATENYM: {
+            for (const auto& nymid : response.identifier()) {
+                associate_nym(connectionID, nymid);
+            }
+        } break;
+        case proto::RPCCOMMAND_REGISTERNYM:
+        case proto::RPCCOMMAND_ISSUEUNITDEFINITION: {
+            taskOwners = {command.owner()};
+        } break;
+        case proto::RPCCOMMAND_CREATEACCOUNT:
+        case proto::RPCCOMMAND_CREATECOMPATIBLEACCOUNT: {
+            taskOwners = {command.owner()};
+
+            for (const auto& accountID : response.identifier()) {
+                account_owners_.Add(accountID, command.owner());
+            }
+        } break;
+        case proto::RPCCOMMAND_SENDPAYMENT: {
+            if (0 < response.status_size() &&
+                proto::RPCRESPONSE_QUEUED == response.status(0).code()) {
+                taskOwners = {account_owner(
+                    session_to_client_index(command.session()),
+                    command.sendpayment().sourceaccount())};
+            }
+        } break;
+        case proto::RPCCOMMAND_ACCEPTPENDINGPAYMENTS: {
+            // Each pending payment is a separate item with its own status,
+            // and the destination accounts may belong to different nyms
+            const auto items =
+                static_cast<std::size_t>(command.acceptpendingpayment_size());
+
+            for (const auto& status : response.status()) {
+                const auto index = static_cast<std::size_t>(status.index());
+
+                if ((proto::RPCRESPONSE_QUEUED != status.code()) ||
+                    (index >= items)) {
+                    continue;
+                }
+
+                if (taskOwners.size() <= index) {
+                    taskOwners.resize(index + 1);
+                }
+
+                taskOwners[index] = account_owner(
+                    session_to_client_index(command.session()),
+                    command.acceptpendingpayment(static_cast<int>(index))
+                        .destinationaccount());
+            }
+        } break;
+        case proto::RPCCOMMAND_LISTCLIENTSESSIONS:
+        case proto::RPCCOMMAND_LISTSERVERSESSIONS:
+        case proto::RPCCOMMAND_IMPORTHDSEED:
+        case proto::RPCCOMMAND_LISTHDSEEDS:
+        case proto::RPCCOMMAND_GETHDSEED:
+        case proto::RPCCOMMAND_LISTNYMS:
+        case proto::RPCCOMMAND_GETNYM:
+        case proto::RPCCOMMAND_ADDCLAIM:
+        case proto::RPCCOMMAND_DELETECLAIM:
+        case proto::RPCCOMMAND_IMPORTSERVERCONTRACT:
+        case proto::RPCCOMMAND_LISTSERVERCONTRACTS:
+        case proto::RPCCOMMAND_CREATEUNITDEFINITION:
+        case proto::RPCCOMMAND_LISTUNITDEFINITIONS:
+        case proto::RPCCOMMAND_LISTACCOUNTS:
+        case proto::RPCCOMMAND_GETACCOUNTBALANCE:
+        case proto::RPCCOMMAND_GETACCOUNTACTIVITY:
+        case proto::RPCCOMMAND_MOVEFUNDS:
+        case proto::RPCCOMMAND_ADDCONTACT:
+        case proto::RPCCOMMAND_LISTCONTACTS:
+        case proto::RPCCOMMAND_GETCONTACT:
+        case proto::RPCCOMMAND_ADDCONTACTCLAIM:
+        case proto::RPCCOMMAND_DELETECONTACTCLAIM:
+        case proto::RPCCOMMAND_VERIFYCLAIM:
+        case proto::RPCCOMMAND_ACCEPTVERIFICATION:
+        case proto::RPCCOMMAND_SENDCONTACTMESSAGE:
+        case proto::RPCCOMMAND_GETCONTACTACTIVITY:
+        case proto::RPCCOMMAND_GETSERVERCONTRACT:
+        case proto::RPCCOMMAND_GETPENDINGPAYMENTS:
+        case proto::RPCCOMMAND_GETCOMPATIBLEACCOUNTS:
+        case proto::RPCCOMMAND_GETWORKFLOW:
+        case proto::RPCCOMMAND_GETSERVERPASSWORD:
+        case proto::RPCCOMMAND_GETADMINNYM:
+        case proto::RPCCOMMAND_GETUNITDEFINITION:
+        case proto::RPCCOMMAND_GETTRANSACTIONDATA:
+        case proto::RPCCOMMAND_LOOKUPACCOUNTID:
+        case proto::RPCCOMMAND_RENAMEACCOUNT:
+        case proto::RPCCOMMAND_ERROR:
+        default: {
+        }
+    }
+
+    return response;
+}
+
+void Agent::expire_tasks()
+{
+    const auto ttl =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(task_ttl_).count();
+    std::unique_lock<std::mutex> lock(task_expiry_lock_);
+
+    while (true) {
+        task_expiry_cv_.wait_for(
+            lock, std::chrono::seconds(TASK_EXPIRY_INTERVAL), [this]() {
+                return false == task_expiry_running_;
+            });
+
+        if (false == task_expiry_running_) { return; }
+
+        lock.unlock();
+        const auto cutoff = now() - ttl;
+        // The registry lock is given up between batches so push and task
+        // handlers never wait for more than one batch
+        std::optional<std::string> position{std::string{}};
+
+        while (position.has_value()) {
+            const auto expired = task_connection_map_.TakeIf(
+                [cutoff](const std::string&, const TaskData& task) {
+                    return std::get<2>(task) < cutoff;
+                },
+                position,
+                TASK_EXPIRY_BATCH);
+
+            for (const auto& [taskID, task] : expired) {
+                AGENT_LOG(log_, LogLevel::Output, [taskID = taskID]() {
+                    return "Task " + taskID +
+                           " did not finish in time. Forgetting it.";
+                });
+                release_task(task);
+            }
+
+            expired_tasks_ += expired.size();
+        }
+
+        // A connection the agent hasn't been able to send to for as long as
+        // a task may run has most likely gone away. Associating the nym again
+        // adds a new entry and delivers what is still buffered for it.
+        std::optional<Interner::Handle> nym{Interner::Handle{0}};
+
+        while (nym.has_value()) {
+            const auto unreachable = nym_connection_map_.TakeIf(
+                [cutoff](const Interner::Handle, const NymData& data) {
+                    return (0 < data.second) && (data.second < cutoff);
+                },
+                nym,
+                TASK_EXPIRY_BATCH);
+
+            for (const auto& [handle, data] : unreachable) {
+                AGENT_LOG(
+                    log_,
+                    LogLevel::Output,
+                    [nymID = nyms_.Resolve(handle)]() {
+                        return "The connection for nym " + nymID +
+                               " is unreachable. Forgetting it.";
+                    });
+                connections_.Release(data.first);
+                nyms_.Release(handle);
+            }
+
+            unreachable_nyms_ += unreachable.size();
+        }
+
+        lock.lock();
+    }
+}
+
+std::unique_ptr<Executor> Agent::executor_factory(
+    const api::Native& app,
+    const pt::ptree& config)
+{
+    const auto type =
+        config_value<std::string>(config, CONFIG_EXECUTOR, std::string{});
+
+    if (EXECUTOR_SYNTHETIC != type) {
+        return std::make_unique<NativeExecutor>(app);
+    }
+
+    SyntheticExecutor::Settings settings{};
+    settings.latency_ = std::chrono::microseconds(config_value<std::int64_t>(
+        config, CONFIG_SYNTHETIC_LATENCY, settings.latency_.count()));
+    settings.task_delay_ =
+        std::chrono::milliseconds(config_value<std::int64_t>(
+            config, CONFIG_SYNTHETIC_TASK_DELAY, settings.task_delay_.count()));
+    settings.failed_percent_ = config_value<unsigned int>(
+        config, CONFIG_SYNTHETIC_TASK_FAILURE, settings.failed_percent_);
+    settings.lost_percent_ = config_value<unsigned int>(
+        config, CONFIG_SYNTHETIC_TASK_LOST, settings.lost_percent_);
+    LogOutput(OT_METHOD)(__FUNCTION__)(
+        ": Using the synthetic executor. Commands will not reach opentxs.")
+        .Flush();
+
+    return std::make_unique<SyntheticExecutor>(app, settings);
+}
+
+std::size_t Agent::fingerprint(const proto::RPCCommand& command)
+{
+    // Retries may use a new cookie
+    auto copy = command;
+    copy.clear_cookie();
+
+    return std::hash<std::string>{}(as_bytes(proto::ProtoAsData(copy)));
+}
+
+void Agent::flush_pushes(const std::string& nymID)
+{
+    if (false == push_buffer_.Contains(nymID)) { return; }
+
+    // Serialized so a push can't overtake an older one for the same nym
+    Lock lock(push_lock_);
+    const auto found = nym_connection(nymID);
+
+    if (false == found.has_value()) { return; }
+
+    const auto connection = as_data(connections_.Resolve(found.value()));
+    auto pushes = push_buffer_.Take(nymID);
+    std::size_t delivered{0};
+
+    while (false == pushes.empty()) {
+        auto push = InstantiatePush(connection);
+        push->AddFrame(as_data(pushes.front().payload_));
+
+        if (false == send_message(push)) { break; }
+
+        pushes.pop_front();
+        ++delivered;
+    }
+
+    set_reachable(nymID, found.value(), pushes.empty());
+    connections_.Release(found.value());
+    push_buffer_.Restore(nymID, std::move(pushes));
+
+    if (0 == delivered) { return; }
+
+    AGENT_LOG(log_, LogLevel::Normal, [delivered, nymID, connection]() {
+        return "Delivered " + std::to_string(delivered) +
+               " buffered push notifications to " + nymID + " via " +
+               connection->asHex();
+    });
+}
+
 void Agent::frontend_handler(zmq::Message& message)
 {
     const auto size = message.Header().size();
@@ -398,7 +1546,42 @@ void Agent::frontend_handler(zmq::Message& message)
     OT_ASSERT(0 < size);
 
     if (0 == message.Body().size()) {
-        LogOutput(OT_METHOD)(__FUNCTION__)(": Empty command.").Flush();
+        AGENT_LOG(log_, LogLevel::Output, []() {
+            return std::string("Empty command.");
+        });
+
+        return;
+    }
+
+    if (FrameEquals(message.Body_at(0), ADMIN_FRAME)) {
+        admin_handler(message);
+
+        return;
+    }
+
+    // Any request from a connection keeps its subscriptions
+    if (subscriptions_) {
+        subscriptions_->Touch(std::string(message.Header_at(size - 1)));
+    }
+
+    if (FrameEquals(message.Body_at(0), SUBSCRIBE_FRAME) ||
+        FrameEquals(message.Body_at(0), UNSUBSCRIBE_FRAME)) {
+        subscription_handler(message);
+
+        return;
+    }
+
+    // Rejected requests are captured too since they are part of the load
+    if (capturing_.load()) { capture_request(message); }
+
+    if (draining_.load()) {
+        reject(message, REJECT_DRAINING);
+
+        return;
+    }
+
+    if (false == ready_.load()) {
+        reject(message, REJECT_NOT_READY);
 
         return;
     }
@@ -408,12 +1591,123 @@ void Agent::frontend_handler(zmq::Message& message)
 
     OT_ASSERT(0 < identity.size());
 
-    LogVerbose(OT_METHOD)(__FUNCTION__)(": ConnectionID: ")(
-        Data::Factory(identity)->asHex())
-        .Flush();
+    AGENT_LOG(log_, LogLevel::Verbose, [id = Data::Factory(identity)]() {
+        return "ConnectionID: " + id->asHex();
+    });
     message.AddFrame(Data::Factory(identity));
-    // Forward requests to backend socket(s) via internal socket
-    internal_->Send(message);
+    const auto received = now();
+    message.AddFrame(Data::Factory(&received, sizeof(received)));
+    ++in_flight_;
+
+    if (Dispatch::Queue == dispatch_) {
+        // Hand requests directly to the worker threads
+        // Each connection gets its own queue so one client's backlog can't
+        // hold up everyone else
+        const auto queued = work_queue_.Push(
+            std::string(static_cast<const char*>(identity.data()),
+                        identity.size()),
+            OTZMQMessage{message});
+
+        if (WorkQueue<OTZMQMessage>::Status::Queued != queued) {
+            --in_flight_;
+        }
+
+        switch (queued) {
+            case WorkQueue<OTZMQMessage>::Status::Full: {
+                reject(message, REJECT_QUEUE_FULL);
+            } break;
+            case WorkQueue<OTZMQMessage>::Status::Stopped: {
+                // The agent is shutting down
+                reject(message, REJECT_DRAINING);
+            } break;
+            case WorkQueue<OTZMQMessage>::Status::Queued:
+            default: {
+            }
+        }
+    } else {
+        // Forward requests to backend socket(s) via internal socket
+        if (false == internal_->Send(message)) {
+            --in_flight_;
+            AGENT_LOG(log_, LogLevel::Output, []() {
+                return std::string("Unable to forward request to backend.");
+            });
+        }
+    }
+}
+
+std::size_t Agent::frontend_shard(const zmq::Frame& connection)
+{
+    // Same scheme as the local socket, with the shard number in the byte
+    // after the prefix
+    if ((SHARD_CONNECTION_PREFIX_SIZE + 1 >= connection.size()) ||
+        (0 != std::memcmp(
+                  connection.data(),
+                  SHARD_CONNECTION_PREFIX,
+                  SHARD_CONNECTION_PREFIX_SIZE))) {
+        return 0;
+    }
+
+    return static_cast<const std::uint8_t*>(
+        connection.data())[SHARD_CONNECTION_PREFIX_SIZE];
+}
+
+Authenticator::IDs Agent::id_list(
+    const pt::ptree& config,
+    const char* name,
+    const std::string& defaultValue)
+{
+    // Decimal ids separated by commas
+    const auto value = config_value<std::string>(config, name, defaultValue);
+    Authenticator::IDs output{};
+    std::stringstream stream(value);
+    std::string entry{};
+
+    while (std::getline(stream, entry, ',')) {
+        std::uint32_t id{0};
+        const auto* end = entry.data() + entry.size();
+        const auto result = std::from_chars(entry.data(), end, id);
+
+        if ((std::errc{} != result.ec) || (end != result.ptr)) {
+            LogOutput(OT_METHOD)(__FUNCTION__)(": Ignoring invalid ")(name)(
+                " entry ")(entry)
+                .Flush();
+
+            continue;
+        }
+
+        output.insert(id);
+    }
+
+    return output;
+}
+
+std::unique_ptr<GCScheduler> Agent::gc_scheduler(const pt::ptree& config)
+{
+    GCScheduler::Settings settings{};
+    settings.max_delay_ = std::chrono::seconds(
+        config_value<std::int64_t>(config, CONFIG_GC_MAX_DELAY, 0));
+
+    // Without a maximum delay opentxs collects garbage on its own schedule
+    if (0 >= settings.max_delay_.count()) { return {}; }
+
+    settings.interval_ = std::chrono::seconds(config_value<std::int64_t>(
+        config, CONFIG_GC_INTERVAL, settings.interval_.count()));
+    settings.max_request_rate_ = config_value<std::uint64_t>(
+        config, CONFIG_GC_MAX_REQUEST_RATE, settings.max_request_rate_);
+    settings.max_in_flight_ = config_value<std::int64_t>(
+        config, CONFIG_GC_MAX_IN_FLIGHT, settings.max_in_flight_);
+    LogNormal(OT_METHOD)(__FUNCTION__)(
+        ": Scheduling storage garbage collection every ")(
+        settings.interval_.count())(" seconds, delayed by load for at most ")(
+        settings.max_delay_.count())(" seconds.")
+        .Flush();
+
+    return std::make_unique<GCScheduler>(
+        settings,
+        [this]() -> GCScheduler::Load {
+            return {requests_.load(), in_flight_.load()};
+        },
+        [this]() { run_gc(); });
 }
 
 void Agent::increment_config_value(
@@ -428,106 +1722,521 @@ void Agent::increment_config_value(
     save_config(lock);
 }
 
-OTZMQMessage Agent::instantiate_push(const Data& connectionID)
+void Agent::internal_handler(zmq::Message& message)
 {
-    OT_ASSERT(0 < connectionID.size());
+    // Route replies back to original requestor via frontend socket
+    send_message(message);
+    --in_flight_;
+}
 
-    auto output = zmq::Message::Factory();
-    output->AddFrame(connectionID);
-    output->AddFrame();
-    output->AddFrame("PUSH");
+bool Agent::is_local(const zmq::Frame& connection)
+{
+    // ROUTER sockets assign 5 byte ids and clients can't choose ids starting
+    // with a zero byte, so the prefixed ids can't collide with either
+    return (LOCAL_CONNECTION_PREFIX_SIZE < connection.size()) &&
+           (0 == std::memcmp(
+                     connection.data(),
+                     LOCAL_CONNECTION_PREFIX,
+                     LOCAL_CONNECTION_PREFIX_SIZE));
+}
 
-    OT_ASSERT(1 == output->Header().size());
-    OT_ASSERT(1 == output->Body().size());
+void Agent::local_handler(zmq::Message& message)
+{
+    OT_ASSERT(0 < message.Header().size());
+
+    // Prefix the routing id so replies and pushes for this connection are
+    // sent through the local socket, then handle it like any other request
+    auto tagged = tag_connection(
+        std::string(LOCAL_CONNECTION_PREFIX, LOCAL_CONNECTION_PREFIX_SIZE),
+        message);
+    frontend_handler(tagged);
+}
 
-    return output;
+std::int64_t Agent::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
 }
 
-void Agent::internal_handler(zmq::Message& message)
+std::size_t Agent::pending_tasks() const
 {
-    // Route replies back to original requestor via frontend socket
-    frontend_->Send(message);
+    return task_connection_map_.Size();
+}
+
+std::optional<Interner::Handle> Agent::nym_connection(
+    const std::string& nymID)
+{
+    // Interning holds the nym's handle while the registry is searched, and
+    // the connection's reference is added under the registry's lock, so
+    // associate_nym can't release either and have it reused in between
+    const auto nym = nyms_.Intern(nymID);
+    const auto output =
+        nym_connection_map_.Find(nym, [this](const NymData& data) {
+            connections_.Reference(data.first);
+        });
+    nyms_.Release(nym);
+
+    if (false == output.has_value()) { return {}; }
+
+    return output.value().first;
+}
+
+std::string Agent::profile(const std::string& action)
+{
+    if (PROFILE_START == action) {
+        const auto error = profiler_.Enable();
+        LogNormal(OT_METHOD)(__FUNCTION__)(": Command profiling started.")
+            .Flush();
+
+        if (error.empty()) { return "OK"; }
+
+        return "OK without hardware counters (" + error + ")";
+    }
+
+    if (PROFILE_STOP == action) {
+        profiler_.Disable();
+        LogNormal(OT_METHOD)(__FUNCTION__)(": Command profiling stopped.")
+            .Flush();
+
+        return "OK";
+    }
+
+    if (PROFILE_RESET == action) {
+        profiler_.Reset();
+
+        return "OK";
+    }
+
+    if (PROFILE_DUMP != action) { return "Unknown profile action"; }
+
+    const auto ratio = [](const std::uint64_t numerator,
+                          const std::uint64_t denominator) -> double {
+        if (0 == denominator) { return 0.0; }
+
+        return static_cast<double>(numerator) /
+               static_cast<double>(denominator);
+    };
+    pt::ptree output{};
+    pt::ptree commands{};
+    output.put("enabled", profiler_.Enabled());
+
+    for (const auto& [key, counters] : profiler_.Snapshot()) {
+        const auto& [type, session] = key;
+        const auto measured = counters.measured_calls_;
+        pt::ptree entry{};
+        entry.put("type", type);
+        entry.put("session", session);
+        entry.put("calls", counters.calls_);
+        entry.put(
+            "average_us", ratio(counters.wall_ns_, counters.calls_ * 1000));
+        entry.put("measured_calls", measured);
+        entry.put("cycles_per_call", ratio(counters.cycles_, measured));
+        entry.put(
+            "instructions_per_call", ratio(counters.instructions_, measured));
+        entry.put(
+            "instructions_per_cycle",
+            ratio(counters.instructions_, counters.cycles_));
+        entry.put(
+            "cache_misses_per_call", ratio(counters.cache_misses_, measured));
+        entry.put(
+            "voluntary_switches_per_call",
+            ratio(counters.voluntary_switches_, counters.calls_));
+        entry.put(
+            "involuntary_switches_per_call",
+            ratio(counters.involuntary_switches_, counters.calls_));
+        commands.push_back(std::make_pair("", entry));
+    }
+
+    output.put_child("commands", commands);
+    std::stringstream json{};
+    pt::write_json(json, output);
+
+    return json.str();
 }
 
 void Agent::push_handler(const zmq::Message& message)
 {
     if (2 != message.Body().size()) {
-        LogOutput(OT_METHOD)(__FUNCTION__)(": Invalid message").Flush();
+        AGENT_LOG(log_, LogLevel::Output, []() {
+            return std::string("Invalid message");
+        });
 
         return;
     }
 
     const std::string nymID{message.Body_at(0)};
     const auto& payload = message.Body_at(1);
-    auto connection = Data::Factory();
 
-    try {
-        Lock lock(nym_lock_);
-        connection = nym_connection_map_.at(nymID);
-    } catch (...) {
-        LogNormal(OT_METHOD)(__FUNCTION__)(": No connection associated with ")(
-            nymID)
-            .Flush();
+    // Subscriptions are rerun whether or not the nym has a connection
+    if (subscriptions_) { subscriptions_->Notify(nymID); }
+
+    const auto found = nym_connection(nymID);
+
+    if (false == found.has_value()) {
+        if (push_buffer_.Contains(nymID)) {
+            // The nym's unreachable connection has been forgotten, and this
+            // waits with the older pushes for the client to associate again
+            push_buffer_.Add(
+                nymID,
+                std::string(
+                    static_cast<const char*>(payload.data()), payload.size()));
+
+            return;
+        }
+
+        AGENT_LOG(log_, LogLevel::Normal, [nymID]() {
+            return "No connection associated with " + nymID;
+        });
 
         return;
     }
 
-    auto notification = instantiate_push(connection);
+    const auto connection = as_data(connections_.Resolve(found.value()));
+    auto notification = InstantiatePush(connection);
     notification->AddFrame(payload);
-    const auto sent = frontend_->Send(notification);
+    const auto delivered = deliver_push(nymID, notification);
+    // Pushes still buffered couldn't be sent to the connection
+    set_reachable(
+        nymID,
+        found.value(),
+        delivered || (false == push_buffer_.Contains(nymID)));
+    connections_.Release(found.value());
+
+    if (delivered) {
+        AGENT_LOG(log_, LogLevel::Normal, [nymID, connection]() {
+            return "Push notification delivered to " + nymID + " via " +
+                   connection->asHex();
+        });
+    }
+}
+
+std::string Agent::redact(const std::string& command)
+{
+    // Keeps what the agent dispatches on and drops ids, seeds, memos and
+    // amounts. A redacted capture measures load, not outcomes.
+    const auto original =
+        opentxs::proto::DataToProto<proto::RPCCommand>(as_data(command));
+    proto::RPCCommand output{};
+    output.set_version(original.version());
+    output.set_cookie(original.cookie());
+    output.set_type(original.type());
+    output.set_session(original.session());
+
+    return as_bytes(proto::ProtoAsData(output));
+}
+
+void Agent::register_tasks(
+    const proto::RPCCommand& command,
+    const proto::RPCResponse& response,
+    const Data& connectionID,
+    const TaskOwners& taskOwners)
+{
+    // Batches such as ACCEPTPENDINGPAYMENTS queue a task per item, so every
+    // task gets its own completion push
+    for (const auto& task : response.task()) {
+        const auto& taskID = task.id();
+        const auto index = static_cast<std::size_t>(task.index());
+
+        if (taskID.empty()) { continue; }
+
+        if ((index >= taskOwners.size()) || taskOwners.at(index).empty()) {
+            AGENT_LOG(log_, LogLevel::Output, [taskID]() {
+                return "Unable to find the owner of task " + taskID;
+            });
+
+            continue;
+        }
+
+        const auto& nymID = taskOwners.at(index);
+        associate_task(connectionID, nymID, taskID);
+        // It's possible for the task subscriber to miss a task
+        // complete message if the task finished quickly before
+        // we added the id to task_connection_map_
+        check_task(
+            connectionID,
+            taskID,
+            nymID,
+            session_to_client_index(command.session()));
+    }
+}
+
+OTZMQMessage Agent::rejection(
+    const zmq::Message& message,
+    const char* reason,
+    const proto::RPCResponseCode code)
+{
+    const auto& request = message.Body_at(0);
+    const auto command = opentxs::proto::DataToProto<proto::RPCCommand>(
+        Data::Factory(request.data(), request.size()));
+    const auto response = status_response(command, code);
+    // The second frame tells agent aware clients why the request was not run
+    auto reply = zmq::Message::ReplyFactory(message);
+    reply->AddFrame(proto::ProtoAsData(response));
+    reply->AddFrame(reason);
+
+    return reply;
+}
+
+void Agent::refresh_session(const int instance)
+{
+    std::vector<std::string> accounts{};
+
+    switch (sessions_.Check(instance, accounts)) {
+        case SessionActivity::Status::Active: {
+            ot_.Client(instance).Sync().Refresh();
+        } break;
+        case SessionActivity::Status::Hibernate: {
+            // opentxs has no way to unload a session's wallet, so what
+            // hibernation saves is the refresh traffic and the agent's own
+            // caches for the session
+            account_owners_.Remove(accounts);
+            LogNormal(OT_METHOD)(__FUNCTION__)(": Client session ")(instance)(
+                " is idle and hibernating.")
+                .Flush();
+        } break;
+        case SessionActivity::Status::Hibernating:
+        default: {
+        }
+    }
+}
 
-    if (sent) {
-        LogNormal(OT_METHOD)(__FUNCTION__)(": Push notification delivered to ")(
-            nymID)(" via ")(connection->asHex())
+void Agent::release_task(const TaskData& task)
+{
+    const auto& [connection, nym, associated] = task;
+    connections_.Release(connection);
+    nyms_.Release(nym);
+}
+
+void Agent::reject(const zmq::Message& message, const char* reason)
+{
+    auto reply = rejection(message, reason, proto::RPCRESPONSE_RETRY);
+    send_message(reply);
+}
+
+void Agent::rewarm_session(const int index)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const auto before = resident_kb();
+
+    try {
+        auto accounts = executor_->Preload(index);
+
+        for (const auto& id : accounts) { account_owner(index, id); }
+
+        sessions_.Loaded(index, std::move(accounts), resident_kb() - before);
+    } catch (const std::exception& e) {
+        LogOutput(OT_METHOD)(__FUNCTION__)(": Reloading session ")(index)(
+            " failed: ")(e.what())
             .Flush();
+    }
+
+    ot_.Client(index).Sync().Refresh();
+    const auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    sessions_.Woken(index, latency);
+    AGENT_LOG(log_, LogLevel::Normal, [index, latency]() {
+        return "Client session " + std::to_string(index) + " woke up in " +
+               std::to_string(latency.count()) + " ms";
+    });
+}
+
+void Agent::run_gc()
+{
+    AGENT_LOG(log_, LogLevel::Verbose, []() {
+        return std::string("Starting storage garbage collection");
+    });
+
+    for (auto i = 0; i < clients_.load(); ++i) {
+        ot_.Client(i).Storage().RunGC();
+    }
+
+    for (auto i = 0; i < servers_.load(); ++i) {
+        ot_.Server(i).Storage().RunGC();
+    }
+}
+
+bool Agent::run_subscription(
+    const std::string& command,
+    Subscriptions::Items& items,
+    Subscriptions::Nyms& nyms)
+{
+    const auto query =
+        opentxs::proto::DataToProto<proto::RPCCommand>(as_data(command));
+    const auto response = executor_->RPC(query);
+
+    if (0 == response.status_size()) { return false; }
+
+    // NONE means an empty result, which is still a result
+    for (const auto& status : response.status()) {
+        if ((proto::RPCRESPONSE_SUCCESS != status.code()) &&
+            (proto::RPCRESPONSE_NONE != status.code())) {
+            return false;
+        }
+    }
+
+    if (proto::RPCCOMMAND_GETACCOUNTBALANCE == query.type()) {
+        for (const auto& balance : response.balance()) {
+            items.emplace_back(as_bytes(proto::ProtoAsData(balance)));
+        }
     } else {
-        LogOutput(OT_METHOD)(__FUNCTION__)(
-            ": Push notification delivery failed")
-            .Flush();
+        for (const auto& event : response.accountevent()) {
+            items.emplace_back(as_bytes(proto::ProtoAsData(event)));
+        }
+    }
+
+    // Pushes and task completions arrive per nym, so accounts are mapped to
+    // their owners
+    if (false == query.owner().empty()) { nyms.insert(query.owner()); }
+
+    if (proto::RPCCOMMAND_GETPENDINGPAYMENTS != query.type()) {
+        const auto clientIndex = session_to_client_index(query.session());
+
+        for (const auto& accountID : query.identifier()) {
+            const auto owner = account_owner(clientIndex, accountID);
+
+            if (false == owner.empty()) { nyms.insert(owner); }
+        }
     }
+
+    return true;
 }
 
 void Agent::save_config(const Lock& lock)
 {
+    // Command line tunables aren't saved
+    auto saved = config_;
+    saved.erase(CONFIG_RUNTIME_SECTION);
     fs::fstream settingsfile(settings_path_, std::ios::out);
-    pt::write_ini(settings_path_, config_);
+    pt::write_ini(settings_path_, saved);
     settingsfile.close();
 }
 
-void Agent::schedule_refresh(const int instance) const
+void Agent::schedule_refresh(const int instance)
 {
     const auto& client = ot_.Client(instance);
     client.Sync().Refresh();
     client.Schedule(
         std::chrono::seconds(30),
-        [=]() -> void { this->ot_.Client(instance).Sync().Refresh(); },
+        [=]() -> void { this->refresh_session(instance); },
         (std::chrono::seconds(std::time(nullptr))));
 }
 
+bool Agent::send_message(zmq::Message& message)
+{
+    const auto& connection = message.Header_at(0);
+
+    if (is_local(connection)) {
+        // Restore the routing id the local socket assigned
+        auto local = zmq::Message::Factory();
+        local->AddFrame(Data::Factory(
+            static_cast<const char*>(connection.data()) +
+                LOCAL_CONNECTION_PREFIX_SIZE,
+            connection.size() - LOCAL_CONNECTION_PREFIX_SIZE));
+        copy_frames(message, 1, local);
+
+        return local_->Send(local);
+    }
+
+    const auto shard = frontend_shard(connection);
+
+    if ((0 < shard) && (shard <= shards_.size())) {
+        // Each shard has its own socket lock, so sends to connections on
+        // different shards don't wait for each other
+        auto routed = zmq::Message::Factory();
+        routed->AddFrame(Data::Factory(
+            static_cast<const char*>(connection.data()) +
+                SHARD_CONNECTION_PREFIX_SIZE + 1,
+            connection.size() - SHARD_CONNECTION_PREFIX_SIZE - 1));
+        copy_frames(message, 1, routed);
+
+        return shards_.at(shard - 1)->Send(routed);
+    }
+
+    if (shm_ && ShmServer::IsConnection(connection.data(), connection.size())) {
+        const auto body = message.Body();
+        shm::Frames frames{};
+
+        for (std::size_t i{0}; i < body.size(); ++i) {
+            frames.emplace_back(body.at(i));
+        }
+
+        return shm_->Send(std::string(connection), frames);
+    }
+
+    return frontend_->Send(message);
+}
+
+bool Agent::send_subscription(
+    const std::string& connection,
+    const std::uint64_t id,
+    const std::string& command,
+    const Subscriptions::Items& added,
+    const Subscriptions::Items& removed)
+{
+    const auto query =
+        opentxs::proto::DataToProto<proto::RPCCommand>(as_data(command));
+    const auto balance = (proto::RPCCOMMAND_GETACCOUNTBALANCE == query.type());
+    const auto delta = [&](const Subscriptions::Items& items) {
+        proto::RPCResponse output{};
+        output.set_version(query.version());
+        output.set_cookie(query.cookie());
+        output.set_type(query.type());
+        output.set_session(query.session());
+        auto& status = *output.add_status();
+        status.set_version(RPCSTATUS_VERSION);
+        status.set_index(0);
+        status.set_code(proto::RPCRESPONSE_SUCCESS);
+
+        for (const auto& item : items) {
+            if (balance) {
+                *output.add_balance() =
+                    opentxs::proto::DataToProto<proto::AccountData>(
+                        as_data(item));
+            } else {
+                *output.add_accountevent() =
+                    opentxs::proto::DataToProto<proto::AccountEvent>(
+                        as_data(item));
+            }
+        }
+
+        return output;
+    };
+    auto push =
+        SubscriptionPush(as_data(connection), id, delta(added), delta(removed));
+
+    return send_message(push);
+}
+
 void Agent::send_task_push(
     const Data& connectionID,
     const std::string& taskID,
     const std::string& nymID,
     const bool result)
 {
-    OT_ASSERT(false == connectionID.empty());
-    OT_ASSERT(false == taskID.empty());
-    OT_ASSERT(false == nymID.empty());
+    if (subscriptions_) { subscriptions_->Notify(nymID); }
 
-    auto push = instantiate_push(connectionID);
-    proto::RPCPush message{};
-    message.set_version(RPCPUSH_VERSION);
-    message.set_type(proto::RPCPUSH_TASK);
-    message.set_id(nymID);
-    auto& task = *message.mutable_taskcomplete();
-    task.set_version(TASKCOMPLETE_VERSION);
-    task.set_id(taskID);
-    task.set_result(result);
-
-    OT_ASSERT(proto::Validate(message, VERBOSE));
+    auto push = TaskPush(connectionID, taskID, nymID, result);
+    deliver_push(nymID, push);
+}
 
-    push->AddFrame(proto::ProtoAsData(message));
-    frontend_->Send(push);
+void Agent::set_reachable(
+    const std::string& nymID,
+    const Interner::Handle connection,
+    const bool reachable)
+{
+    const auto nym = nyms_.Intern(nymID);
+    const auto time = now();
+    nym_connection_map_.Modify(nym, [&](NymData& data) {
+        if (connection != data.first) { return; }
+
+        if (reachable) {
+            data.second = 0;
+        } else if (0 == data.second) {
+            data.second = time;
+        }
+    });
+    nyms_.Release(nym);
 }
 
 int Agent::session_to_client_index(const std::uint32_t session)
@@ -537,18 +2246,297 @@ int Agent::session_to_client_index(const std::uint32_t session)
     return session / 2;
 }
 
+void Agent::shard_handler(const std::size_t shard, zmq::Message& message)
+{
+    OT_ASSERT(0 < message.Header().size());
+
+    std::string prefix(SHARD_CONNECTION_PREFIX, SHARD_CONNECTION_PREFIX_SIZE);
+    prefix.push_back(static_cast<char>(shard));
+    auto tagged = tag_connection(prefix, message);
+    frontend_handler(tagged);
+}
+
+std::string Agent::shard_endpoint(
+    const std::string& endpoint,
+    const std::size_t shard)
+{
+    // tcp endpoints move up one port per shard. Everything else, including
+    // the ipc socket path, gets the shard number as a suffix.
+    if (0 != endpoint.compare(0, 6, "tcp://")) {
+        return endpoint + "." + std::to_string(shard);
+    }
+
+    const auto port = tcp_port(endpoint);
+
+    // Wildcard ports can't be derived
+    if ((false == port.has_value()) || (65535 < port.value() + shard)) {
+        return {};
+    }
+
+    return endpoint.substr(0, endpoint.rfind(':') + 1) +
+           std::to_string(port.value() + shard);
+}
+
+shm::Frames Agent::shm_handler(
+    const std::string& connection,
+    shm::Frames&& request)
+{
+    if (request.empty()) { return {}; }
+
+    // Same path as frontend_handler, except the reply comes back here
+    // instead of going out through the frontend socket
+    auto message = zmq::Message::Factory();
+
+    for (const auto& frame : request) { message->AddFrame(frame); }
+
+    const auto reply = [&]() -> OTZMQMessage {
+        if (draining_.load()) {
+            return rejection(
+                message, REJECT_DRAINING, proto::RPCRESPONSE_RETRY);
+        }
+
+        if (false == ready_.load()) {
+            return rejection(
+                message, REJECT_NOT_READY, proto::RPCRESPONSE_RETRY);
+        }
+
+        message->AddFrame(as_data(connection));
+        const auto received = now();
+        message->AddFrame(Data::Factory(&received, sizeof(received)));
+        ++in_flight_;
+        auto output = backend_handler(message);
+        --in_flight_;
+
+        return output;
+    }();
+    const auto body = reply->Body();
+    shm::Frames output{};
+
+    for (std::size_t i{0}; i < body.size(); ++i) {
+        output.emplace_back(body.at(i));
+    }
+
+    return output;
+}
+
+proto::RPCResponse Agent::status_response(
+    const proto::RPCCommand& command,
+    const proto::RPCResponseCode code)
+{
+    proto::RPCResponse output{};
+    output.set_version(command.version());
+    output.set_cookie(command.cookie());
+    output.set_type(command.type());
+    output.set_session(command.session());
+    auto& status = *output.add_status();
+    status.set_version(RPCSTATUS_VERSION);
+    status.set_index(0);
+    status.set_code(code);
+
+    return output;
+}
+
+bool Agent::subscribable(const proto::RPCCommandType type)
+{
+    return (proto::RPCCOMMAND_GETACCOUNTBALANCE == type) ||
+           (proto::RPCCOMMAND_GETACCOUNTACTIVITY == type) ||
+           (proto::RPCCOMMAND_GETPENDINGPAYMENTS == type);
+}
+
+void Agent::start_shards(const std::size_t count)
+{
+    auto endpoints = frontend_endpoints_;
+
+    // The ipc socket belongs to the local socket when it authenticates by
+    // peer credentials, and isn't sharded
+    if (false == local_auth_) { endpoints.emplace_back(socket_path_); }
+
+    // Every endpoint already bound or claimed by an earlier shard. tcp
+    // endpoints are compared by port since the same port on a different
+    // interface address usually still conflicts.
+    std::set<std::string> taken{socket_path_};
+    std::set<std::uint32_t> ports{};
+    const auto claim = [&](const std::string& endpoint) -> bool {
+        const auto port = tcp_port(endpoint);
+
+        if (port.has_value()) { return ports.insert(port.value()).second; }
+
+        return taken.insert(endpoint).second;
+    };
+
+    for (const auto& endpoint : frontend_endpoints_) { claim(endpoint); }
+
+    for (std::size_t shard{1}; shard < count; ++shard) {
+        shard_callbacks_.emplace_back(zmq::ListenCallback::Factory(std::bind(
+            &Agent::shard_handler, this, shard, std::placeholders::_1)));
+        shards_.emplace_back(zmq_.RouterSocket(
+            shard_callbacks_.back(), zmq::Socket::Direction::Bind));
+        auto& socket = shards_.back();
+        const auto domain = socket->SetDomain(ZAP_DOMAIN);
+
+        OT_ASSERT(domain);
+
+        const bool set = socket->SetPrivateKey(server_privkey_);
+
+        OT_ASSERT(set);
+
+        for (const auto& endpoint : endpoints) {
+            const auto shardEndpoint = shard_endpoint(endpoint, shard);
+
+            if (shardEndpoint.empty()) {
+                LogOutput(OT_METHOD)(__FUNCTION__)(
+                    ": No shard endpoint can be derived from ")(endpoint)
+                    .Flush();
+
+                continue;
+            }
+
+            if (false == claim(shardEndpoint)) {
+                LogOutput(OT_METHOD)(__FUNCTION__)(": Frontend shard ")(shard)(
+                    " endpoint ")(shardEndpoint)(
+                    " overlaps another endpoint and is not bound")
+                    .Flush();
+
+                continue;
+            }
+
+            // Something outside the agent may hold the port, which costs the
+            // shard an endpoint but shouldn't stop the agent
+            if (false == socket->Start(shardEndpoint)) {
+                LogOutput(OT_METHOD)(__FUNCTION__)(": Frontend shard ")(shard)(
+                    " failed to bind ")(shardEndpoint)
+                    .Flush();
+
+                continue;
+            }
+
+            LogNormal(OT_METHOD)(__FUNCTION__)(": Frontend shard ")(shard)(
+                " listening on ")(shardEndpoint)
+                .Flush();
+        }
+    }
+}
+
+void Agent::subscribe_tasks(const std::int64_t clients)
+{
+    Lock lock(task_endpoint_lock_);
+
+    for (const auto& endpoint : executor_->TaskEndpoints(clients)) {
+        if (false == task_endpoints_.insert(endpoint).second) { continue; }
+
+        const auto started = task_subscriber_->Start(endpoint);
+
+        OT_ASSERT(started);
+    }
+}
+
+void Agent::subscription_handler(const zmq::Message& message)
+{
+    auto reply = zmq::Message::ReplyFactory(message);
+    const auto body = message.Body();
+    const auto& identity = message.Header_at(message.Header().size() - 1);
+    const std::string connection{identity};
+
+    if (FrameEquals(body.at(0), UNSUBSCRIBE_FRAME)) {
+        const std::string id = (1 < body.size()) ? std::string(body.at(1)) : "";
+        std::uint64_t value{0};
+        std::from_chars(id.data(), id.data() + id.size(), value);
+        const auto removed = subscriptions_ && (0 < value) &&
+                             subscriptions_->Remove(connection, value);
+        reply->AddFrame(UNSUBSCRIBE_FRAME);
+        reply->AddFrame(id);
+        reply->AddFrame(removed ? UNSUBSCRIBE_OK : UNSUBSCRIBE_UNKNOWN);
+        send_message(reply);
+
+        return;
+    }
+
+    std::uint64_t id{0};
+    const auto reason = [&]() -> const char* {
+        if (false == bool(subscriptions_)) { return SUBSCRIBE_DISABLED; }
+
+        if (draining_.load()) { return REJECT_DRAINING; }
+
+        if (false == ready_.load()) { return REJECT_NOT_READY; }
+
+        if (2 > body.size()) { return SUBSCRIBE_INVALID; }
+
+        const auto& request = body.at(1);
+        const auto command = opentxs::proto::DataToProto<proto::RPCCommand>(
+            Data::Factory(request.data(), request.size()));
+
+        if (false == proto::Validate(command, VERBOSE)) {
+            return SUBSCRIBE_INVALID;
+        }
+
+        if (false == subscribable(command.type())) {
+            return SUBSCRIBE_UNSUPPORTED;
+        }
+
+        id = subscriptions_->Add(connection, std::string(request));
+
+        return (0 == id) ? SUBSCRIBE_LIMIT : nullptr;
+    }();
+    reply->AddFrame(SUBSCRIBE_FRAME);
+
+    if (nullptr == reason) {
+        AGENT_LOG(log_, LogLevel::Normal, [id, c = Data::Factory(identity)]() {
+            return "Connection " + c->asHex() + " subscribed as " +
+                   std::to_string(id);
+        });
+        reply->AddFrame(std::to_string(id));
+    } else {
+        reply->AddFrame();
+        reply->AddFrame(reason);
+    }
+
+    send_message(reply);
+}
+
+OTZMQMessage Agent::tag_connection(
+    const std::string& prefix,
+    const zmq::Message& message)
+{
+    const auto& identity = message.Header_at(0);
+    auto connection = prefix;
+    connection.append(
+        static_cast<const char*>(identity.data()), identity.size());
+    auto output = zmq::Message::Factory();
+    output->AddFrame(as_data(connection));
+    copy_frames(message, 1, output);
+
+    return output;
+}
+
+std::optional<std::uint32_t> Agent::tcp_port(const std::string& endpoint)
+{
+    if (0 != endpoint.compare(0, 6, "tcp://")) { return {}; }
+
+    const auto colon = endpoint.rfind(':');
+    const auto* start = endpoint.data() + colon + 1;
+    const auto* end = endpoint.data() + endpoint.size();
+    std::uint32_t port{0};
+    const auto result = std::from_chars(start, end, port);
+
+    if ((std::errc{} != result.ec) || (end != result.ptr)) { return {}; }
+
+    return port;
+}
+
 void Agent::task_handler(const zmq::Message& message)
 {
     if (2 > message.Body().size()) {
-        LogOutput(OT_METHOD)(__FUNCTION__)(": Invalid message").Flush();
+        AGENT_LOG(log_, LogLevel::Output, []() {
+            return std::string("Invalid message");
+        });
 
         return;
     }
 
-    LogOutput(OT_METHOD)(__FUNCTION__)(": Received notice for task ")(
-        std::string(message.Body_at(0)))
-        .Flush();
     const std::string taskID{message.Body_at(0)};
+    AGENT_LOG(log_, LogLevel::Output, [taskID]() {
+        return "Received notice for task " + taskID;
+    });
     const auto raw = Data::Factory(message.Body_at(1));
     bool success{false};
     OTPassword::safe_memcpy(
@@ -556,21 +2544,20 @@ void Agent::task_handler(const zmq::Message& message)
         sizeof(success),
         raw->data(),
         static_cast<std::uint32_t>(raw->size()));
-    Lock lock(task_lock_);
-    const auto it = task_connection_map_.find(taskID);
+    const auto task = task_connection_map_.Take(taskID);
 
-    if (task_connection_map_.end() == it) {
-        LogDebug(OT_METHOD)(__FUNCTION__)(": We don't care about task ")(
-            std::string(message.Body_at(0)))
-            .Flush();
+    if (false == task.has_value()) {
+        AGENT_LOG(log_, LogLevel::Debug, [taskID]() {
+            return "We don't care about task " + taskID;
+        });
 
         return;
     }
 
-    const OTData connectionID = it->second.first;
-    const std::string nymID = it->second.second;
-    task_connection_map_.erase(it);
-    lock.unlock();
+    const auto& [connection, nym, associated] = task.value();
+    const auto connectionID = as_data(connections_.Resolve(connection));
+    const auto nymID = nyms_.Resolve(nym);
+    release_task(task.value());
 
     OT_ASSERT(false == nymID.empty());
 
@@ -582,7 +2569,7 @@ void Agent::update_clients()
     increment_config_value(CONFIG_SECTION, CONFIG_CLIENTS);
     const auto newCount = ++clients_;
     const auto newIndex = static_cast<int>(newCount) - 1;
-    task_subscriber_->Start(ot_.Client(newIndex).Endpoints().TaskComplete());
+    subscribe_tasks(newCount);
     schedule_refresh(newIndex);
 }
 
@@ -592,22 +2579,114 @@ void Agent::update_servers()
     ++servers_;
 }
 
-OTZMQZAPReply Agent::zap_handler(const zap::Request& request) const
+unsigned int Agent::worker_count()
 {
-    auto output = zap::Reply::Factory(request);
-    const auto& pubkey = request.Credentials().at(0);
+    const unsigned int min_threads{1};
 
-    if (zap::Mechanism::Curve != request.Mechanism()) {
-        output->SetCode(zap::Status::AuthFailure);
-        output->SetStatus("Unsupported mechanism");
-    } else if (client_pubkey_ != ot_.Crypto().Encode().Z85Encode(pubkey)) {
-        output->SetCode(zap::Status::AuthFailure);
-        output->SetStatus("Incorrect pubkey");
-    } else {
-        output->SetCode(zap::Status::Success);
-        output->SetStatus("OK");
+    return std::max(std::thread::hardware_concurrency(), min_threads);
+}
+
+void Agent::warmup(const bool preload)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const auto clients = static_cast<int>(clients_.load());
+
+    if (preload) {
+        LogNormal(OT_METHOD)(__FUNCTION__)(": Warming up ")(clients)(
+            " client sessions.")
+            .Flush();
+        // Sessions have separate storage, so they load in parallel
+        std::vector<std::future<std::size_t>> sessions{};
+
+        for (int i{0}; i < clients; ++i) {
+            sessions.emplace_back(
+                std::async(std::launch::async, [this, i]() -> std::size_t {
+                    const auto before = resident_kb();
+                    auto accounts = executor_->Preload(i);
+
+                    // Fills the account owner cache used to route task pushes
+                    for (const auto& id : accounts) { account_owner(i, id); }
+
+                    const auto count = accounts.size();
+                    sessions_.Loaded(
+                        i, std::move(accounts), resident_kb() - before);
+
+                    return count;
+                }));
+        }
+
+        for (int i{0}; i < clients; ++i) {
+            try {
+                preloaded_accounts_ += sessions.at(i).get();
+            } catch (const std::exception& e) {
+                LogOutput(OT_METHOD)(__FUNCTION__)(": Warmup of session ")(i)(
+                    " failed: ")(e.what())
+                    .Flush();
+            }
+        }
     }
 
-    return output;
+    warmup_time_.store(std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count());
+    ready_.store(true);
+    LogNormal(OT_METHOD)(__FUNCTION__)(": Ready after ")(warmup_time_.load())(
+        " ms.")
+        .Flush();
+    NotifySystemd("READY=1");
+}
+
+void Agent::wake_session(const std::int32_t session)
+{
+    if (false == sessions_.Enabled()) { return; }
+
+    // Server sessions and commands which aren't for a session don't
+    // hibernate
+    if ((0 > session) || (0 != session % 2)) { return; }
+
+    const auto index = session_to_client_index(session);
+
+    if ((index >= clients_.load()) || (false == sessions_.Touch(index))) {
+        return;
+    }
+
+    // Hibernation leaves the wallet loaded and only drops the refresh
+    // schedule and the account owner cache, which fills again on misses. So
+    // neither this command nor any other for the session needs to wait for
+    // the reload.
+    Lock lock(wake_lock_);
+    auto& wake = wakes_[index];
+
+    // A session hibernating again before its last reload finished is
+    // already being reloaded
+    if (wake.valid() && (std::future_status::ready !=
+                         wake.wait_for(std::chrono::seconds(0)))) {
+        return;
+    }
+
+    wake = std::async(std::launch::async, &Agent::rewarm_session, this, index);
+}
+
+void Agent::worker()
+{
+    while (true) {
+        auto request = work_queue_.Pop();
+
+        if (false == request.has_value()) { return; }
+
+        // Replies go straight back out through the frontend socket
+        auto reply = backend_handler(request.value());
+        send_message(reply);
+        --in_flight_;
+    }
+}
+
+OTZMQZAPReply Agent::zap_handler(const zap::Request& request) const
+{
+    if (LOCAL_ZAP_DOMAIN == request.Domain()) {
+        return authenticator_.AuthenticateLocal(request);
+    }
+
+    return authenticator_.Authenticate(request);
 }
 }  // namespace opentxs::agent
@@ -8,9 +8,37 @@
 
 #include "opentxs/opentxs.hpp"
 
+#include "AccountOwnerCache.hpp"
+#include "AsyncLog.hpp"
+#include "Authenticator.hpp"
+#include "Capture.hpp"
+#include "ConcurrentMap.hpp"
+#include "Executor.hpp"
+#include "GCScheduler.hpp"
+#include "HeavyHitters.hpp"
+#include "IdempotencyCache.hpp"
+#include "Interner.hpp"
+#include "PerfProfiler.hpp"
+#include "Protocol.hpp"
+#include "PushBuffer.hpp"
+#include "SessionActivity.hpp"
+#include "ShmServer.hpp"
+#include "Subscriptions.hpp"
+#include "WorkQueue.hpp"
+
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <set>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 namespace pt = boost::property_tree;
 namespace zmq = opentxs::network::zeromq;
@@ -34,19 +62,41 @@ public:
         const std::string& settings_path,
         pt::ptree& config);
 
-    ~Agent() = default;
+    // Stops accepting requests and waits, up to the configured drain timeout,
+    // for in-flight requests and outstanding tasks to finish
+    void Drain();
+    // The metrics the ADMIN METRICS command reports
+    void Metrics(pt::ptree& output) const { collect_metrics(output); }
+    // True once warmup has finished and requests are accepted
+    bool Ready() const { return ready_.load(); }
+
+    ~Agent();
 
 private:
-    // connection id, nym id
-    using TaskData = std::pair<OTData, std::string>;
+    // How requests travel from the frontend socket to the handler threads
+    enum class Dispatch : std::uint8_t {
+        // frontend -> internal dealer -> backend reply sockets
+        Socket = 0,
+        // frontend -> work queue -> worker threads
+        Queue = 1,
+    };
+
+    // connection handle, nym handle, time associated
+    using TaskData =
+        std::tuple<Interner::Handle, Interner::Handle, std::int64_t>;
     // task id, task data
-    using TaskMap = std::map<std::string, TaskData>;
-    // nym id, connection id
-    using NymMap = std::map<std::string, OTData>;
+    using TaskMap = ConcurrentMap<std::string, TaskData>;
+    // connection handle, time a push to the connection first failed or 0
+    using NymData = std::pair<Interner::Handle, std::int64_t>;
+    // nym handle, nym data
+    using NymMap = ConcurrentMap<Interner::Handle, NymData>;
 
+    AsyncLog log_;
     const api::Native& ot_;
     const zmq::Context& zmq_;
     std::atomic<std::int64_t> clients_;
+    const Dispatch dispatch_;
+    const std::unique_ptr<Executor> executor_;
     const OTZMQListenCallback internal_callback_;
     const OTZMQDealerSocket internal_;
     const std::vector<std::string> backend_endpoints_;
@@ -55,6 +105,17 @@ private:
     const std::vector<std::string>& frontend_endpoints_;
     const OTZMQListenCallback frontend_callback_;
     const OTZMQRouterSocket frontend_;
+    // Additional frontend sockets, each bound to its own copy of every
+    // frontend endpoint. Each has its own receive thread and send lock.
+    std::vector<OTZMQListenCallback> shard_callbacks_;
+    std::vector<OTZMQRouterSocket> shards_;
+    // Set when the ipc socket authenticates clients by peer credentials
+    // instead of CURVE
+    const bool local_auth_;
+    const OTZMQListenCallback local_callback_;
+    // Bound to the ipc socket. Its connections are the only ones which may
+    // send admin commands.
+    const OTZMQRouterSocket local_;
     std::atomic<std::int64_t> servers_;
     const std::string& settings_path_;
     const std::string& socket_path_;
@@ -64,52 +125,254 @@ private:
     const std::string server_pubkey_;
     const std::string client_privkey_;
     const std::string client_pubkey_;
-    mutable std::mutex task_lock_;
+    const Authenticator authenticator_;
+    // Every handle stored in the maps below holds a reference
+    Interner connections_;
+    Interner nyms_;
     TaskMap task_connection_map_;
-    mutable std::mutex nym_lock_;
     NymMap nym_connection_map_;
+    // Tasks which haven't finished this long after they were associated are
+    // forgotten, as are nyms whose connection has been unreachable this long.
+    // Zero keeps both.
+    const std::chrono::seconds task_ttl_;
+    std::atomic<std::uint64_t> expired_tasks_;
+    std::atomic<std::uint64_t> unreachable_nyms_;
+    std::mutex task_expiry_lock_;
+    std::condition_variable task_expiry_cv_;
+    bool task_expiry_running_;
+    AccountOwnerCache account_owners_;
+    SessionActivity sessions_;
+    PushBuffer push_buffer_;
+    std::mutex push_lock_;
+    IdempotencyCache idempotency_;
+    // Duplicates refused because the original request was still running
+    std::atomic<std::uint64_t> in_progress_;
+    WorkQueue<OTZMQMessage> work_queue_;
+    std::vector<std::thread> workers_;
+    std::atomic<std::uint64_t> requests_;
+    std::atomic<std::uint64_t> dispatch_time_;
+    std::atomic<std::uint64_t> service_time_;
+    std::atomic<bool> draining_;
+    std::atomic<std::int64_t> in_flight_;
+    std::atomic<std::uint64_t> expired_;
+    // Requests by nym, connection and command type
+    HeavyHitters top_nyms_;
+    HeavyHitters top_connections_;
+    HeavyHitters top_commands_;
+    PerfProfiler profiler_;
+    std::mutex capture_lock_;
+    std::unique_ptr<capture::Writer> capture_;
+    // Checked on every request so the lock is only taken while capturing
+    std::atomic<bool> capturing_;
+    // Requests are refused until warmup finishes
+    std::atomic<bool> ready_;
+    // Milliseconds
+    std::atomic<std::int64_t> warmup_time_;
+    std::atomic<std::uint64_t> preloaded_accounts_;
+    const std::chrono::seconds drain_timeout_;
     const OTZMQListenCallback push_callback_;
     const OTZMQListenCallback task_callback_;
     const OTZMQSubscribeSocket push_subscriber_;
     const OTZMQSubscribeSocket task_subscriber_;
+    std::mutex task_endpoint_lock_;
+    std::set<std::string> task_endpoints_;
+    std::unique_ptr<ShmServer> shm_;
+    std::unique_ptr<GCScheduler> gc_;
+    // Empty if query subscriptions are disabled
+    std::unique_ptr<Subscriptions> subscriptions_;
+    std::thread warmup_;
+    std::mutex wake_lock_;
+    // Reloads of sessions woken by a command, by client index
+    std::map<int, std::future<void>> wakes_;
+    // Runs expire_tasks if task_ttl_ is set
+    std::thread task_expiry_;
 
-    static std::vector<std::string> backend_endpoint_generator();
+    static std::string as_bytes(const Data& data);
+    static OTData as_data(const std::string& bytes);
+    static std::vector<std::string> backend_endpoint_generator(
+        const Dispatch dispatch);
     static std::vector<OTZMQReplySocket> create_backend_sockets(
         const zmq::Context& zmq,
         const std::vector<std::string>& endpoints,
         const OTZMQReplyCallback& callback);
+    template <typename T>
+    static T config_value(
+        const pt::ptree& config,
+        const char* name,
+        const T& defaultValue);
+    static WorkQueue<OTZMQMessage>::Weights connection_weights(
+        const pt::ptree& config);
+    // Appends the header frames from position header onwards, a delimiter
+    // and the body
+    static void copy_frames(
+        const zmq::Message& from,
+        const std::size_t header,
+        zmq::Message& to);
+    static Dispatch dispatch_mode(const pt::ptree& config);
+    static std::unique_ptr<Executor> executor_factory(
+        const api::Native& app,
+        const pt::ptree& config);
+    // Hash of a command without its cookie
+    static std::size_t fingerprint(const proto::RPCCommand& command);
+    static Authenticator::IDs id_list(
+        const pt::ptree& config,
+        const char* name,
+        const std::string& defaultValue);
+    // True for connection ids of clients on the local socket
+    static bool is_local(const zmq::Frame& connection);
+    // Returns the 1-based frontend shard a connection id belongs to, or zero
+    // if it isn't from a shard
+    static std::size_t frontend_shard(const zmq::Frame& connection);
+    static std::int64_t now();
+    // Reduces a serialized RPCCommand to its version, cookie, type and
+    // session
+    static std::string redact(const std::string& command);
+    // Returns a response with the given status to the request and the
+    // reason in an extra frame
+    static OTZMQMessage rejection(
+        const zmq::Message& message,
+        const char* reason,
+        const proto::RPCResponseCode code);
     static int session_to_client_index(const std::uint32_t session);
+    // Endpoint frontend shard number shard binds in place of endpoint, or
+    // empty if there is none
+    static std::string shard_endpoint(
+        const std::string& endpoint,
+        const std::size_t shard);
+    // Returns the message with the routing id prefixed
+    static OTZMQMessage tag_connection(
+        const std::string& prefix,
+        const zmq::Message& message);
+    // Returns a response to the command with a single status
+    static proto::RPCResponse status_response(
+        const proto::RPCCommand& command,
+        const proto::RPCResponseCode code);
+    // True for commands whose results can be subscribed to
+    static bool subscribable(const proto::RPCCommandType type);
+    // Port of a tcp endpoint, or nothing for other transports and wildcard
+    // ports
+    static std::optional<std::uint32_t> tcp_port(const std::string& endpoint);
+    static unsigned int worker_count();
 
-    void schedule_refresh(const int instance) const;
+    void collect_metrics(pt::ptree& output) const;
+    void count_request(
+        const proto::RPCCommand& command,
+        const Data& connectionID);
+    std::size_t pending_tasks() const;
     OTZMQZAPReply zap_handler(const zap::Request& request) const;
 
+    std::string account_owner(
+        const int clientIndex,
+        const std::string& accountID);
+    void admin_handler(const zmq::Message& message);
     void associate_nym(const Data& connection, const std::string& nymID);
     void associate_task(
         const Data& connection,
         const std::string& nymID,
         const std::string& task);
     OTZMQMessage backend_handler(const zmq::Message& message);
+    // Keeps the payload of a push which couldn't be sent. Returns false if
+    // buffering is disabled.
+    bool buffer_push(const std::string& nymID, const zmq::Message& push);
+    // Runs an ADMIN CAPTURE action on the configured capture file and
+    // returns the reply text
+    std::string capture(const std::string& action);
+    void capture_request(const zmq::Message& message);
     void check_task(
         const Data& connectionID,
         const std::string& taskID,
         const std::string& nymID,
         const int clientIndex);
+    // Runs the command and applies its side effects. Sets taskOwners to the
+    // owners of any tasks the command queued.
+    proto::RPCResponse execute(
+        const proto::RPCCommand& command,
+        const Data& connectionID,
+        TaskOwners& taskOwners);
+    // Sends a push for a nym, or buffers it if it can't be sent or older
+    // pushes for the nym are still buffered. Returns true if it was sent.
+    bool deliver_push(const std::string& nymID, zmq::Message& push);
+    // Forgets tasks older than task_ttl_, and nyms whose connection has been
+    // unreachable for longer, once per expiry interval until the agent shuts
+    // down
+    void expire_tasks();
+    // Sends the nym's buffered pushes, oldest first, to the connection the
+    // nym is associated with
+    void flush_pushes(const std::string& nymID);
     void internal_handler(zmq::Message& message);
     void increment_config_value(
         const std::string& section,
         const std::string& entry);
-    OTZMQMessage instantiate_push(const Data& connectionID);
     void frontend_handler(zmq::Message& message);
+    // Returns nothing if storage garbage collection is left to opentxs
+    std::unique_ptr<GCScheduler> gc_scheduler(const pt::ptree& config);
+    void local_handler(zmq::Message& message);
+    // Returns the connection associated with the nym with a reference added,
+    // which the caller releases once it's done sending
+    std::optional<Interner::Handle> nym_connection(const std::string& nymID);
+    // Runs an ADMIN PROFILE action and returns the reply text
+    std::string profile(const std::string& action);
     void push_handler(const zmq::Message& message);
+    // Refreshes the session unless it's hibernating, and hibernates it once
+    // it has been idle long enough
+    void refresh_session(const int instance);
+    void register_tasks(
+        const proto::RPCCommand& command,
+        const proto::RPCResponse& response,
+        const Data& connectionID,
+        const TaskOwners& taskOwners);
+    // Sends a RETRY rejection
+    void reject(const zmq::Message& message, const char* reason);
+    // Reloads a woken session's accounts and refreshes it
+    void rewarm_session(const int index);
+    void run_gc();
+    // Runs a subscribed command for the subscriptions thread
+    bool run_subscription(
+        const std::string& command,
+        Subscriptions::Items& items,
+        Subscriptions::Nyms& nyms);
+    void release_task(const TaskData& task);
     void save_config(const Lock& lock);
+    // Binds the frontend shards to the endpoints frontend_ uses
+    void start_shards(const std::size_t count);
+    void schedule_refresh(const int instance);
+    // Sends a message addressed to a connection over whichever transport
+    // the connection uses
+    bool send_message(zmq::Message& message);
     void send_task_push(
         const Data& connectionID,
         const std::string& taskID,
         const std::string& nymID,
         const bool result);
+    // Records whether the last push to the nym's connection was sent, unless
+    // the nym has been associated with another connection since
+    void set_reachable(
+        const std::string& nymID,
+        const Interner::Handle connection,
+        const bool reachable);
+    bool send_subscription(
+        const std::string& connection,
+        const std::uint64_t id,
+        const std::string& command,
+        const Subscriptions::Items& added,
+        const Subscriptions::Items& removed);
+    void shard_handler(const std::size_t shard, zmq::Message& message);
+    shm::Frames shm_handler(
+        const std::string& connection,
+        shm::Frames&& request);
+    void subscribe_tasks(const std::int64_t clients);
+    // Handles SUBSCRIBE and UNSUBSCRIBE requests
+    void subscription_handler(const zmq::Message& message);
     void task_handler(const zmq::Message& message);
     void update_clients();
     void update_servers();
+    // Wakes the client session a command is for if it's hibernating. The
+    // session is rewarmed in the background and the command doesn't wait.
+    void wake_session(const std::int32_t session);
+    // Preloads every client session, then starts accepting requests and
+    // tells systemd the agent is ready
+    void warmup(const bool preload);
+    void worker();
 
     Agent() = delete;
     Agent(const Agent&) = delete;
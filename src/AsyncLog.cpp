@@ -0,0 +1,201 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "opentxs/opentxs.hpp"
+
+#include "AsyncLog.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace opentxs::agent
+{
+// Must be a power of two
+const std::size_t AsyncLog::capacity_{4096};
+
+bool LogSite::Allow(
+    const std::int64_t now,
+    const std::int64_t interval,
+    const std::int64_t tolerance)
+{
+    if (0 == interval) { return true; }
+
+    // Generic cell rate algorithm: next_ is the theoretical arrival time of
+    // the next message
+    auto expected = next_.load(std::memory_order_relaxed);
+
+    while (true) {
+        const auto base = std::max(expected, now);
+
+        if (tolerance < (base - now)) {
+            ++suppressed_;
+
+            return false;
+        }
+
+        if (next_.compare_exchange_weak(
+                expected, base + interval, std::memory_order_relaxed)) {
+
+            return true;
+        }
+    }
+}
+
+AsyncLog::AsyncLog(const LogLevel level, const std::uint32_t rate)
+    : level_(level)
+    , interval_((0 == rate) ? 0 : (1000000000 / rate))
+    // Allow one second worth of messages in a burst
+    , tolerance_((0 == rate) ? 0 : (1000000000 - interval_))
+    , slots_(capacity_)
+    , enqueue_(0)
+    , dequeue_(0)
+    , dropped_(0)
+    , suppressed_(0)
+    , running_(true)
+    , sleeping_(false)
+    , lock_()
+    , cv_()
+    , thread_()
+{
+    for (std::size_t i{0}; i < capacity_; ++i) {
+        slots_[i].sequence_.store(i, std::memory_order_relaxed);
+    }
+
+    thread_ = std::thread(&AsyncLog::run, this);
+}
+
+std::int64_t AsyncLog::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+bool AsyncLog::pop(Record& output)
+{
+    auto& slot = slots_[dequeue_ & (capacity_ - 1)];
+    const auto sequence = slot.sequence_.load(std::memory_order_acquire);
+
+    if (sequence != (dequeue_ + 1)) { return false; }
+
+    output = std::move(slot.record_);
+    slot.record_ = Record{};
+    slot.sequence_.store(dequeue_ + capacity_, std::memory_order_release);
+    ++dequeue_;
+
+    return true;
+}
+
+void AsyncLog::Post(
+    const LogLevel level,
+    LogSite& site,
+    const char* method,
+    const char* function,
+    Formatter&& formatter)
+{
+    if (false == site.Allow(now(), interval_, tolerance_)) {
+        ++suppressed_;
+
+        return;
+    }
+
+    Record record{};
+    record.level_ = level;
+    record.method_ = method;
+    record.function_ = function;
+    record.suppressed_ = site.TakeSuppressed();
+    record.formatter_ = std::move(formatter);
+
+    if (false == push(std::move(record))) {
+        ++dropped_;
+
+        return;
+    }
+
+    if (sleeping_.load()) { cv_.notify_one(); }
+}
+
+bool AsyncLog::push(Record&& record)
+{
+    auto position = enqueue_.load(std::memory_order_relaxed);
+
+    while (true) {
+        auto& slot = slots_[position & (capacity_ - 1)];
+        const auto sequence = slot.sequence_.load(std::memory_order_acquire);
+
+        if (sequence == position) {
+            if (enqueue_.compare_exchange_weak(
+                    position, position + 1, std::memory_order_relaxed)) {
+                slot.record_ = std::move(record);
+                slot.sequence_.store(position + 1, std::memory_order_release);
+
+                return true;
+            }
+        } else if (sequence < position) {
+            // Queue is full
+
+            return false;
+        } else {
+            position = enqueue_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void AsyncLog::run()
+{
+    Record record{};
+
+    while (true) {
+        if (pop(record)) {
+            write(record);
+
+            continue;
+        }
+
+        if (false == running_.load()) { return; }
+
+        std::unique_lock<std::mutex> lock(lock_);
+        sleeping_.store(true);
+        // Producers don't take the lock, so a notification can be missed.
+        // The timeout bounds the delay when that happens.
+        cv_.wait_for(lock, std::chrono::milliseconds(10));
+        sleeping_.store(false);
+    }
+}
+
+void AsyncLog::write(const Record& record)
+{
+    auto text = record.formatter_();
+
+    if (0 < record.suppressed_) {
+        text += " (" + std::to_string(record.suppressed_) +
+                " similar messages suppressed)";
+    }
+
+    switch (record.level_) {
+        case LogLevel::Output: {
+            LogOutput(record.method_)(record.function_)(": ")(text).Flush();
+        } break;
+        case LogLevel::Normal: {
+            LogNormal(record.method_)(record.function_)(": ")(text).Flush();
+        } break;
+        case LogLevel::Verbose: {
+            LogVerbose(record.method_)(record.function_)(": ")(text).Flush();
+        } break;
+        case LogLevel::Debug:
+        default: {
+            LogDebug(record.method_)(record.function_)(": ")(text).Flush();
+        }
+    }
+}
+
+AsyncLog::~AsyncLog()
+{
+    running_.store(false);
+    cv_.notify_one();
+
+    if (thread_.joinable()) { thread_.join(); }
+}
+}  // namespace opentxs::agent
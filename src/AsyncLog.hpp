@@ -0,0 +1,136 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef ASYNCLOG_HPP_
+#define ASYNCLOG_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Logs from the request path. The level is checked before the formatter (and
+// anything it captures) is constructed, each call site is rate limited
+// separately, and the message text is built on the logging thread.
+#define AGENT_LOG(LOG, LEVEL, ...)                                             \
+    do {                                                                       \
+        static opentxs::agent::LogSite agent_log_site_{};                      \
+                                                                               \
+        if ((LOG).Enabled(LEVEL)) {                                            \
+            (LOG).Post(                                                        \
+                LEVEL, agent_log_site_, OT_METHOD, __FUNCTION__, __VA_ARGS__); \
+        }                                                                      \
+    } while (false)
+
+namespace opentxs::agent
+{
+enum class LogLevel : int {
+    Output = 0,
+    Normal = 1,
+    Verbose = 2,
+    Debug = 3,
+};
+
+// Rate limit state for a single AGENT_LOG call site
+class LogSite
+{
+public:
+    constexpr LogSite()
+        : next_(0)
+        , suppressed_(0)
+    {
+    }
+
+    // Returns false if the site has exceeded its rate
+    bool Allow(
+        const std::int64_t now,
+        const std::int64_t interval,
+        const std::int64_t tolerance);
+    std::uint64_t TakeSuppressed() { return suppressed_.exchange(0); }
+
+    ~LogSite() = default;
+
+private:
+    std::atomic<std::int64_t> next_;
+    std::atomic<std::uint64_t> suppressed_;
+
+    LogSite(const LogSite&) = delete;
+    LogSite(LogSite&&) = delete;
+    LogSite& operator=(const LogSite&) = delete;
+    LogSite& operator=(LogSite&&) = delete;
+};
+
+// Bounded lock-free queue of pending log records drained by one thread
+class AsyncLog
+{
+public:
+    using Formatter = std::function<std::string()>;
+
+    // rate is the number of messages per second allowed from each call site,
+    // or zero for no limit
+    AsyncLog(const LogLevel level, const std::uint32_t rate);
+
+    std::uint64_t Dropped() const { return dropped_.load(); }
+    bool Enabled(const LogLevel level) const { return level <= level_; }
+    std::uint64_t Suppressed() const { return suppressed_.load(); }
+
+    void Post(
+        const LogLevel level,
+        LogSite& site,
+        const char* method,
+        const char* function,
+        Formatter&& formatter);
+
+    ~AsyncLog();
+
+private:
+    struct Record {
+        LogLevel level_{LogLevel::Output};
+        const char* method_{nullptr};
+        const char* function_{nullptr};
+        std::uint64_t suppressed_{0};
+        Formatter formatter_{};
+    };
+
+    struct Slot {
+        std::atomic<std::size_t> sequence_{0};
+        Record record_{};
+    };
+
+    static const std::size_t capacity_;
+
+    const LogLevel level_;
+    const std::int64_t interval_;
+    const std::int64_t tolerance_;
+    std::vector<Slot> slots_;
+    std::atomic<std::size_t> enqueue_;
+    std::size_t dequeue_;
+    std::atomic<std::uint64_t> dropped_;
+    std::atomic<std::uint64_t> suppressed_;
+    std::atomic<bool> running_;
+    std::atomic<bool> sleeping_;
+    std::mutex lock_;
+    std::condition_variable cv_;
+    std::thread thread_;
+
+    static std::int64_t now();
+    static void write(const Record& record);
+
+    bool pop(Record& output);
+    bool push(Record&& record);
+    void run();
+
+    AsyncLog() = delete;
+    AsyncLog(const AsyncLog&) = delete;
+    AsyncLog(AsyncLog&&) = delete;
+    AsyncLog& operator=(const AsyncLog&) = delete;
+    AsyncLog& operator=(AsyncLog&&) = delete;
+};
+}  // namespace opentxs::agent
+#endif  // ASYNCLOG_HPP_
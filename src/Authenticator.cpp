@@ -0,0 +1,113 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "Authenticator.hpp"
+
+#include <charconv>
+
+namespace zmq = opentxs::network::zeromq;
+namespace zap = zmq::zap;
+
+namespace opentxs::agent
+{
+Authenticator::Authenticator(
+    const api::Native& app,
+    const std::string& clientPublicKey,
+    const IDs& localUsers,
+    const IDs& localGroups)
+    : ot_(app)
+    , client_pubkey_(clientPublicKey)
+    , local_users_(localUsers)
+    , local_groups_(localGroups)
+{
+}
+
+OTZMQZAPReply Authenticator::Authenticate(const zap::Request& request) const
+{
+    auto output = zap::Reply::Factory(request);
+
+    if (zap::Mechanism::Curve != request.Mechanism()) {
+        output->SetCode(zap::Status::AuthFailure);
+        output->SetStatus("Unsupported mechanism");
+    } else if (false == CheckCurveKey(request.Credentials().at(0))) {
+        output->SetCode(zap::Status::AuthFailure);
+        output->SetStatus("Incorrect pubkey");
+    } else {
+        output->SetCode(zap::Status::Success);
+        output->SetStatus("OK");
+    }
+
+    return output;
+}
+
+OTZMQZAPReply Authenticator::AuthenticateLocal(
+    const zap::Request& request) const
+{
+    auto output = zap::Reply::Factory(request);
+    const auto peer = ParsePeerAddress(request.Address());
+
+    if (zap::Mechanism::Null != request.Mechanism()) {
+        output->SetCode(zap::Status::AuthFailure);
+        output->SetStatus("Unsupported mechanism");
+    } else if (false == peer.has_value()) {
+        // Not an ipc connection, or libzmq was built without SO_PEERCRED
+        output->SetCode(zap::Status::AuthFailure);
+        output->SetStatus("No peer credentials");
+    } else if (false == CheckPeer(peer.value())) {
+        output->SetCode(zap::Status::AuthFailure);
+        output->SetStatus("Peer not allowed");
+    } else {
+        output->SetCode(zap::Status::Success);
+        output->SetStatus("OK");
+    }
+
+    return output;
+}
+
+bool Authenticator::CheckCurveKey(const zmq::Frame& pubkey) const
+{
+    return client_pubkey_ == ot_.Crypto().Encode().Z85Encode(pubkey);
+}
+
+bool Authenticator::CheckPeer(const PeerCredentials& peer) const
+{
+    return (0 < local_users_.count(peer.uid_)) ||
+           (0 < local_groups_.count(peer.gid_));
+}
+
+std::optional<Authenticator::PeerCredentials> Authenticator::ParsePeerAddress(
+    const std::string& address)
+{
+    // The credentials are the last three fields. Whatever comes before them
+    // depends on the libzmq version.
+    auto start = address.size();
+
+    for (int i{0}; i < 3; ++i) {
+        if (0 == start) { return {}; }
+
+        start = address.rfind(':', start - 1);
+
+        if (std::string::npos == start) { return {}; }
+    }
+
+    std::uint32_t values[3]{};
+    const auto* position = address.data() + start;
+    const auto* end = address.data() + address.size();
+
+    for (auto& value : values) {
+        if ((position == end) || (':' != *position)) { return {}; }
+
+        const auto result = std::from_chars(++position, end, value);
+
+        if (std::errc{} != result.ec) { return {}; }
+
+        position = result.ptr;
+    }
+
+    if (position != end) { return {}; }
+
+    return PeerCredentials{values[0], values[1], values[2]};
+}
+}  // namespace opentxs::agent
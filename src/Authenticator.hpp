@@ -0,0 +1,68 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef AUTHENTICATOR_HPP_
+#define AUTHENTICATOR_HPP_
+
+#include "opentxs/opentxs.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <string>
+
+namespace opentxs::agent
+{
+// Decides ZAP requests for the frontend sockets
+class Authenticator
+{
+public:
+    using IDs = std::set<std::uint32_t>;
+
+    // Credentials of the process at the other end of an ipc connection
+    struct PeerCredentials {
+        std::uint32_t uid_{0};
+        std::uint32_t gid_{0};
+        std::uint32_t pid_{0};
+    };
+
+    // libzmq appends ":<uid>:<gid>:<pid>" from SO_PEERCRED to the peer
+    // address of an ipc connection, for example "localhost:1000:1000:4242"
+    static std::optional<PeerCredentials> ParsePeerAddress(
+        const std::string& address);
+
+    // Local connections are accepted from processes running as any of
+    // localUsers or with a primary group in localGroups
+    Authenticator(
+        const api::Native& app,
+        const std::string& clientPublicKey,
+        const IDs& localUsers,
+        const IDs& localGroups);
+
+    // CURVE connections on the frontend socket
+    OTZMQZAPReply Authenticate(
+        const network::zeromq::zap::Request& request) const;
+    // Unencrypted connections on the local ipc socket
+    OTZMQZAPReply AuthenticateLocal(
+        const network::zeromq::zap::Request& request) const;
+    bool CheckCurveKey(const network::zeromq::Frame& pubkey) const;
+    bool CheckPeer(const PeerCredentials& peer) const;
+
+    ~Authenticator() = default;
+
+private:
+    const api::Native& ot_;
+    const std::string client_pubkey_;
+    const IDs local_users_;
+    const IDs local_groups_;
+
+    Authenticator() = delete;
+    Authenticator(const Authenticator&) = delete;
+    Authenticator(Authenticator&&) = delete;
+    Authenticator& operator=(const Authenticator&) = delete;
+    Authenticator& operator=(Authenticator&&) = delete;
+};
+}  // namespace opentxs::agent
+#endif  // AUTHENTICATOR_HPP_
@@ -0,0 +1,164 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef CONCURRENTMAP_HPP_
+#define CONCURRENTMAP_HPP_
+
+#include <map>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace opentxs::agent
+{
+// Mutex protected map used for the agent's task and nym registries
+template <typename Key, typename Value>
+class ConcurrentMap
+{
+public:
+    ConcurrentMap()
+        : lock_()
+        , map_()
+    {
+    }
+
+    // Returns false if the key was already present
+    bool Add(const Key& key, const Value& value)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+
+        return map_.emplace(key, value).second;
+    }
+
+    bool Erase(const Key& key)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+
+        return 0 < map_.erase(key);
+    }
+
+    std::optional<Value> Find(const Key& key) const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        const auto it = map_.find(key);
+
+        if (map_.end() == it) { return {}; }
+
+        return it->second;
+    }
+
+    // Calls action(value) before releasing the lock, so the value can't be
+    // replaced or erased until action has taken whatever it needs from it
+    template <typename Action>
+    std::optional<Value> Find(const Key& key, const Action& action) const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        const auto it = map_.find(key);
+
+        if (map_.end() == it) { return {}; }
+
+        action(it->second);
+
+        return it->second;
+    }
+
+    // Calls action(value) with the lock held so the value can be changed in
+    // place. Returns false if the key isn't present.
+    template <typename Action>
+    bool Modify(const Key& key, const Action& action)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        const auto it = map_.find(key);
+
+        if (map_.end() == it) { return false; }
+
+        action(it->second);
+
+        return true;
+    }
+
+    // Inserts or replaces. Returns the replaced value.
+    std::optional<Value> Set(const Key& key, const Value& value)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto [it, added] = map_.try_emplace(key, value);
+
+        if (added) { return {}; }
+
+        std::optional<Value> output{std::move(it->second)};
+        it->second = value;
+
+        return output;
+    }
+
+    std::size_t Size() const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+
+        return map_.size();
+    }
+
+    // Removes and returns the value in a single locked operation
+    std::optional<Value> Take(const Key& key)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        const auto it = map_.find(key);
+
+        if (map_.end() == it) { return {}; }
+
+        std::optional<Value> output{std::move(it->second)};
+        map_.erase(it);
+
+        return output;
+    }
+
+    // Removes and returns the entries for which predicate(key, value) is
+    // true among at most limit entries, starting at the first key not less
+    // than position. Sets position to where the next call should continue,
+    // or to nothing once the end has been reached. Visiting the map a batch
+    // at a time keeps the lock from being held for the whole map.
+    template <typename Predicate>
+    std::vector<std::pair<Key, Value>> TakeIf(
+        const Predicate& predicate,
+        std::optional<Key>& position,
+        const std::size_t limit)
+    {
+        std::vector<std::pair<Key, Value>> output{};
+        std::lock_guard<std::mutex> lock(lock_);
+        auto it = position.has_value() ? map_.lower_bound(position.value())
+                                       : map_.begin();
+
+        for (std::size_t i{0}; (i < limit) && (it != map_.end()); ++i) {
+            if (predicate(it->first, it->second)) {
+                output.emplace_back(it->first, std::move(it->second));
+                it = map_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        if (map_.end() == it) {
+            position.reset();
+        } else {
+            position = it->first;
+        }
+
+        return output;
+    }
+
+    ~ConcurrentMap() = default;
+
+private:
+    mutable std::mutex lock_;
+    std::map<Key, Value> map_;
+
+    ConcurrentMap(const ConcurrentMap&) = delete;
+    ConcurrentMap(ConcurrentMap&&) = delete;
+    ConcurrentMap& operator=(const ConcurrentMap&) = delete;
+    ConcurrentMap& operator=(ConcurrentMap&&) = delete;
+};
+}  // namespace opentxs::agent
+#endif  // CONCURRENTMAP_HPP_
@@ -0,0 +1,52 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef EXECUTOR_HPP_
+#define EXECUTOR_HPP_
+
+#include "opentxs/opentxs.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace opentxs::agent
+{
+// Everything the agent needs from the wallet to run a command and follow
+// the tasks it queues
+class Executor
+{
+public:
+    // Owner nym of an account in a client session, or empty if unknown
+    virtual std::string AccountOwner(
+        const int clientIndex,
+        const std::string& accountID) const = 0;
+    // Loads the session's nyms, contracts, accounts and payment workflows so
+    // the first commands after startup don't wait on storage. Returns the
+    // ids of the session's accounts.
+    virtual std::vector<std::string> Preload(const int clientIndex) const = 0;
+    virtual proto::RPCResponse RPC(
+        const proto::RPCCommand& command) const = 0;
+    virtual ThreadStatus Status(
+        const int clientIndex,
+        const std::string& taskID) const = 0;
+    // TaskComplete publisher endpoints covering the given number of client
+    // sessions
+    virtual std::vector<std::string> TaskEndpoints(
+        const std::int64_t clients) const = 0;
+
+    virtual ~Executor() = default;
+
+protected:
+    Executor() = default;
+
+private:
+    Executor(const Executor&) = delete;
+    Executor(Executor&&) = delete;
+    Executor& operator=(const Executor&) = delete;
+    Executor& operator=(Executor&&) = delete;
+};
+}  // namespace opentxs::agent
+#endif  // EXECUTOR_HPP_
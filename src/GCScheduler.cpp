@@ -0,0 +1,119 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "GCScheduler.hpp"
+
+#include <algorithm>
+
+namespace opentxs::agent
+{
+GCScheduler::GCScheduler(
+    const Settings& settings,
+    const LoadFunction& load,
+    const RunFunction& run)
+    : settings_(settings)
+    , load_(load)
+    , run_(run)
+    , lock_()
+    , cv_()
+    , running_(true)
+    , stats_()
+    , due_(Clock::now() + settings.interval_)
+    , thread_()
+{
+    thread_ = std::thread(&GCScheduler::run, this);
+}
+
+void GCScheduler::collect(const Clock::time_point now, const bool quiet)
+{
+    const auto delay =
+        std::chrono::duration_cast<std::chrono::seconds>(now - due_);
+    const auto start = Clock::now();
+    run_();
+    const auto finish = Clock::now();
+    const auto duration =
+        std::chrono::duration_cast<std::chrono::milliseconds>(finish - start);
+
+    std::lock_guard<std::mutex> lock(lock_);
+    ++stats_.runs_;
+
+    if (delay >= settings_.check_interval_) {
+        ++stats_.deferred_;
+        stats_.total_delay_ += delay;
+    }
+
+    if (false == quiet) { ++stats_.forced_; }
+
+    stats_.waiting_ = std::chrono::seconds(0);
+    stats_.last_duration_ = duration;
+    stats_.max_duration_ = std::max(stats_.max_duration_, duration);
+    stats_.total_duration_ += duration;
+    // The interval is measured between collections, so a late one doesn't
+    // make the next one come sooner
+    due_ = finish + settings_.interval_;
+}
+
+void GCScheduler::run()
+{
+    auto previous = load_();
+    auto sampled = Clock::now();
+    std::unique_lock<std::mutex> lock(lock_);
+
+    while (true) {
+        cv_.wait_for(lock, settings_.check_interval_, [this]() {
+            return false == running_;
+        });
+
+        if (false == running_) { return; }
+
+        const auto due = due_;
+        lock.unlock();
+        const auto now = Clock::now();
+        const auto current = load_();
+        const auto elapsed =
+            std::chrono::duration_cast<std::chrono::milliseconds>(now - sampled)
+                .count();
+        const auto handled = current.requests_ - previous.requests_;
+        const auto rate = (0 < elapsed) ? (handled * 1000 / elapsed) : handled;
+        previous = current;
+        sampled = now;
+
+        if (now >= due) {
+            const bool quiet = (rate <= settings_.max_request_rate_) &&
+                               (current.in_flight_ <= settings_.max_in_flight_);
+
+            if (quiet || (now >= (due + settings_.max_delay_))) {
+                collect(now, quiet);
+            } else {
+                lock.lock();
+                stats_.waiting_ =
+                    std::chrono::duration_cast<std::chrono::seconds>(now - due);
+                lock.unlock();
+            }
+        }
+
+        lock.lock();
+    }
+}
+
+GCScheduler::Stats GCScheduler::Snapshot() const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+
+    return stats_;
+}
+
+GCScheduler::~GCScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        running_ = false;
+    }
+
+    cv_.notify_all();
+
+    if (thread_.joinable()) { thread_.join(); }
+}
+}  // namespace opentxs::agent
@@ -0,0 +1,94 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef GCSCHEDULER_HPP_
+#define GCSCHEDULER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace opentxs::agent
+{
+// Runs storage garbage collection in place of the fixed opentxs schedule.
+//
+// Once the interval has passed since the last collection, a collection is
+// due. It starts at the first check where the request rate and the number of
+// requests in flight are both at or below their limits. If the agent stays
+// busy, it starts anyway once it has been delayed by max delay, so
+// collection can be postponed but never skipped.
+class GCScheduler
+{
+public:
+    struct Load {
+        // Requests handled since startup
+        std::uint64_t requests_{0};
+        // Requests received and not yet answered
+        std::int64_t in_flight_{0};
+    };
+
+    struct Settings {
+        std::chrono::seconds interval_{3600};
+        std::chrono::seconds max_delay_{600};
+        // Requests per second
+        std::uint64_t max_request_rate_{20};
+        std::int64_t max_in_flight_{4};
+        std::chrono::milliseconds check_interval_{1000};
+    };
+
+    struct Stats {
+        std::uint64_t runs_{0};
+        // Runs which started after being held back by load
+        std::uint64_t deferred_{0};
+        // Runs started at max delay while the agent was still busy
+        std::uint64_t forced_{0};
+        // How long the collection due now has been held back
+        std::chrono::seconds waiting_{0};
+        std::chrono::seconds total_delay_{0};
+        std::chrono::milliseconds last_duration_{0};
+        std::chrono::milliseconds max_duration_{0};
+        std::chrono::milliseconds total_duration_{0};
+    };
+
+    using LoadFunction = std::function<Load()>;
+    using RunFunction = std::function<void()>;
+
+    GCScheduler(
+        const Settings& settings,
+        const LoadFunction& load,
+        const RunFunction& run);
+
+    Stats Snapshot() const;
+
+    ~GCScheduler();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    const Settings settings_;
+    const LoadFunction load_;
+    const RunFunction run_;
+    mutable std::mutex lock_;
+    std::condition_variable cv_;
+    bool running_;
+    Stats stats_;
+    Clock::time_point due_;
+    std::thread thread_;
+
+    void collect(const Clock::time_point now, const bool quiet);
+    void run();
+
+    GCScheduler() = delete;
+    GCScheduler(const GCScheduler&) = delete;
+    GCScheduler(GCScheduler&&) = delete;
+    GCScheduler& operator=(const GCScheduler&) = delete;
+    GCScheduler& operator=(GCScheduler&&) = delete;
+};
+}  // namespace opentxs::agent
+#endif  // GCSCHEDULER_HPP_
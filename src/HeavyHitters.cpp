@@ -0,0 +1,163 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "HeavyHitters.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Stored counts are rescaled before the scale factor gets large enough to
+// cost precision
+#define MAX_SCALE 4294967296.0
+
+namespace opentxs::agent
+{
+HeavyHitters::HeavyHitters(
+    const std::size_t capacity,
+    const std::chrono::seconds halfLife)
+    : capacity_(capacity)
+    , half_life_(halfLife)
+    , lock_()
+    , heap_()
+    , position_()
+    , epoch_(Clock::now())
+    , total_(0.0)
+{
+    heap_.reserve(capacity_);
+    position_.reserve(capacity_);
+}
+
+void HeavyHitters::Add(const std::string& input)
+{
+    if (false == Enabled()) { return; }
+
+    const auto key = input.substr(0, MaxKeySize);
+    const auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(lock_);
+    auto weight = scale(now);
+
+    if (MAX_SCALE < weight) {
+        for (auto& entry : heap_) {
+            entry.count_ /= weight;
+            entry.error_ /= weight;
+        }
+
+        total_ /= weight;
+        epoch_ = now;
+        weight = 1.0;
+    }
+
+    total_ += weight;
+    const auto it = position_.find(key);
+
+    if (position_.end() != it) {
+        heap_.at(it->second).count_ += weight;
+        sift_down(it->second);
+
+        return;
+    }
+
+    if (heap_.size() < capacity_) {
+        position_.emplace(key, heap_.size());
+        heap_.push_back(Entry{key, weight, 0.0});
+        sift_up(heap_.size() - 1);
+
+        return;
+    }
+
+    // Replace the key with the lowest count
+    auto& minimum = heap_.front();
+    position_.erase(minimum.key_);
+    minimum.key_ = key;
+    minimum.error_ = minimum.count_;
+    minimum.count_ += weight;
+    position_.emplace(key, 0);
+    sift_down(0);
+}
+
+double HeavyHitters::scale(const Clock::time_point now) const
+{
+    if (0 == half_life_.count()) { return 1.0; }
+
+    const auto elapsed =
+        std::chrono::duration_cast<std::chrono::duration<double>>(now - epoch_)
+            .count();
+
+    return std::exp2(elapsed / static_cast<double>(half_life_.count()));
+}
+
+void HeavyHitters::sift_down(std::size_t position)
+{
+    while (true) {
+        const auto left = 2 * position + 1;
+        const auto right = left + 1;
+        auto smallest = position;
+
+        if ((left < heap_.size()) &&
+            (heap_.at(left).count_ < heap_.at(smallest).count_)) {
+            smallest = left;
+        }
+
+        if ((right < heap_.size()) &&
+            (heap_.at(right).count_ < heap_.at(smallest).count_)) {
+            smallest = right;
+        }
+
+        if (smallest == position) { return; }
+
+        swap(position, smallest);
+        position = smallest;
+    }
+}
+
+void HeavyHitters::sift_up(std::size_t position)
+{
+    while (0 < position) {
+        const auto parent = (position - 1) / 2;
+
+        if (heap_.at(parent).count_ <= heap_.at(position).count_) { return; }
+
+        swap(position, parent);
+        position = parent;
+    }
+}
+
+void HeavyHitters::swap(const std::size_t lhs, const std::size_t rhs)
+{
+    std::swap(heap_.at(lhs), heap_.at(rhs));
+    position_[heap_.at(lhs).key_] = lhs;
+    position_[heap_.at(rhs).key_] = rhs;
+}
+
+std::vector<HeavyHitters::Entry> HeavyHitters::Top(
+    const std::size_t count) const
+{
+    const auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(lock_);
+    const auto factor = scale(now);
+    auto output = heap_;
+    std::sort(
+        output.begin(), output.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.count_ > rhs.count_;
+        });
+
+    if (output.size() > count) { output.resize(count); }
+
+    for (auto& entry : output) {
+        entry.count_ /= factor;
+        entry.error_ /= factor;
+    }
+
+    return output;
+}
+
+double HeavyHitters::Total() const
+{
+    const auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(lock_);
+
+    return total_ / scale(now);
+}
+}  // namespace opentxs::agent
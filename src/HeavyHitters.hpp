@@ -0,0 +1,82 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef HEAVYHITTERS_HPP_
+#define HEAVYHITTERS_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace opentxs::agent
+{
+// Space-saving top-K sketch of the most frequent keys in a stream.
+//
+// At most capacity keys are counted. A key that isn't counted replaces the
+// one with the lowest count and inherits that count as its error, so a
+// reported count overestimates the true one by at most the error. Counts
+// decay by half every half life, which makes the sketch follow current load
+// rather than the total since startup. Memory and the cost of Add don't
+// depend on how many distinct keys the stream has.
+class HeavyHitters
+{
+public:
+    struct Entry {
+        std::string key_{};
+        // Decayed count, including the error
+        double count_{0.0};
+        double error_{0.0};
+    };
+
+    // Longer keys are truncated so each counter has a fixed size
+    static const std::size_t MaxKeySize{64};
+
+    // A capacity of zero disables counting. A half life of zero disables
+    // decay.
+    HeavyHitters(
+        const std::size_t capacity,
+        const std::chrono::seconds halfLife);
+
+    void Add(const std::string& key);
+    bool Enabled() const { return 0 < capacity_; }
+    // Returns up to count entries, highest count first
+    std::vector<Entry> Top(const std::size_t count) const;
+    // Decayed count of every key added
+    double Total() const;
+
+    ~HeavyHitters() = default;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    const std::size_t capacity_;
+    const std::chrono::seconds half_life_;
+    mutable std::mutex lock_;
+    // Min-heap on count_
+    std::vector<Entry> heap_;
+    // key, position in heap_
+    std::unordered_map<std::string, std::size_t> position_;
+    // Counts are stored scaled up by the decay since epoch_ so adding doesn't
+    // have to touch every counter. They're scaled back when read.
+    Clock::time_point epoch_;
+    double total_;
+
+    // Factor stored counts are scaled by at time now
+    double scale(const Clock::time_point now) const;
+    void sift_down(std::size_t position);
+    void sift_up(std::size_t position);
+    void swap(const std::size_t lhs, const std::size_t rhs);
+
+    HeavyHitters() = delete;
+    HeavyHitters(const HeavyHitters&) = delete;
+    HeavyHitters(HeavyHitters&&) = delete;
+    HeavyHitters& operator=(const HeavyHitters&) = delete;
+    HeavyHitters& operator=(HeavyHitters&&) = delete;
+};
+}  // namespace opentxs::agent
+#endif  // HEAVYHITTERS_HPP_
@@ -0,0 +1,141 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "IdempotencyCache.hpp"
+
+#include <stdexcept>
+
+namespace opentxs::agent
+{
+IdempotencyCache::IdempotencyCache(
+    const std::chrono::seconds ttl,
+    const std::size_t capacity)
+    : ttl_(ttl)
+    , capacity_(capacity)
+    , lock_()
+    , map_()
+    , finished_()
+    , started_()
+    , next_id_(0)
+    , hits_(0)
+{
+}
+
+void IdempotencyCache::Abandon(const std::string& key, const std::uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = map_.find(key);
+
+    // Already dropped for taking too long
+    if ((map_.end() == it) || (id != it->second.id_)) { return; }
+
+    auto& entry = it->second;
+
+    OT_ASSERT(entry.promise_);
+
+    entry.promise_->set_exception(std::make_exception_ptr(
+        std::runtime_error("Idempotent request failed")));
+    map_.erase(it);
+}
+
+void IdempotencyCache::Finish(
+    const std::string& key,
+    const std::uint64_t id,
+    const Result& result)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = map_.find(key);
+
+    // Already dropped for taking too long
+    if ((map_.end() == it) || (id != it->second.id_)) { return; }
+
+    auto& entry = it->second;
+
+    OT_ASSERT(entry.promise_);
+
+    entry.promise_->set_value(result);
+    entry.promise_.reset();
+    entry.expires_ = std::chrono::steady_clock::now() + ttl_;
+    finished_.push_back(key);
+}
+
+void IdempotencyCache::prune(const Time now)
+{
+    while (false == finished_.empty()) {
+        const auto it = map_.find(finished_.front());
+
+        OT_ASSERT(map_.end() != it);
+
+        const bool expired = (it->second.expires_ <= now);
+
+        if ((false == expired) && (finished_.size() <= capacity_)) { break; }
+
+        map_.erase(it);
+        finished_.pop_front();
+    }
+
+    // Requests still waiting on an entry which never finished get a broken
+    // promise when it's dropped
+    while (false == started_.empty()) {
+        const auto& [id, key] = started_.front();
+        const auto it = map_.find(key);
+
+        if ((map_.end() != it) && (id == it->second.id_)) {
+            if (false == bool(it->second.promise_)) {
+                // Finished, so finished_ takes care of it
+            } else if ((it->second.started_ + ttl_) <= now) {
+                map_.erase(it);
+            } else {
+                break;
+            }
+        }
+
+        started_.pop_front();
+    }
+}
+
+std::size_t IdempotencyCache::Size() const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+
+    return map_.size();
+}
+
+IdempotencyCache::Claim IdempotencyCache::Start(
+    const std::string& key,
+    const std::size_t fingerprint)
+{
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(lock_);
+    prune(now);
+    auto [it, added] = map_.try_emplace(key);
+    auto& entry = it->second;
+    Claim output{};
+
+    if (false == added) {
+        if (fingerprint != entry.fingerprint_) {
+            output.status_ = Status::Conflict;
+
+            return output;
+        }
+
+        ++hits_;
+        output.status_ = Status::Replay;
+        output.future_ = entry.future_;
+
+        return output;
+    }
+
+    entry.id_ = ++next_id_;
+    entry.fingerprint_ = fingerprint;
+    entry.started_ = now;
+    entry.promise_ = std::make_unique<std::promise<Result>>();
+    entry.future_ = entry.promise_->get_future().share();
+    started_.emplace_back(entry.id_, key);
+    output.id_ = entry.id_;
+
+    return output;
+}
+}  // namespace opentxs::agent
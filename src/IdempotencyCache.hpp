@@ -0,0 +1,111 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef IDEMPOTENCYCACHE_HPP_
+#define IDEMPOTENCYCACHE_HPP_
+
+#include "opentxs/opentxs.hpp"
+
+#include "Protocol.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace opentxs::agent
+{
+// Recent idempotency keys and the responses of the requests which used them.
+// A retry either waits for the original request to finish or gets its stored
+// response, and never runs the command a second time.
+class IdempotencyCache
+{
+public:
+    // response, owners of any queued tasks
+    using Result = std::pair<proto::RPCResponse, TaskOwners>;
+    using Future = std::shared_future<Result>;
+
+    enum class Status : std::uint8_t {
+        // The key is new. The caller must run the command and call Finish or
+        // Abandon.
+        Run = 0,
+        // The key was used before by the same command. Its result is in
+        // future_, which throws if the original request was abandoned.
+        Replay = 1,
+        // The key was used before by a different command
+        Conflict = 2,
+    };
+
+    struct Claim {
+        Status status_{Status::Run};
+        Future future_{};
+        // Identifies the entry to Finish and Abandon
+        std::uint64_t id_{0};
+    };
+
+    // Entries are kept for ttl after they finish, and dropped if they
+    // haven't finished ttl after they started. The oldest finished entries
+    // are dropped early once there are more than capacity.
+    IdempotencyCache(
+        const std::chrono::seconds ttl,
+        const std::size_t capacity);
+
+    // Drops an entry registered by Start whose command failed. Requests
+    // waiting on it get an exception.
+    void Abandon(const std::string& key, const std::uint64_t id);
+    // Sets the result for an entry registered by Start
+    void Finish(
+        const std::string& key,
+        const std::uint64_t id,
+        const Result& result);
+    std::uint64_t Hits() const { return hits_.load(); }
+    std::size_t Size() const;
+    // Looks up the key, registering it if it's new. The fingerprint
+    // identifies the command so a key reused for a different command is
+    // refused.
+    Claim Start(const std::string& key, const std::size_t fingerprint);
+
+    ~IdempotencyCache() = default;
+
+private:
+    using Time = std::chrono::steady_clock::time_point;
+
+    struct Entry {
+        std::uint64_t id_{0};
+        std::size_t fingerprint_{0};
+        Time started_{};
+        // Set when the result is available
+        Time expires_{};
+        std::unique_ptr<std::promise<Result>> promise_{};
+        Future future_{};
+    };
+
+    const std::chrono::seconds ttl_;
+    const std::size_t capacity_;
+    mutable std::mutex lock_;
+    std::map<std::string, Entry> map_;
+    // Keys of finished entries in expiry order
+    std::deque<std::string> finished_;
+    // Ids and keys of entries in the order they started
+    std::deque<std::pair<std::uint64_t, std::string>> started_;
+    std::uint64_t next_id_;
+    std::atomic<std::uint64_t> hits_;
+
+    void prune(const Time now);
+
+    IdempotencyCache() = delete;
+    IdempotencyCache(const IdempotencyCache&) = delete;
+    IdempotencyCache(IdempotencyCache&&) = delete;
+    IdempotencyCache& operator=(const IdempotencyCache&) = delete;
+    IdempotencyCache& operator=(IdempotencyCache&&) = delete;
+};
+}  // namespace opentxs::agent
+#endif  // IDEMPOTENCYCACHE_HPP_
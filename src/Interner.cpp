@@ -0,0 +1,105 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "opentxs/opentxs.hpp"
+
+#include "Interner.hpp"
+
+namespace opentxs::agent
+{
+Interner::Interner()
+    : lock_()
+    , slots_()
+    , index_()
+    , free_()
+{
+}
+
+std::optional<Interner::Handle> Interner::Find(const std::string& value) const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    const auto it = index_.find(value);
+
+    if (index_.end() == it) { return {}; }
+
+    return it->second;
+}
+
+Interner::Handle Interner::Intern(const std::string& value)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    const auto it = index_.find(value);
+
+    if (index_.end() != it) {
+        ++slots_[it->second].references_;
+
+        return it->second;
+    }
+
+    Handle handle{0};
+
+    if (free_.empty()) {
+        handle = static_cast<Handle>(slots_.size());
+        slots_.emplace_back();
+    } else {
+        handle = free_.back();
+        free_.pop_back();
+    }
+
+    auto& slot = slots_[handle];
+    slot.value_ = value;
+    slot.references_ = 1;
+    index_.emplace(slot.value_, handle);
+
+    return handle;
+}
+
+void Interner::Reference(const Handle handle)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+
+    OT_ASSERT(handle < slots_.size());
+
+    auto& slot = slots_[handle];
+
+    OT_ASSERT(0 < slot.references_);
+
+    ++slot.references_;
+}
+
+void Interner::Release(const Handle handle)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+
+    OT_ASSERT(handle < slots_.size());
+
+    auto& slot = slots_[handle];
+
+    OT_ASSERT(0 < slot.references_);
+
+    if (0 < --slot.references_) { return; }
+
+    index_.erase(slot.value_);
+    slot.value_.clear();
+    slot.value_.shrink_to_fit();
+    free_.push_back(handle);
+}
+
+std::string Interner::Resolve(const Handle handle) const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+
+    OT_ASSERT(handle < slots_.size());
+
+    return slots_[handle].value_;
+}
+
+std::size_t Interner::Size() const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+
+    return index_.size();
+}
+}  // namespace opentxs::agent
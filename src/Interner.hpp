@@ -0,0 +1,61 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef INTERNER_HPP_
+#define INTERNER_HPP_
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace opentxs::agent
+{
+// Stores each distinct connection or nym id once and hands out small
+// reference counted handles to it, so the registries can hold and compare
+// integers. Values are only turned back into strings at the socket edge.
+class Interner
+{
+public:
+    using Handle = std::uint32_t;
+
+    Interner();
+
+    // Looks up a value without adding a reference
+    std::optional<Handle> Find(const std::string& value) const;
+    // Returns the handle for value and adds a reference to it
+    Handle Intern(const std::string& value);
+    // Adds a reference to a handle which already has one
+    void Reference(const Handle handle);
+    // Drops a reference. The handle may be reused once none remain.
+    void Release(const Handle handle);
+    std::string Resolve(const Handle handle) const;
+    std::size_t Size() const;
+
+    ~Interner() = default;
+
+private:
+    struct Slot {
+        std::string value_{};
+        std::uint32_t references_{0};
+    };
+
+    mutable std::mutex lock_;
+    // deque so the views in index_ stay valid as slots are added
+    std::deque<Slot> slots_;
+    std::unordered_map<std::string_view, Handle> index_;
+    std::vector<Handle> free_;
+
+    Interner(const Interner&) = delete;
+    Interner(Interner&&) = delete;
+    Interner& operator=(const Interner&) = delete;
+    Interner& operator=(Interner&&) = delete;
+};
+}  // namespace opentxs::agent
+#endif  // INTERNER_HPP_
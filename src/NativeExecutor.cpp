@@ -0,0 +1,77 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "NativeExecutor.hpp"
+
+namespace opentxs::agent
+{
+NativeExecutor::NativeExecutor(const api::Native& app)
+    : Executor()
+    , ot_(app)
+{
+}
+
+std::string NativeExecutor::AccountOwner(
+    const int clientIndex,
+    const std::string& accountID) const
+{
+    return ot_.Client(clientIndex)
+        .Storage()
+        .AccountOwner(Identifier::Factory(accountID))
+        ->str();
+}
+
+std::vector<std::string> NativeExecutor::Preload(const int clientIndex) const
+{
+    const auto& client = ot_.Client(clientIndex);
+    const auto& wallet = client.Wallet();
+    const auto& storage = client.Storage();
+    std::vector<std::string> output{};
+
+    for (const auto& nymID : wallet.LocalNyms()) {
+        wallet.Nym(nymID);
+        storage.PaymentWorkflowList(nymID->str());
+    }
+
+    for (const auto& server : wallet.ServerList()) {
+        wallet.Server(Identifier::Factory(server.first));
+    }
+
+    for (const auto& unit : wallet.UnitDefinitionList()) {
+        wallet.UnitDefinition(Identifier::Factory(unit.first));
+    }
+
+    for (const auto& account : storage.AccountList()) {
+        wallet.Account(Identifier::Factory(account.first));
+        output.emplace_back(account.first);
+    }
+
+    return output;
+}
+
+proto::RPCResponse NativeExecutor::RPC(const proto::RPCCommand& command) const
+{
+    return ot_.RPC(command);
+}
+
+ThreadStatus NativeExecutor::Status(
+    const int clientIndex,
+    const std::string& taskID) const
+{
+    return ot_.Client(clientIndex).Sync().Status(Identifier::Factory(taskID));
+}
+
+std::vector<std::string> NativeExecutor::TaskEndpoints(
+    const std::int64_t clients) const
+{
+    std::vector<std::string> output{};
+
+    for (int i{0}; i < clients; ++i) {
+        output.emplace_back(ot_.Client(i).Endpoints().TaskComplete());
+    }
+
+    return output;
+}
+}  // namespace opentxs::agent
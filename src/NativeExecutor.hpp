@@ -0,0 +1,41 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef NATIVEEXECUTOR_HPP_
+#define NATIVEEXECUTOR_HPP_
+
+#include "Executor.hpp"
+
+namespace opentxs::agent
+{
+// Runs commands against the opentxs sessions
+class NativeExecutor final : public Executor
+{
+public:
+    explicit NativeExecutor(const api::Native& app);
+
+    std::string AccountOwner(
+        const int clientIndex,
+        const std::string& accountID) const override;
+    std::vector<std::string> Preload(const int clientIndex) const override;
+    proto::RPCResponse RPC(const proto::RPCCommand& command) const override;
+    ThreadStatus Status(const int clientIndex, const std::string& taskID)
+        const override;
+    std::vector<std::string> TaskEndpoints(
+        const std::int64_t clients) const override;
+
+    ~NativeExecutor() override = default;
+
+private:
+    const api::Native& ot_;
+
+    NativeExecutor() = delete;
+    NativeExecutor(const NativeExecutor&) = delete;
+    NativeExecutor(NativeExecutor&&) = delete;
+    NativeExecutor& operator=(const NativeExecutor&) = delete;
+    NativeExecutor& operator=(NativeExecutor&&) = delete;
+};
+}  // namespace opentxs::agent
+#endif  // NATIVEEXECUTOR_HPP_
@@ -0,0 +1,209 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "PerfProfiler.hpp"
+
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+namespace opentxs::agent
+{
+// The hardware counters of one thread, read together as a group
+class PerfProfiler::ThreadCounters
+{
+public:
+    static ThreadCounters& Get()
+    {
+        thread_local ThreadCounters counters{};
+
+        return counters;
+    }
+
+    const std::string& Error() const { return error_; }
+
+    bool Read(std::uint64_t (&values)[3]) const
+    {
+        if (0 > leader_) { return false; }
+
+        // PERF_FORMAT_GROUP layout: the count, then a value per event in the
+        // order the events were opened
+        std::uint64_t buffer[4]{};
+        const auto bytes = ::read(leader_, buffer, sizeof(buffer));
+
+        if (static_cast<ssize_t>(sizeof(buffer)) != bytes) { return false; }
+
+        values[0] = buffer[1];
+        values[1] = buffer[2];
+        values[2] = buffer[3];
+
+        return true;
+    }
+
+    ~ThreadCounters()
+    {
+        for (const auto fd : fds_) {
+            if (0 <= fd) { ::close(fd); }
+        }
+    }
+
+private:
+    int fds_[3];
+    int leader_;
+    std::string error_;
+
+    static int open(const std::uint64_t config, const int group)
+    {
+        struct perf_event_attr attributes {
+        };
+        attributes.size = sizeof(attributes);
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.config = config;
+        attributes.read_format = PERF_FORMAT_GROUP;
+        attributes.exclude_hv = 1;
+        auto fd = static_cast<int>(
+            ::syscall(SYS_perf_event_open, &attributes, 0, -1, group, 0));
+
+        if ((0 > fd) && ((EACCES == errno) || (EPERM == errno))) {
+            // perf_event_paranoid 2 only allows counting user space
+            attributes.exclude_kernel = 1;
+            fd = static_cast<int>(
+                ::syscall(SYS_perf_event_open, &attributes, 0, -1, group, 0));
+        }
+
+        return fd;
+    }
+
+    ThreadCounters()
+        : fds_{-1, -1, -1}
+        , leader_(-1)
+        , error_()
+    {
+        const std::uint64_t events[3]{PERF_COUNT_HW_CPU_CYCLES,
+                                      PERF_COUNT_HW_INSTRUCTIONS,
+                                      PERF_COUNT_HW_CACHE_MISSES};
+
+        for (int i{0}; i < 3; ++i) {
+            fds_[i] = open(events[i], fds_[0]);
+
+            if (0 > fds_[i]) {
+                error_ =
+                    std::string("perf_event_open: ") + std::strerror(errno);
+
+                return;
+            }
+        }
+
+        leader_ = fds_[0];
+    }
+    ThreadCounters(const ThreadCounters&) = delete;
+    ThreadCounters(ThreadCounters&&) = delete;
+    ThreadCounters& operator=(const ThreadCounters&) = delete;
+    ThreadCounters& operator=(ThreadCounters&&) = delete;
+};
+
+static std::int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static void switches(std::int64_t& voluntary, std::int64_t& involuntary)
+{
+    struct rusage usage {
+    };
+
+    if (0 == ::getrusage(RUSAGE_THREAD, &usage)) {
+        voluntary = usage.ru_nvcsw;
+        involuntary = usage.ru_nivcsw;
+    }
+}
+
+PerfProfiler::PerfProfiler()
+    : enabled_(false)
+    , lock_()
+    , counters_()
+{
+}
+
+PerfProfiler::Reading PerfProfiler::Begin() const
+{
+    Reading output{};
+
+    if (false == enabled_.load(std::memory_order_relaxed)) { return output; }
+
+    output.active_ = true;
+    switches(output.voluntary_switches_, output.involuntary_switches_);
+    std::uint64_t values[3]{};
+    output.hardware_ = ThreadCounters::Get().Read(values);
+    output.cycles_ = values[0];
+    output.instructions_ = values[1];
+    output.cache_misses_ = values[2];
+    // Last, so the time doesn't include taking the readings
+    output.time_ = now();
+
+    return output;
+}
+
+void PerfProfiler::Disable() { enabled_.store(false); }
+
+std::string PerfProfiler::Enable()
+{
+    enabled_.store(true);
+
+    // Worker threads open their own counters, so this only checks whether
+    // the kernel allows them
+    return ThreadCounters::Get().Error();
+}
+
+void PerfProfiler::End(const Reading& start, const Key& key)
+{
+    if (false == start.active_) { return; }
+
+    const auto time = now();
+    std::uint64_t values[3]{};
+    const bool hardware =
+        start.hardware_ && ThreadCounters::Get().Read(values);
+    std::int64_t voluntary{start.voluntary_switches_};
+    std::int64_t involuntary{start.involuntary_switches_};
+    switches(voluntary, involuntary);
+
+    std::lock_guard<std::mutex> lock(lock_);
+    auto& counters = counters_[key];
+    ++counters.calls_;
+    counters.wall_ns_ += static_cast<std::uint64_t>(time - start.time_);
+    counters.voluntary_switches_ +=
+        static_cast<std::uint64_t>(voluntary - start.voluntary_switches_);
+    counters.involuntary_switches_ +=
+        static_cast<std::uint64_t>(involuntary - start.involuntary_switches_);
+
+    if (hardware) {
+        ++counters.measured_calls_;
+        counters.cycles_ += values[0] - start.cycles_;
+        counters.instructions_ += values[1] - start.instructions_;
+        counters.cache_misses_ += values[2] - start.cache_misses_;
+    }
+}
+
+void PerfProfiler::Reset()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    counters_.clear();
+}
+
+std::map<PerfProfiler::Key, PerfProfiler::Counters> PerfProfiler::Snapshot()
+    const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+
+    return counters_;
+}
+}  // namespace opentxs::agent
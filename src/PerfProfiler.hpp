@@ -0,0 +1,84 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef PERFPROFILER_HPP_
+#define PERFPROFILER_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace opentxs::agent
+{
+// Opt in per command profiling with hardware performance counters.
+//
+// While enabled, each call between Begin and End is measured on the calling
+// thread: cycles, instructions and cache misses from perf_event_open, and
+// voluntary and involuntary context switches from getrusage. Voluntary
+// switches mostly mean the call blocked, on a lock or on I/O. The counters
+// of each thread are opened the first time the thread is measured.
+//
+// While disabled, Begin costs one atomic load.
+class PerfProfiler
+{
+public:
+    // RPCCommandType, session
+    using Key = std::pair<int, std::uint32_t>;
+
+    struct Counters {
+        std::uint64_t calls_{0};
+        std::uint64_t wall_ns_{0};
+        // Only counted for calls on threads where perf_event_open worked
+        std::uint64_t measured_calls_{0};
+        std::uint64_t cycles_{0};
+        std::uint64_t instructions_{0};
+        std::uint64_t cache_misses_{0};
+        std::uint64_t voluntary_switches_{0};
+        std::uint64_t involuntary_switches_{0};
+    };
+
+    // Counter values when a call starts
+    struct Reading {
+        bool active_{false};
+        bool hardware_{false};
+        std::int64_t time_{0};
+        std::uint64_t cycles_{0};
+        std::uint64_t instructions_{0};
+        std::uint64_t cache_misses_{0};
+        std::int64_t voluntary_switches_{0};
+        std::int64_t involuntary_switches_{0};
+    };
+
+    PerfProfiler();
+
+    Reading Begin() const;
+    void Disable();
+    // Returns why hardware counters are unavailable, or an empty string. Wall
+    // time and context switches are recorded either way.
+    std::string Enable();
+    bool Enabled() const { return enabled_.load(); }
+    void End(const Reading& start, const Key& key);
+    void Reset();
+    std::map<Key, Counters> Snapshot() const;
+
+    ~PerfProfiler() = default;
+
+private:
+    class ThreadCounters;
+
+    std::atomic<bool> enabled_;
+    mutable std::mutex lock_;
+    std::map<Key, Counters> counters_;
+
+    PerfProfiler(const PerfProfiler&) = delete;
+    PerfProfiler(PerfProfiler&&) = delete;
+    PerfProfiler& operator=(const PerfProfiler&) = delete;
+    PerfProfiler& operator=(PerfProfiler&&) = delete;
+};
+}  // namespace opentxs::agent
+#endif  // PERFPROFILER_HPP_
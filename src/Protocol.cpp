@@ -0,0 +1,124 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "Protocol.hpp"
+
+#include <charconv>
+#include <cstring>
+
+#define OPTION_IDEMPOTENCY_KEY "IDEMPOTENCY_KEY"
+#define OPTION_TIMEOUT "TIMEOUT"
+// Longest TIMEOUT accepted, in milliseconds (one day)
+#define MAX_TIMEOUT 86400000
+#define PUSH_FRAME "PUSH"
+#define RPCPUSH_VERSION 2
+#define SUBSCRIPTION_FRAME "SUBSCRIPTION"
+#define TASKCOMPLETE_VERSION 1
+
+namespace zmq = opentxs::network::zeromq;
+
+namespace opentxs::agent
+{
+bool FrameEquals(const zmq::Frame& frame, const char* value)
+{
+    const auto size = std::strlen(value);
+
+    return (frame.size() == size) &&
+           (0 == std::memcmp(frame.data(), value, size));
+}
+
+OTZMQMessage InstantiatePush(const Data& connectionID)
+{
+    OT_ASSERT(0 < connectionID.size());
+
+    auto output = zmq::Message::Factory();
+    output->AddFrame(connectionID);
+    output->AddFrame();
+    output->AddFrame(PUSH_FRAME);
+
+    OT_ASSERT(1 == output->Header().size());
+    OT_ASSERT(1 == output->Body().size());
+
+    return output;
+}
+
+RequestOptions ParseOptions(
+    const zmq::FrameSection& body,
+    const std::size_t begin,
+    const std::size_t end)
+{
+    RequestOptions output{};
+
+    for (auto i = begin; (i + 1) < end; i += 2) {
+        const auto& name = body.at(i);
+        const auto& value = body.at(i + 1);
+
+        if (FrameEquals(name, OPTION_IDEMPOTENCY_KEY)) {
+            output.idempotency_key_ = std::string(value);
+        } else if (FrameEquals(name, OPTION_TIMEOUT)) {
+            // Decimal text. Invalid, negative or out of range values leave
+            // no limit.
+            const auto* start = static_cast<const char*>(value.data());
+            const auto* end = start + value.size();
+            std::int64_t timeout{0};
+            const auto result = std::from_chars(start, end, timeout);
+
+            if ((std::errc{} == result.ec) && (end == result.ptr) &&
+                (0 < timeout) && (MAX_TIMEOUT >= timeout)) {
+                output.timeout_ = std::chrono::milliseconds(timeout);
+            }
+        }
+    }
+
+    return output;
+}
+
+OTZMQMessage SubscriptionPush(
+    const Data& connectionID,
+    const std::uint64_t id,
+    const proto::RPCResponse& added,
+    const proto::RPCResponse& removed)
+{
+    OT_ASSERT(false == connectionID.empty());
+    OT_ASSERT(0 < id);
+
+    auto output = zmq::Message::Factory();
+    output->AddFrame(connectionID);
+    output->AddFrame();
+    output->AddFrame(SUBSCRIPTION_FRAME);
+    output->AddFrame(std::to_string(id));
+    output->AddFrame(proto::ProtoAsData(added));
+    output->AddFrame(proto::ProtoAsData(removed));
+
+    return output;
+}
+
+OTZMQMessage TaskPush(
+    const Data& connectionID,
+    const std::string& taskID,
+    const std::string& nymID,
+    const bool result)
+{
+    OT_ASSERT(false == connectionID.empty());
+    OT_ASSERT(false == taskID.empty());
+    OT_ASSERT(false == nymID.empty());
+
+    auto output = InstantiatePush(connectionID);
+    proto::RPCPush message{};
+    message.set_version(RPCPUSH_VERSION);
+    message.set_type(proto::RPCPUSH_TASK);
+    message.set_id(nymID);
+    auto& task = *message.mutable_taskcomplete();
+    task.set_version(TASKCOMPLETE_VERSION);
+    task.set_id(taskID);
+    task.set_result(result);
+
+    OT_ASSERT(proto::Validate(message, VERBOSE));
+
+    output->AddFrame(proto::ProtoAsData(message));
+
+    return output;
+}
+}  // namespace opentxs::agent
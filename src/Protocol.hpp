@@ -0,0 +1,61 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef PROTOCOL_HPP_
+#define PROTOCOL_HPP_
+
+#include "opentxs/opentxs.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace opentxs::agent
+{
+// Optional request settings. Clients send them as name/value frame pairs
+// after the command frame.
+struct RequestOptions {
+    // Requests with the same key, session, owner and command type run only
+    // once. A repeat gets the first request's response, or an IN_PROGRESS
+    // retry while the first is still running. Reusing a key for a different
+    // command is refused.
+    std::string idempotency_key_{};
+    // How long after the agent receives the request the client still wants
+    // it run, or zero for no limit. A request which waits longer is answered
+    // with ERROR and an EXPIRED reason frame, not RETRY, so clients can tell
+    // it from backpressure.
+    std::chrono::milliseconds timeout_{0};
+};
+
+// Owner nyms of the tasks a command queued, indexed by the command item each
+// task belongs to (RPCTask::index). Items without tasks have an empty entry.
+using TaskOwners = std::vector<std::string>;
+
+// Compares a frame to a marker string without copying the frame
+bool FrameEquals(const network::zeromq::Frame& frame, const char* value);
+// Returns a message addressed to connectionID with the PUSH marker frame
+OTZMQMessage InstantiatePush(const Data& connectionID);
+// Reads the option frames in body positions [begin, end). Unknown names are
+// ignored so clients can send options this agent version doesn't know about.
+RequestOptions ParseOptions(
+    const network::zeromq::FrameSection& body,
+    const std::size_t begin,
+    const std::size_t end);
+// Returns a subscription update addressed to connectionID. The responses
+// hold the result items added and removed since the previous update.
+OTZMQMessage SubscriptionPush(
+    const Data& connectionID,
+    const std::uint64_t id,
+    const proto::RPCResponse& added,
+    const proto::RPCResponse& removed);
+// Returns a complete task completion push
+OTZMQMessage TaskPush(
+    const Data& connectionID,
+    const std::string& taskID,
+    const std::string& nymID,
+    const bool result);
+}  // namespace opentxs::agent
+#endif  // PROTOCOL_HPP_
@@ -0,0 +1,154 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "PushBuffer.hpp"
+
+namespace opentxs::agent
+{
+PushBuffer::PushBuffer(
+    const std::size_t perNym,
+    const std::size_t total,
+    const std::chrono::seconds maxAge)
+    : per_nym_(perNym)
+    , total_(total)
+    , max_age_(maxAge)
+    , lock_()
+    , nyms_()
+    , size_(0)
+    , delivered_(0)
+    , evicted_(0)
+    , expired_(0)
+{
+}
+
+bool PushBuffer::Add(const std::string& nym, const std::string& payload)
+{
+    if ((0 == per_nym_) || (0 == total_)) { return false; }
+
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(lock_);
+    // Pushes are only added when delivery fails, so a full pass is cheap
+    // enough and keeps nyms which never reconnect from holding memory
+    expire(now);
+    auto& entries = nyms_[nym];
+
+    if (entries.size() >= per_nym_) {
+        entries.pop_front();
+        --size_;
+        ++evicted_;
+    }
+
+    while (size_.load() >= total_) { evict_oldest(); }
+
+    // evict_oldest may have erased this nym's entry
+    nyms_[nym].push_back(Entry{now, payload});
+    ++size_;
+
+    return true;
+}
+
+bool PushBuffer::Contains(const std::string& nym) const
+{
+    if (0 == size_.load()) { return false; }
+
+    std::lock_guard<std::mutex> lock(lock_);
+
+    return nyms_.end() != nyms_.find(nym);
+}
+
+void PushBuffer::evict_oldest()
+{
+    auto oldest = nyms_.end();
+
+    for (auto it = nyms_.begin(); it != nyms_.end(); ++it) {
+        if (it->second.empty()) { continue; }
+
+        if ((nyms_.end() == oldest) ||
+            (it->second.front().time_ < oldest->second.front().time_)) {
+            oldest = it;
+        }
+    }
+
+    if (nyms_.end() == oldest) { return; }
+
+    oldest->second.pop_front();
+    --size_;
+    ++evicted_;
+
+    if (oldest->second.empty()) { nyms_.erase(oldest); }
+}
+
+void PushBuffer::expire(const Time now)
+{
+    for (auto it = nyms_.begin(); it != nyms_.end();) {
+        expire(it->second, now);
+
+        if (it->second.empty()) {
+            it = nyms_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void PushBuffer::expire(Entries& entries, const Time now)
+{
+    while ((false == entries.empty()) &&
+           ((entries.front().time_ + max_age_) <= now)) {
+        entries.pop_front();
+        --size_;
+        ++expired_;
+    }
+}
+
+void PushBuffer::Restore(const std::string& nym, Entries&& entries)
+{
+    if (entries.empty()) { return; }
+
+    std::lock_guard<std::mutex> lock(lock_);
+    delivered_ -= entries.size();
+    size_ += entries.size();
+    auto& existing = nyms_[nym];
+    existing.insert(
+        existing.begin(),
+        std::make_move_iterator(entries.begin()),
+        std::make_move_iterator(entries.end()));
+
+    while (existing.size() > per_nym_) {
+        existing.pop_front();
+        --size_;
+        ++evicted_;
+    }
+}
+
+PushBuffer::Stats PushBuffer::Snapshot() const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    Stats output{};
+    output.nyms_ = nyms_.size();
+    output.buffered_ = size_.load();
+    output.delivered_ = delivered_;
+    output.evicted_ = evicted_;
+    output.expired_ = expired_;
+
+    return output;
+}
+
+PushBuffer::Entries PushBuffer::Take(const std::string& nym)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = nyms_.find(nym);
+
+    if (nyms_.end() == it) { return {}; }
+
+    auto output = std::move(it->second);
+    nyms_.erase(it);
+    expire(output, std::chrono::steady_clock::now());
+    size_ -= output.size();
+    delivered_ += output.size();
+
+    return output;
+}
+}  // namespace opentxs::agent
@@ -0,0 +1,88 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef PUSHBUFFER_HPP_
+#define PUSHBUFFER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace opentxs::agent
+{
+// Push notifications which couldn't be delivered, kept per nym until the nym
+// is associated with a connection again. Each nym keeps at most perNym
+// pushes and the buffer at most total, dropping the oldest first. Pushes
+// older than maxAge are dropped since the client will have to poll anyway.
+class PushBuffer
+{
+public:
+    using Time = std::chrono::steady_clock::time_point;
+
+    struct Entry {
+        Time time_{};
+        // Serialized RPCPush
+        std::string payload_{};
+    };
+
+    using Entries = std::deque<Entry>;
+
+    struct Stats {
+        std::size_t nyms_{0};
+        std::size_t buffered_{0};
+        std::uint64_t delivered_{0};
+        std::uint64_t evicted_{0};
+        std::uint64_t expired_{0};
+    };
+
+    PushBuffer(
+        const std::size_t perNym,
+        const std::size_t total,
+        const std::chrono::seconds maxAge);
+
+    // Returns false if buffering is disabled
+    bool Add(const std::string& nym, const std::string& payload);
+    bool Contains(const std::string& nym) const;
+    bool Enabled() const { return 0 < per_nym_; }
+    // Puts pushes returned by Take which couldn't be sent back in front of
+    // any buffered since
+    void Restore(const std::string& nym, Entries&& entries);
+    Stats Snapshot() const;
+    // Removes and returns the nym's pushes, oldest first
+    Entries Take(const std::string& nym);
+
+    ~PushBuffer() = default;
+
+private:
+    const std::size_t per_nym_;
+    const std::size_t total_;
+    const std::chrono::seconds max_age_;
+    mutable std::mutex lock_;
+    std::map<std::string, Entries> nyms_;
+    // Checked without the lock so the common case of an empty buffer is
+    // cheap on the request path
+    std::atomic<std::size_t> size_;
+    std::uint64_t delivered_;
+    std::uint64_t evicted_;
+    std::uint64_t expired_;
+
+    // Drops the oldest push of any nym
+    void evict_oldest();
+    // Drops every push older than max_age_
+    void expire(const Time now);
+    void expire(Entries& entries, const Time now);
+
+    PushBuffer() = delete;
+    PushBuffer(const PushBuffer&) = delete;
+    PushBuffer(PushBuffer&&) = delete;
+    PushBuffer& operator=(const PushBuffer&) = delete;
+    PushBuffer& operator=(PushBuffer&&) = delete;
+};
+}  // namespace opentxs::agent
+#endif  // PUSHBUFFER_HPP_
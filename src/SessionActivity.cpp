@@ -0,0 +1,109 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "SessionActivity.hpp"
+
+#include <algorithm>
+
+namespace opentxs::agent
+{
+SessionActivity::SessionActivity(const std::chrono::seconds idleLimit)
+    : idle_limit_(idleLimit)
+    , lock_()
+    , sessions_()
+{
+}
+
+SessionActivity::Status SessionActivity::Check(
+    const int index,
+    std::vector<std::string>& accounts)
+{
+    const auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(lock_);
+    auto& session = get(index, now);
+
+    if (session.stats_.hibernating_) { return Status::Hibernating; }
+
+    if ((false == Enabled()) || ((now - session.last_used_) < idle_limit_)) {
+        return Status::Active;
+    }
+
+    session.stats_.hibernating_ = true;
+    ++session.stats_.hibernations_;
+    accounts = std::move(session.accounts_);
+    session.accounts_.clear();
+
+    return Status::Hibernate;
+}
+
+SessionActivity::State& SessionActivity::get(
+    const int index,
+    const Clock::time_point now)
+{
+    const auto [it, added] = sessions_.try_emplace(index);
+    auto& output = it->second;
+
+    if (added) {
+        output.last_used_ = now;
+        output.stats_.index_ = index;
+    }
+
+    return output;
+}
+
+void SessionActivity::Loaded(
+    const int index,
+    std::vector<std::string>&& accounts,
+    const std::int64_t kb)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    auto& session = get(index, Clock::now());
+    session.stats_.accounts_ = accounts.size();
+    session.stats_.loaded_kb_ = kb;
+    session.accounts_ = std::move(accounts);
+}
+
+std::vector<SessionActivity::Session> SessionActivity::Snapshot() const
+{
+    const auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(lock_);
+    std::vector<Session> output{};
+    output.reserve(sessions_.size());
+
+    for (const auto& [index, session] : sessions_) {
+        auto& stats = output.emplace_back(session.stats_);
+        stats.idle_ = std::chrono::duration_cast<std::chrono::seconds>(
+            now - session.last_used_);
+    }
+
+    return output;
+}
+
+bool SessionActivity::Touch(const int index)
+{
+    const auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(lock_);
+    auto& session = get(index, now);
+    session.last_used_ = now;
+
+    if (false == session.stats_.hibernating_) { return false; }
+
+    session.stats_.hibernating_ = false;
+
+    return true;
+}
+
+void SessionActivity::Woken(
+    const int index,
+    const std::chrono::milliseconds latency)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    auto& stats = get(index, Clock::now()).stats_;
+    ++stats.reactivations_;
+    stats.last_reactivation_ = latency;
+    stats.max_reactivation_ = std::max(stats.max_reactivation_, latency);
+    stats.total_reactivation_ += latency;
+}
+}  // namespace opentxs::agent
@@ -0,0 +1,95 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef SESSIONACTIVITY_HPP_
+#define SESSIONACTIVITY_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace opentxs::agent
+{
+// Tracks when each client session last ran a command so sessions nobody uses
+// can hibernate.
+//
+// A session hibernates at its first refresh check after idle limit has
+// passed without a command, and wakes up with the next command for it. The
+// caller does the actual work of hibernating and waking; this only decides
+// when and keeps the numbers.
+class SessionActivity
+{
+public:
+    enum class Status {
+        Active,
+        // The session went idle and the caller should hibernate it now
+        Hibernate,
+        Hibernating,
+    };
+
+    struct Session {
+        int index_{0};
+        bool hibernating_{false};
+        std::chrono::seconds idle_{0};
+        std::size_t accounts_{0};
+        std::uint64_t hibernations_{0};
+        std::uint64_t reactivations_{0};
+        std::chrono::milliseconds last_reactivation_{0};
+        std::chrono::milliseconds max_reactivation_{0};
+        std::chrono::milliseconds total_reactivation_{0};
+        // Growth of the agent's resident set while the session last loaded,
+        // which is only an estimate when other sessions load at the same time
+        std::int64_t loaded_kb_{0};
+    };
+
+    // Zero disables hibernation
+    explicit SessionActivity(const std::chrono::seconds idleLimit);
+
+    // Called by the refresh schedule. On Hibernate, accounts is set to the
+    // ids the session loaded so the caller can drop what it cached for them.
+    Status Check(const int index, std::vector<std::string>& accounts);
+    bool Enabled() const { return 0 < idle_limit_.count(); }
+    // Records the account ids the session loaded and the resident set
+    // growth it caused
+    void Loaded(
+        const int index,
+        std::vector<std::string>&& accounts,
+        const std::int64_t kb);
+    std::vector<Session> Snapshot() const;
+    // Records a command for the session. Returns true if the session was
+    // hibernating, in which case the caller wakes it and calls Woken. Only
+    // one caller sees true for each hibernation.
+    bool Touch(const int index);
+    void Woken(const int index, const std::chrono::milliseconds latency);
+
+    ~SessionActivity() = default;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct State {
+        Clock::time_point last_used_{};
+        std::vector<std::string> accounts_{};
+        Session stats_{};
+    };
+
+    const std::chrono::seconds idle_limit_;
+    mutable std::mutex lock_;
+    std::map<int, State> sessions_;
+
+    // Sessions seen for the first time count as used now
+    State& get(const int index, const Clock::time_point now);
+
+    SessionActivity() = delete;
+    SessionActivity(const SessionActivity&) = delete;
+    SessionActivity(SessionActivity&&) = delete;
+    SessionActivity& operator=(const SessionActivity&) = delete;
+    SessionActivity& operator=(SessionActivity&&) = delete;
+};
+}  // namespace opentxs::agent
+#endif  // SESSIONACTIVITY_HPP_
@@ -0,0 +1,243 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "ShmServer.hpp"
+
+#include <signal.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+// libzmq generates 5 byte routing ids and rejects client chosen ids which
+// start with a zero byte, so these can't collide with ROUTER identities
+#define CONNECTION_PREFIX "\0shm"
+#define CONNECTION_PREFIX_SIZE 4
+#define CONNECTION_SIZE (CONNECTION_PREFIX_SIZE + 2 * sizeof(std::uint32_t))
+// Requests queued for the workers per channel before the reader stops taking
+// more from the rings
+#define QUEUED_PER_CHANNEL 4
+#define REAP_INTERVAL std::chrono::seconds(1)
+// How long the reader keeps polling after the last request before it sleeps
+#define SPIN_TIME std::chrono::microseconds(50)
+#define WAIT_INTERVAL std::chrono::milliseconds(100)
+#define WRITE_TIMEOUT std::chrono::seconds(1)
+
+namespace opentxs::agent
+{
+ShmServer::ShmServer(
+    std::unique_ptr<shm::Segment> segment,
+    const unsigned int workers,
+    const Handler& handler)
+    : segment_(std::move(segment))
+    , handler_(handler)
+    , write_locks_(segment_->header().channels_)
+    , queue_(1, {}, 0)
+    , running_(true)
+    , reader_()
+    , workers_()
+{
+    for (unsigned int i{0}; i < workers; ++i) {
+        workers_.emplace_back(&ShmServer::work, this);
+    }
+
+    reader_ = std::thread(&ShmServer::read, this);
+}
+
+std::string ShmServer::connection_id(
+    const std::uint32_t index,
+    const std::uint32_t generation)
+{
+    std::string output(CONNECTION_PREFIX, CONNECTION_PREFIX_SIZE);
+    output.append(reinterpret_cast<const char*>(&index), sizeof(index));
+    output.append(
+        reinterpret_cast<const char*>(&generation), sizeof(generation));
+
+    return output;
+}
+
+std::size_t ShmServer::Connections() const
+{
+    std::size_t output{0};
+
+    for (std::uint32_t i{0}; i < segment_->header().channels_; ++i) {
+        if (0 != segment_->channel(i).owner_.load()) { ++output; }
+    }
+
+    return output;
+}
+
+std::unique_ptr<ShmServer> ShmServer::Factory(
+    const std::string& name,
+    const std::uint32_t channels,
+    const std::uint32_t ringSize,
+    const unsigned int workers,
+    const Handler& handler)
+{
+    auto segment = shm::Segment::Create(name, channels, ringSize);
+
+    if (false == bool(segment)) { return {}; }
+
+    return std::unique_ptr<ShmServer>(
+        new ShmServer(std::move(segment), workers, handler));
+}
+
+bool ShmServer::IsConnection(const void* data, const std::size_t size)
+{
+    return (CONNECTION_SIZE == size) &&
+           (0 == std::memcmp(data, CONNECTION_PREFIX, CONNECTION_PREFIX_SIZE));
+}
+
+void ShmServer::read()
+{
+    auto& header = segment_->header();
+    const auto channels = header.channels_;
+    const auto size = header.ring_size_;
+    auto reaped = std::chrono::steady_clock::now();
+    // When a request was last found
+    std::chrono::steady_clock::time_point active{};
+    shm::Frames frames{};
+
+    while (running_.load()) {
+        // Leaving requests in the rings makes clients wait for space instead
+        // of the queue growing while the workers are behind
+        if ((QUEUED_PER_CHANNEL * channels) <= queue_.Size()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+            continue;
+        }
+
+        const auto seen = header.doorbell_.load();
+        bool found{false};
+
+        // One request per channel per pass so a busy client can't hold up
+        // the others
+        for (std::uint32_t i{0}; i < channels; ++i) {
+            auto& channel = segment_->channel(i);
+
+            if (0 == channel.owner_.load()) { continue; }
+
+            const auto generation = channel.generation_.load();
+            const auto* data = segment_->request_data(i);
+
+            if (shm::TryRead(channel.request_, data, size, frames)) {
+                found = true;
+                auto connection = connection_id(i, generation);
+                queue_.Push(
+                    connection, Request{connection, std::move(frames)});
+                frames = shm::Frames{};
+            }
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+
+        if (found) {
+            active = now;
+
+            continue;
+        }
+
+        // Poll briefly before sleeping since the next request from an active
+        // client usually follows shortly. Bounded by time rather than passes
+        // so the cost doesn't grow with the number of channels.
+        if ((now - active) < SPIN_TIME) { continue; }
+
+        if ((now - reaped) > REAP_INTERVAL) {
+            reap();
+            reaped = now;
+        }
+
+        header.server_waiting_.store(1);
+        shm::Wait(header.doorbell_, seen, WAIT_INTERVAL);
+        header.server_waiting_.store(0);
+    }
+}
+
+void ShmServer::reap()
+{
+    for (std::uint32_t i{0}; i < segment_->header().channels_; ++i) {
+        auto& channel = segment_->channel(i);
+        auto owner = channel.owner_.load();
+
+        if (0 == owner) { continue; }
+
+        if ((0 != ::kill(static_cast<pid_t>(owner), 0)) && (ESRCH == errno)) {
+            channel.owner_.compare_exchange_strong(owner, 0);
+        }
+    }
+}
+
+bool ShmServer::Send(const std::string& connection, const shm::Frames& message)
+{
+    if (false == IsConnection(connection.data(), connection.size())) {
+        return false;
+    }
+
+    std::uint32_t index{0};
+    std::uint32_t generation{0};
+    std::memcpy(
+        &index, connection.data() + CONNECTION_PREFIX_SIZE, sizeof(index));
+    std::memcpy(
+        &generation,
+        connection.data() + CONNECTION_PREFIX_SIZE + sizeof(index),
+        sizeof(generation));
+
+    if (index >= write_locks_.size()) { return false; }
+
+    auto& channel = segment_->channel(index);
+    std::lock_guard<std::mutex> lock(write_locks_[index]);
+    // Set before checking the generation so a client claiming the channel
+    // either makes the check fail or waits for the write to finish
+    channel.writing_.store(1);
+
+    // The client which sent the request has gone
+    if ((0 == channel.owner_.load()) ||
+        (generation != channel.generation_.load())) {
+        channel.writing_.store(0);
+
+        return false;
+    }
+
+    const auto output = shm::Write(
+        channel.response_,
+        segment_->response_data(index),
+        segment_->header().ring_size_,
+        message,
+        WRITE_TIMEOUT,
+        &channel.generation_,
+        generation);
+    channel.writing_.store(0);
+
+    return output;
+}
+
+void ShmServer::work()
+{
+    while (true) {
+        auto request = queue_.Pop();
+
+        if (false == request.has_value()) { return; }
+
+        auto& [connection, frames] = request.value();
+        const auto reply = handler_(connection, std::move(frames));
+
+        if (false == reply.empty()) { Send(connection, reply); }
+    }
+}
+
+ShmServer::~ShmServer()
+{
+    running_.store(false);
+    shm::Wake(segment_->header().doorbell_);
+
+    if (reader_.joinable()) { reader_.join(); }
+
+    queue_.Shutdown();
+
+    for (auto& thread : workers_) {
+        if (thread.joinable()) { thread.join(); }
+    }
+}
+}  // namespace opentxs::agent
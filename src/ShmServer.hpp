@@ -0,0 +1,82 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef SHMSERVER_HPP_
+#define SHMSERVER_HPP_
+
+#include "ShmRing.hpp"
+#include "WorkQueue.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace opentxs::agent
+{
+// Agent side of the shared memory transport. One thread watches the request
+// rings and hands requests to worker threads, which run them through the
+// handler and write the reply to the client's response ring.
+class ShmServer
+{
+public:
+    // connection id, request frames -> reply frames
+    using Handler =
+        std::function<shm::Frames(const std::string&, shm::Frames&&)>;
+
+    // Returns nothing if the segment can't be created
+    static std::unique_ptr<ShmServer> Factory(
+        const std::string& name,
+        const std::uint32_t channels,
+        const std::uint32_t ringSize,
+        const unsigned int workers,
+        const Handler& handler);
+    // True for connection ids handed out by a ShmServer
+    static bool IsConnection(const void* data, const std::size_t size);
+
+    // Number of channels claimed by clients
+    std::size_t Connections() const;
+    // Returns false if the client has gone or isn't reading
+    bool Send(const std::string& connection, const shm::Frames& message);
+
+    ~ShmServer();
+
+private:
+    // connection id, request frames
+    using Request = std::pair<std::string, shm::Frames>;
+
+    const std::unique_ptr<shm::Segment> segment_;
+    const Handler handler_;
+    std::vector<std::mutex> write_locks_;
+    WorkQueue<Request> queue_;
+    std::atomic<bool> running_;
+    std::thread reader_;
+    std::vector<std::thread> workers_;
+
+    static std::string connection_id(
+        const std::uint32_t index,
+        const std::uint32_t generation);
+
+    void read();
+    // Frees channels claimed by processes which no longer exist
+    void reap();
+    void work();
+
+    ShmServer(
+        std::unique_ptr<shm::Segment> segment,
+        const unsigned int workers,
+        const Handler& handler);
+    ShmServer() = delete;
+    ShmServer(const ShmServer&) = delete;
+    ShmServer(ShmServer&&) = delete;
+    ShmServer& operator=(const ShmServer&) = delete;
+    ShmServer& operator=(ShmServer&&) = delete;
+};
+}  // namespace opentxs::agent
+#endif  // SHMSERVER_HPP_
@@ -0,0 +1,281 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "Subscriptions.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace opentxs::agent
+{
+Subscriptions::Subscriptions(
+    const std::size_t limit,
+    const std::size_t total,
+    const std::chrono::seconds ttl,
+    const QueryFunction& query,
+    const SendFunction& send)
+    : limit_(limit)
+    , total_(total)
+    , ttl_(ttl)
+    , query_(query)
+    , send_(send)
+    , lock_()
+    , cv_()
+    , running_(true)
+    , next_id_(1)
+    , subscriptions_()
+    , by_nym_()
+    , connections_()
+    , stale_()
+    , stats_()
+    , thread_()
+{
+    thread_ = std::thread(&Subscriptions::run, this);
+}
+
+std::uint64_t Subscriptions::Add(
+    const std::string& connection,
+    const std::string& command)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+
+    if ((0 < total_) && (subscriptions_.size() >= total_)) { return 0; }
+
+    auto& owner = connections_[connection];
+
+    if (owner.ids_.size() >= limit_) {
+        if (owner.ids_.empty()) { connections_.erase(connection); }
+
+        return 0;
+    }
+
+    const auto id = next_id_++;
+    owner.ids_.insert(id);
+    owner.active_ = Clock::now();
+    auto& subscription = subscriptions_[id];
+    subscription.connection_ = connection;
+    subscription.command_ = command;
+    stale_.insert(id);
+    stats_.subscriptions_ = subscriptions_.size();
+    lock.unlock();
+    cv_.notify_one();
+
+    return id;
+}
+
+void Subscriptions::erase(const std::uint64_t id)
+{
+    const auto it = subscriptions_.find(id);
+
+    if (subscriptions_.end() == it) { return; }
+
+    const auto& subscription = it->second;
+    index(id, subscription.nyms_, {});
+    auto owner = connections_.find(subscription.connection_);
+
+    if (connections_.end() != owner) {
+        owner->second.ids_.erase(id);
+
+        if (owner->second.ids_.empty()) { connections_.erase(owner); }
+    }
+
+    stale_.erase(id);
+    subscriptions_.erase(it);
+    stats_.subscriptions_ = subscriptions_.size();
+}
+
+void Subscriptions::expire(const Clock::time_point now)
+{
+    for (auto it = connections_.begin(); it != connections_.end();) {
+        if ((now - it->second.active_) <= ttl_) {
+            ++it;
+
+            continue;
+        }
+
+        // erase removes the connection along with its last subscription
+        const auto ids = it->second.ids_;
+        ++it;
+
+        for (const auto id : ids) {
+            erase(id);
+            ++stats_.expired_;
+        }
+    }
+}
+
+void Subscriptions::index(
+    const std::uint64_t id,
+    const Nyms& previous,
+    const Nyms& nyms)
+{
+    for (const auto& nym : previous) {
+        if (0 < nyms.count(nym)) { continue; }
+
+        auto it = by_nym_.find(nym);
+
+        if (by_nym_.end() == it) { continue; }
+
+        it->second.erase(id);
+
+        if (it->second.empty()) { by_nym_.erase(it); }
+    }
+
+    for (const auto& nym : nyms) { by_nym_[nym].insert(id); }
+}
+
+void Subscriptions::Notify(const std::string& nym)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    const auto it = by_nym_.find(nym);
+
+    if (by_nym_.end() == it) { return; }
+
+    stale_.insert(it->second.begin(), it->second.end());
+    lock.unlock();
+    cv_.notify_one();
+}
+
+void Subscriptions::refresh(const std::uint64_t id)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+
+    if (false == running_) { return; }
+
+    auto it = subscriptions_.find(id);
+
+    if (subscriptions_.end() == it) { return; }
+
+    const auto command = it->second.command_;
+    lock.unlock();
+    Items items{};
+    Nyms nyms{};
+    const auto success = query_(command, items, nyms);
+    std::sort(items.begin(), items.end());
+    lock.lock();
+    ++stats_.refreshes_;
+    it = subscriptions_.find(id);
+
+    if ((subscriptions_.end() == it) || (false == success)) { return; }
+
+    auto& subscription = it->second;
+    Items added{};
+    Items removed{};
+    std::set_difference(
+        items.begin(),
+        items.end(),
+        subscription.items_.begin(),
+        subscription.items_.end(),
+        std::back_inserter(added));
+    std::set_difference(
+        subscription.items_.begin(),
+        subscription.items_.end(),
+        items.begin(),
+        items.end(),
+        std::back_inserter(removed));
+    index(id, subscription.nyms_, nyms);
+    subscription.nyms_ = std::move(nyms);
+    subscription.items_ = std::move(items);
+
+    // The first result is always sent, even when empty, so the subscriber
+    // knows where it starts from
+    if (added.empty() && removed.empty() && subscription.sent_) { return; }
+
+    subscription.sent_ = true;
+    const auto connection = subscription.connection_;
+    ++stats_.deltas_;
+    lock.unlock();
+
+    if (send_(connection, id, command, added, removed)) { return; }
+
+    lock.lock();
+
+    if (subscriptions_.end() != subscriptions_.find(id)) {
+        erase(id);
+        ++stats_.dropped_;
+    }
+}
+
+bool Subscriptions::Remove(
+    const std::string& connection,
+    const std::uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    const auto it = subscriptions_.find(id);
+
+    // Only the connection which subscribed can cancel
+    if ((subscriptions_.end() == it) ||
+        (connection != it->second.connection_)) {
+        return false;
+    }
+
+    erase(id);
+
+    return true;
+}
+
+void Subscriptions::run()
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    // Idle connections are looked for a few times per ttl
+    const auto interval = std::max<Clock::duration>(
+        ttl_ / 4, std::chrono::seconds(1));
+    auto next = Clock::now() + interval;
+
+    while (true) {
+        const auto woken = cv_.wait_until(lock, next, [this]() {
+            return (false == running_) || (false == stale_.empty());
+        });
+
+        if (false == running_) { return; }
+
+        const auto now = Clock::now();
+
+        if ((0 < ttl_.count()) && (now >= next)) {
+            expire(now);
+            next = now + interval;
+        }
+
+        if (false == woken) { continue; }
+
+        const auto stale = std::move(stale_);
+        stale_.clear();
+        lock.unlock();
+
+        for (const auto id : stale) { refresh(id); }
+
+        lock.lock();
+    }
+}
+
+Subscriptions::Stats Subscriptions::Snapshot() const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+
+    return stats_;
+}
+
+void Subscriptions::Touch(const std::string& connection)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    const auto it = connections_.find(connection);
+
+    if (connections_.end() == it) { return; }
+
+    it->second.active_ = Clock::now();
+}
+
+Subscriptions::~Subscriptions()
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        running_ = false;
+    }
+
+    cv_.notify_all();
+
+    if (thread_.joinable()) { thread_.join(); }
+}
+}  // namespace opentxs::agent
@@ -0,0 +1,138 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef SUBSCRIPTIONS_HPP_
+#define SUBSCRIPTIONS_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace opentxs::agent
+{
+// Queries clients subscribed to instead of polling.
+//
+// A subscription is rerun on its own thread when Notify is called for one of
+// the nyms its last result involved, and the subscriber is sent the items
+// added to and removed from the result since the previous run. The first run
+// happens right after the subscription is added and sends the whole result
+// as added items. Notifications arriving while a query runs are coalesced
+// into a single rerun.
+//
+// Sends to a client which has gone away usually succeed, so a connection's
+// subscriptions are also ended once it has gone ttl without calling Touch.
+class Subscriptions
+{
+public:
+    // Serialized result items, compared as bytes
+    using Items = std::vector<std::string>;
+    using Nyms = std::set<std::string>;
+
+    // Runs a subscribed command. Sets the result items and the nyms whose
+    // events should trigger a rerun. Returns false if the query failed, in
+    // which case the previous result is kept.
+    using QueryFunction = std::function<
+        bool(const std::string& command, Items& items, Nyms& nyms)>;
+    // Sends a delta. Returns false if it couldn't be delivered, which ends the
+    // subscription.
+    using SendFunction = std::function<bool(
+        const std::string& connection,
+        const std::uint64_t id,
+        const std::string& command,
+        const Items& added,
+        const Items& removed)>;
+
+    struct Stats {
+        std::size_t subscriptions_{0};
+        std::uint64_t refreshes_{0};
+        std::uint64_t deltas_{0};
+        // Subscriptions ended because a delta couldn't be delivered
+        std::uint64_t dropped_{0};
+        // Subscriptions ended because their connection went idle
+        std::uint64_t expired_{0};
+    };
+
+    // limit is per connection and total across all connections (0 = no
+    // total limit). A ttl of zero keeps subscriptions until they are removed
+    // or a send fails.
+    Subscriptions(
+        const std::size_t limit,
+        const std::size_t total,
+        const std::chrono::seconds ttl,
+        const QueryFunction& query,
+        const SendFunction& send);
+
+    // Returns the subscription id, or zero if the connection already has
+    // limit subscriptions or total has been reached
+    std::uint64_t Add(
+        const std::string& connection,
+        const std::string& command);
+    // Marks every subscription involving the nym for a rerun
+    void Notify(const std::string& nym);
+    bool Remove(const std::string& connection, const std::uint64_t id);
+    Stats Snapshot() const;
+    // Records activity from the connection, which keeps its subscriptions
+    void Touch(const std::string& connection);
+
+    ~Subscriptions();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Connection {
+        std::set<std::uint64_t> ids_{};
+        Clock::time_point active_{};
+    };
+
+    struct Subscription {
+        std::string connection_{};
+        std::string command_{};
+        Nyms nyms_{};
+        // Sorted
+        Items items_{};
+        // Set once the first result has been sent
+        bool sent_{false};
+    };
+
+    const std::size_t limit_;
+    const std::size_t total_;
+    const std::chrono::seconds ttl_;
+    const QueryFunction query_;
+    const SendFunction send_;
+    mutable std::mutex lock_;
+    std::condition_variable cv_;
+    bool running_;
+    std::uint64_t next_id_;
+    std::map<std::uint64_t, Subscription> subscriptions_;
+    // nym, ids of subscriptions whose last result involved it
+    std::map<std::string, std::set<std::uint64_t>> by_nym_;
+    std::map<std::string, Connection> connections_;
+    // Subscriptions waiting for a rerun
+    std::set<std::uint64_t> stale_;
+    Stats stats_;
+    std::thread thread_;
+
+    void erase(const std::uint64_t id);
+    // Ends the subscriptions of connections idle for longer than ttl_
+    void expire(const Clock::time_point now);
+    void index(const std::uint64_t id, const Nyms& previous, const Nyms& nyms);
+    void refresh(const std::uint64_t id);
+    void run();
+
+    Subscriptions() = delete;
+    Subscriptions(const Subscriptions&) = delete;
+    Subscriptions(Subscriptions&&) = delete;
+    Subscriptions& operator=(const Subscriptions&) = delete;
+    Subscriptions& operator=(Subscriptions&&) = delete;
+};
+}  // namespace opentxs::agent
+#endif  // SUBSCRIPTIONS_HPP_
@@ -0,0 +1,209 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "SyntheticExecutor.hpp"
+
+#define RPCSTATUS_VERSION 1
+#define RPCTASK_VERSION 1
+#define SYNTHETIC_ACCOUNT_PREFIX "synthetic-account-"
+#define SYNTHETIC_OWNER_PREFIX "synthetic-owner-"
+#define SYNTHETIC_TASK_PREFIX "synthetic-task-"
+#define SYNTHETIC_TASK_ENDPOINT "agent/synthetic/taskcomplete"
+
+namespace opentxs::agent
+{
+// Finished task statuses kept for check_task
+const std::size_t SyntheticExecutor::max_finished_{65536};
+
+SyntheticExecutor::SyntheticExecutor(
+    const api::Native& app,
+    const Settings& settings)
+    : Executor()
+    , settings_(settings)
+    , endpoint_(app.ZMQ().BuildEndpoint(SYNTHETIC_TASK_ENDPOINT, -1, 1))
+    , publisher_(app.ZMQ().PublishSocket())
+    , next_task_(0)
+    , next_account_(0)
+    , lock_()
+    , cv_()
+    , pending_()
+    , status_()
+    , finished_()
+    , running_(true)
+    , thread_()
+{
+    const auto started = publisher_->Start(endpoint_);
+
+    OT_ASSERT(started);
+
+    thread_ = std::thread(&SyntheticExecutor::run, this);
+}
+
+std::string SyntheticExecutor::AccountOwner(
+    const int,
+    const std::string& accountID) const
+{
+    return SYNTHETIC_OWNER_PREFIX + accountID;
+}
+
+std::vector<std::string> SyntheticExecutor::Preload(const int) const
+{
+    // There is no wallet behind the synthetic executor
+    return {};
+}
+
+void SyntheticExecutor::publish(const Completion& task) const
+{
+    const auto& [taskID, result] = task;
+    auto message = network::zeromq::Message::Factory();
+    message->AddFrame(taskID);
+    message->AddFrame(Data::Factory(&result, sizeof(result)));
+    publisher_->Send(message);
+}
+
+void SyntheticExecutor::queue_task(
+    proto::RPCResponse& response,
+    const std::uint32_t index) const
+{
+    const auto number = next_task_++;
+    const auto taskID = SYNTHETIC_TASK_PREFIX + std::to_string(number);
+    auto& status = *response.add_status();
+    status.set_version(RPCSTATUS_VERSION);
+    status.set_index(index);
+    status.set_code(proto::RPCRESPONSE_QUEUED);
+    auto& task = *response.add_task();
+    task.set_version(RPCTASK_VERSION);
+    task.set_index(index);
+    task.set_id(taskID);
+    // Outcomes are assigned in a fixed pattern so runs are repeatable
+    const auto bucket = static_cast<unsigned int>(number % 100);
+
+    if (bucket < settings_.lost_percent_) { return; }
+
+    const bool result =
+        (bucket >= (settings_.lost_percent_ + settings_.failed_percent_));
+    Lock lock(lock_);
+    status_[taskID] = ThreadStatus::RUNNING;
+    pending_.emplace(
+        std::chrono::steady_clock::now() + settings_.task_delay_,
+        Completion{taskID, result});
+    lock.unlock();
+    cv_.notify_one();
+}
+
+bool SyntheticExecutor::queues_task(const proto::RPCCommandType type)
+{
+    return (proto::RPCCOMMAND_REGISTERNYM == type) ||
+           (proto::RPCCOMMAND_ISSUEUNITDEFINITION == type) ||
+           (proto::RPCCOMMAND_CREATEACCOUNT == type) ||
+           (proto::RPCCOMMAND_CREATECOMPATIBLEACCOUNT == type) ||
+           (proto::RPCCOMMAND_SENDPAYMENT == type);
+}
+
+proto::RPCResponse SyntheticExecutor::RPC(
+    const proto::RPCCommand& command) const
+{
+    if (0 < settings_.latency_.count()) {
+        std::this_thread::sleep_for(settings_.latency_);
+    }
+
+    const auto type = command.type();
+    proto::RPCResponse output{};
+    output.set_version(command.version());
+    output.set_cookie(command.cookie());
+    output.set_type(type);
+    output.set_session(command.session());
+
+    if ((proto::RPCCOMMAND_CREATEACCOUNT == type) ||
+        (proto::RPCCOMMAND_CREATECOMPATIBLEACCOUNT == type)) {
+        output.add_identifier(
+            SYNTHETIC_ACCOUNT_PREFIX + std::to_string(next_account_++));
+    }
+
+    if (proto::RPCCOMMAND_ACCEPTPENDINGPAYMENTS == type) {
+        for (int i{0}; i < command.acceptpendingpayment_size(); ++i) {
+            queue_task(output, static_cast<std::uint32_t>(i));
+        }
+    } else if (queues_task(type)) {
+        queue_task(output, 0);
+    } else {
+        auto& status = *output.add_status();
+        status.set_version(RPCSTATUS_VERSION);
+        status.set_index(0);
+        // There are no sessions to add, so don't pretend to have added one
+        const bool session = (proto::RPCCOMMAND_ADDCLIENTSESSION == type) ||
+                             (proto::RPCCOMMAND_ADDSERVERSESSION == type);
+        status.set_code(
+            session ? proto::RPCRESPONSE_INVALID : proto::RPCRESPONSE_SUCCESS);
+    }
+
+    return output;
+}
+
+void SyntheticExecutor::run()
+{
+    Lock lock(lock_);
+
+    while (running_) {
+        if (pending_.empty()) {
+            cv_.wait(lock);
+
+            continue;
+        }
+
+        const auto it = pending_.begin();
+
+        if (std::chrono::steady_clock::now() < it->first) {
+            cv_.wait_until(lock, it->first);
+
+            continue;
+        }
+
+        const auto task = it->second;
+        pending_.erase(it);
+        const auto& [taskID, result] = task;
+        status_[taskID] = result ? ThreadStatus::FINISHED_SUCCESS
+                                 : ThreadStatus::FINISHED_FAILED;
+        finished_.push_back(taskID);
+
+        while (max_finished_ < finished_.size()) {
+            status_.erase(finished_.front());
+            finished_.pop_front();
+        }
+
+        lock.unlock();
+        publish(task);
+        lock.lock();
+    }
+}
+
+ThreadStatus SyntheticExecutor::Status(const int, const std::string& taskID)
+    const
+{
+    Lock lock(lock_);
+    const auto it = status_.find(taskID);
+
+    // Lost tasks are never recorded and stay running forever
+    if (status_.end() == it) { return ThreadStatus::RUNNING; }
+
+    return it->second;
+}
+
+std::vector<std::string> SyntheticExecutor::TaskEndpoints(
+    const std::int64_t) const
+{
+    return {endpoint_};
+}
+
+SyntheticExecutor::~SyntheticExecutor()
+{
+    Lock lock(lock_);
+    running_ = false;
+    lock.unlock();
+    cv_.notify_all();
+
+    if (thread_.joinable()) { thread_.join(); }
+}
+}  // namespace opentxs::agent
@@ -0,0 +1,87 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef SYNTHETICEXECUTOR_HPP_
+#define SYNTHETICEXECUTOR_HPP_
+
+#include "Executor.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace opentxs::agent
+{
+// Answers every command with a canned response so the agent's own transport,
+// routing and push machinery can be measured without wallet work. Commands
+// which queue tasks in opentxs get a task here too, and its completion is
+// published on a TaskComplete style endpoint after task_delay_.
+class SyntheticExecutor final : public Executor
+{
+public:
+    struct Settings {
+        // Time spent in each RPC call
+        std::chrono::microseconds latency_{0};
+        // Time from queueing a task to publishing its completion
+        std::chrono::milliseconds task_delay_{10};
+        // Percentage of tasks which finish with a failure
+        unsigned int failed_percent_{0};
+        // Percentage of tasks which never finish
+        unsigned int lost_percent_{0};
+    };
+
+    SyntheticExecutor(const api::Native& app, const Settings& settings);
+
+    std::string AccountOwner(
+        const int clientIndex,
+        const std::string& accountID) const override;
+    std::vector<std::string> Preload(const int clientIndex) const override;
+    proto::RPCResponse RPC(const proto::RPCCommand& command) const override;
+    ThreadStatus Status(const int clientIndex, const std::string& taskID)
+        const override;
+    std::vector<std::string> TaskEndpoints(
+        const std::int64_t clients) const override;
+
+    ~SyntheticExecutor() override;
+
+private:
+    using Time = std::chrono::steady_clock::time_point;
+    // task id, result
+    using Completion = std::pair<std::string, bool>;
+
+    static const std::size_t max_finished_;
+
+    const Settings settings_;
+    const std::string endpoint_;
+    const OTZMQPublishSocket publisher_;
+    mutable std::atomic<std::uint64_t> next_task_;
+    mutable std::atomic<std::uint64_t> next_account_;
+    mutable std::mutex lock_;
+    mutable std::condition_variable cv_;
+    mutable std::multimap<Time, Completion> pending_;
+    mutable std::map<std::string, ThreadStatus> status_;
+    mutable std::deque<std::string> finished_;
+    bool running_;
+    std::thread thread_;
+
+    static bool queues_task(const proto::RPCCommandType type);
+
+    void queue_task(proto::RPCResponse& response, const std::uint32_t index)
+        const;
+    void publish(const Completion& task) const;
+    void run();
+
+    SyntheticExecutor() = delete;
+    SyntheticExecutor(const SyntheticExecutor&) = delete;
+    SyntheticExecutor(SyntheticExecutor&&) = delete;
+    SyntheticExecutor& operator=(const SyntheticExecutor&) = delete;
+    SyntheticExecutor& operator=(SyntheticExecutor&&) = delete;
+};
+}  // namespace opentxs::agent
+#endif  // SYNTHETICEXECUTOR_HPP_
@@ -0,0 +1,56 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "Systemd.hpp"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+namespace opentxs::agent
+{
+bool NotifySystemd(const std::string& state)
+{
+    const char* path = std::getenv("NOTIFY_SOCKET");
+
+    if (nullptr == path) { return false; }
+
+    const auto length = std::strlen(path);
+    struct sockaddr_un address {
+    };
+
+    // A leading @ is an abstract socket address
+    if ((0 == length) || (sizeof(address.sun_path) < length) ||
+        (('/' != path[0]) && ('@' != path[0]))) {
+        return false;
+    }
+
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path, length);
+
+    if ('@' == path[0]) { address.sun_path[0] = '\0'; }
+
+    const auto fd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+
+    if (0 > fd) { return false; }
+
+    const auto size =
+        static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + length);
+    const auto sent = ::sendto(
+        fd,
+        state.data(),
+        state.size(),
+        MSG_NOSIGNAL,
+        reinterpret_cast<const struct sockaddr*>(&address),
+        size);
+    ::close(fd);
+
+    return static_cast<ssize_t>(state.size()) == sent;
+}
+}  // namespace opentxs::agent
@@ -0,0 +1,18 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef SYSTEMD_HPP_
+#define SYSTEMD_HPP_
+
+#include <string>
+
+namespace opentxs::agent
+{
+// Sends a state such as "READY=1" to the service manager, using the sd_notify
+// protocol without linking libsystemd. Returns false if the agent wasn't
+// started with NOTIFY_SOCKET set or the message could not be sent.
+bool NotifySystemd(const std::string& state);
+}  // namespace opentxs::agent
+#endif  // SYSTEMD_HPP_
@@ -0,0 +1,187 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef WORKQUEUE_HPP_
+#define WORKQUEUE_HPP_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace opentxs::agent
+{
+// Multiple producer, multiple consumer queue used to hand requests from the
+// frontend socket directly to the worker threads.
+//
+// Items are queued per flow and served by deficit round robin: each time a
+// flow reaches the head of the round it may have up to its weight in items
+// popped before the next flow is served. A flow with a long backlog therefore
+// delays other flows by at most its weight, not by its backlog.
+//
+// At most capacity items are queued across all flows so a burst which the
+// workers can't keep up with is refused rather than held in memory.
+template <typename T>
+class WorkQueue
+{
+public:
+    using Weights = std::map<std::string, std::uint32_t>;
+
+    enum class Status : std::uint8_t {
+        Queued = 0,
+        // The queue holds capacity items
+        Full = 1,
+        // The queue has been shut down
+        Stopped = 2,
+    };
+
+    // Flows not listed in weights use defaultWeight. A capacity of zero
+    // doesn't limit the queue.
+    WorkQueue(
+        const std::uint32_t defaultWeight,
+        const Weights& weights,
+        const std::size_t capacity)
+        : default_weight_(std::max<std::uint32_t>(defaultWeight, 1))
+        , weights_(weights)
+        , capacity_(capacity)
+        , lock_()
+        , cv_()
+        , flows_()
+        , round_()
+        , size_(0)
+        , running_(true)
+    {
+    }
+
+    // Number of flows with queued items
+    std::size_t Flows() const
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+
+        return flows_.size();
+    }
+
+    // Blocks until an item is available. Returns nothing once the queue has
+    // been shut down.
+    std::optional<T> Pop()
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        cv_.wait(lock, [this]() { return ready(); });
+
+        if (false == running_) { return {}; }
+
+        const auto key = round_.front();
+        auto it = flows_.find(key);
+        auto& flow = it->second;
+
+        if (0 == flow.deficit_) { flow.deficit_ = flow.weight_; }
+
+        std::optional<T> output{std::move(flow.queue_.front())};
+        flow.queue_.pop_front();
+        --flow.deficit_;
+        --size_;
+
+        if (flow.queue_.empty()) {
+            // Idle flows don't keep unused credit
+            flows_.erase(it);
+            round_.pop_front();
+        } else if (0 == flow.deficit_) {
+            round_.pop_front();
+            round_.push_back(key);
+        }
+
+        return output;
+    }
+
+    Status Push(const std::string& key, T&& item)
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+
+        if (false == running_) { return Status::Stopped; }
+
+        if ((0 < capacity_) && (capacity_ <= size_)) { return Status::Full; }
+
+        auto it = flows_.find(key);
+
+        if (flows_.end() == it) {
+            it = flows_.emplace(key, Flow{weight(key)}).first;
+            round_.push_back(key);
+        }
+
+        it->second.queue_.emplace_back(std::move(item));
+        ++size_;
+        lock.unlock();
+        cv_.notify_one();
+
+        return Status::Queued;
+    }
+
+    void Shutdown()
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        running_ = false;
+        lock.unlock();
+        cv_.notify_all();
+    }
+
+    std::size_t Size() const
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+
+        return size_;
+    }
+
+    ~WorkQueue() { Shutdown(); }
+
+private:
+    struct Flow {
+        const std::uint32_t weight_;
+        std::uint32_t deficit_;
+        std::deque<T> queue_;
+
+        explicit Flow(const std::uint32_t weight)
+            : weight_(weight)
+            , deficit_(0)
+            , queue_()
+        {
+        }
+    };
+
+    const std::uint32_t default_weight_;
+    const Weights weights_;
+    const std::size_t capacity_;
+    mutable std::mutex lock_;
+    std::condition_variable cv_;
+    std::map<std::string, Flow> flows_;
+    // Keys of flows_ in service order
+    std::deque<std::string> round_;
+    std::size_t size_;
+    bool running_;
+
+    bool ready() const { return (false == running_) || (0 < size_); }
+
+    std::uint32_t weight(const std::string& key) const
+    {
+        const auto it = weights_.find(key);
+
+        if ((weights_.end() == it) || (0 == it->second)) {
+            return default_weight_;
+        }
+
+        return it->second;
+    }
+
+    WorkQueue() = delete;
+    WorkQueue(const WorkQueue&) = delete;
+    WorkQueue(WorkQueue&&) = delete;
+    WorkQueue& operator=(const WorkQueue&) = delete;
+    WorkQueue& operator=(WorkQueue&&) = delete;
+};
+}  // namespace opentxs::agent
+#endif  // WORKQUEUE_HPP_
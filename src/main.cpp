@@ -23,12 +23,57 @@ extern "C" {
 #include "Agent.hpp"
 
 #define OT_STORAGE_GC_SECONDS 3600
+// Passed to opentxs when the agent schedules storage GC itself
+#define OT_STORAGE_GC_DISABLED (10 * 365 * 24 * 3600)
+// Config tree section for tunables given on the command line. The agent
+// prefers it to the saved section and never writes it to the config file.
+#define CONFIG_RUNTIME_SECTION "otagent-runtime"
 
 #define OPTION_CLIENTS "clients"
 #define OPTION_SERVERS "servers"
 #define OPTION_SOCKET_PATH "socket-path"
 #define OPTION_ENDPOINT "endpoint"
 #define OPTION_LOG_ENDPOINT "logendpoint"
+#define OPTION_DISPATCH "dispatch"
+#define OPTION_LOG_LEVEL "log-level"
+#define OPTION_LOG_RATE "log-rate"
+#define OPTION_DRAIN_TIMEOUT "drain-timeout"
+#define OPTION_CONNECTION_WEIGHTS "connection-weights"
+#define OPTION_DEFAULT_WEIGHT "default-weight"
+#define OPTION_QUEUE_LIMIT "queue-limit"
+#define OPTION_ACCOUNT_OWNER_CACHE_SIZE "account-owner-cache-size"
+#define OPTION_EXECUTOR "executor"
+#define OPTION_CAPTURE "capture"
+#define OPTION_CAPTURE_MAX_SIZE "capture-max-size"
+#define OPTION_CAPTURE_REDACT "capture-redact"
+#define OPTION_FRONTEND_SHARDS "frontend-shards"
+#define OPTION_GC_INTERVAL "gc-interval"
+#define OPTION_GC_MAX_DELAY "gc-max-delay"
+#define OPTION_GC_MAX_IN_FLIGHT "gc-max-in-flight"
+#define OPTION_GC_MAX_REQUEST_RATE "gc-max-request-rate"
+#define OPTION_HEAVY_HITTERS "heavy-hitters"
+#define OPTION_HEAVY_HITTERS_HALF_LIFE "heavy-hitters-half-life"
+#define OPTION_IDEMPOTENCY_CAPACITY "idempotency-capacity"
+#define OPTION_IDEMPOTENCY_TTL "idempotency-ttl"
+#define OPTION_IPC_AUTH "ipc-auth"
+#define OPTION_IPC_GROUPS "ipc-groups"
+#define OPTION_IPC_USERS "ipc-users"
+#define OPTION_PUSH_BUFFER_AGE "push-buffer-age"
+#define OPTION_PUSH_BUFFER_SIZE "push-buffer-size"
+#define OPTION_PUSH_BUFFER_TOTAL "push-buffer-total"
+#define OPTION_SESSION_IDLE "session-idle"
+#define OPTION_SHM_CHANNELS "shm-channels"
+#define OPTION_SHM_NAME "shm-name"
+#define OPTION_SHM_RING_SIZE "shm-ring-size"
+#define OPTION_SUBSCRIPTION_LIMIT "subscription-limit"
+#define OPTION_SUBSCRIPTION_TOTAL "subscription-total"
+#define OPTION_SUBSCRIPTION_TTL "subscription-ttl"
+#define OPTION_SYNTHETIC_LATENCY "synthetic-latency"
+#define OPTION_SYNTHETIC_TASK_DELAY "synthetic-task-delay"
+#define OPTION_SYNTHETIC_TASK_FAILURE "synthetic-task-failure"
+#define OPTION_SYNTHETIC_TASK_LOST "synthetic-task-lost"
+#define OPTION_TASK_TTL "task-ttl"
+#define OPTION_WARMUP "warmup"
 #define CONFIG_SERVER_PRIVKEY "server_privkey"
 #define CONFIG_SERVER_PUBKEY "server_pubkey"
 #define CONFIG_CLIENT_PRIVKEY "client_privkey"
@@ -47,6 +92,120 @@ std::string config_option_name(const char* name)
     return std::string("otagent.") + name;
 }
 
+struct Tunable {
+    const char* name;
+    const char* description;
+};
+
+// Agent settings which are passed through the config tree. The command line
+// value takes precedence over the config file value.
+static const Tunable tunables_[] = {
+    {OPTION_DISPATCH, "Request dispatch mode (socket or queue)."},
+    {OPTION_LOG_LEVEL, "Agent log level, 0 (output) to 3 (debug)."},
+    {OPTION_LOG_RATE,
+     "Log messages per second allowed from each call site (0 = no limit)."},
+    {OPTION_DRAIN_TIMEOUT,
+     "Seconds to wait for outstanding requests and tasks at shutdown."},
+    {OPTION_DEFAULT_WEIGHT,
+     "Requests served from a connection per round when dispatch is queue."},
+    {OPTION_QUEUE_LIMIT,
+     "Requests queued for the workers when dispatch is queue. Requests "
+     "beyond it get a QUEUE_FULL retry (0 = no limit, default 10000)."},
+    {OPTION_CONNECTION_WEIGHTS,
+     "Per connection weights as a comma separated list of "
+     "<hex routing id>:<weight>."},
+    {OPTION_EXECUTOR,
+     "Command executor (native or synthetic). The synthetic executor answers "
+     "with canned responses and is only for measuring the agent itself."},
+    {OPTION_CAPTURE,
+     "Record incoming requests to this file for otagent-replay. ADMIN "
+     "CAPTURE START and STOP control capturing to it at runtime."},
+    {OPTION_CAPTURE_REDACT,
+     "Keep only the type, session and cookie of captured commands (1 = yes, "
+     "0 = no)."},
+    {OPTION_CAPTURE_MAX_SIZE,
+     "MiB after which capturing stops (default 1024)."},
+    {OPTION_FRONTEND_SHARDS,
+     "Frontend sockets to spread connections over (default 1). Shard n "
+     "listens on each tcp endpoint's port plus n and on the other endpoints "
+     "with .n appended. Shard endpoints using a port another endpoint uses "
+     "are skipped."},
+    {OPTION_IPC_AUTH,
+     "Authentication on the ipc socket (curve or peer). peer skips CURVE and "
+     "checks the connecting process's uid and gid instead. Endpoints keep "
+     "CURVE. ADMIN commands are accepted from clients on the ipc socket in "
+     "either mode, and never from endpoints or frontend shards."},
+    {OPTION_IPC_USERS,
+     "Comma separated uids allowed on the ipc socket when ipc-auth is peer "
+     "(default: the agent's uid)."},
+    {OPTION_IPC_GROUPS,
+     "Comma separated gids allowed on the ipc socket when ipc-auth is peer."},
+    {OPTION_GC_INTERVAL, "Seconds between storage garbage collections."},
+    {OPTION_GC_MAX_DELAY,
+     "Seconds storage garbage collection may be held back while the agent is "
+     "busy (0 = collect on a fixed schedule)."},
+    {OPTION_GC_MAX_REQUEST_RATE,
+     "Requests per second above which storage garbage collection is held "
+     "back."},
+    {OPTION_GC_MAX_IN_FLIGHT,
+     "Requests in flight above which storage garbage collection is held "
+     "back."},
+    {OPTION_HEAVY_HITTERS,
+     "Nyms, connections and command types each tracked for the heavy "
+     "hitters in METRICS (0 = disabled, default 64)."},
+    {OPTION_HEAVY_HITTERS_HALF_LIFE,
+     "Seconds after which heavy hitter counts have decayed by half (0 = no "
+     "decay, default 60)."},
+    {OPTION_ACCOUNT_OWNER_CACHE_SIZE,
+     "Account owners kept in memory (0 = disabled, default 100000)."},
+    {OPTION_IDEMPOTENCY_TTL,
+     "Seconds to remember the response to a request with an idempotency key."},
+    {OPTION_IDEMPOTENCY_CAPACITY,
+     "Maximum number of remembered idempotency keys."},
+    {OPTION_PUSH_BUFFER_SIZE,
+     "Undelivered push notifications kept for each nym until it reconnects "
+     "(0 = disabled, default 100)."},
+    {OPTION_PUSH_BUFFER_TOTAL,
+     "Undelivered push notifications kept for all nyms (default 10000)."},
+    {OPTION_PUSH_BUFFER_AGE,
+     "Seconds an undelivered push notification is kept (default 300)."},
+    {OPTION_SESSION_IDLE,
+     "Seconds without commands after which a client session stops "
+     "refreshing until its next command (0 = never, default)."},
+    {OPTION_SHM_CHANNELS,
+     "Number of shared memory client channels for clients on this host "
+     "(0 = disabled)."},
+    {OPTION_SHM_NAME,
+     "Shared memory segment name (default /otagent-<uid>)."},
+    {OPTION_SHM_RING_SIZE,
+     "KiB in each shared memory ring, a power of two (default 1024)."},
+    {OPTION_TASK_TTL,
+     "Seconds after which a task that hasn't finished is forgotten and no "
+     "completion push is sent for it, and after which a nym whose "
+     "connection can't be sent to is no longer associated with it (0 = "
+     "never, default 86400)."},
+    {OPTION_SUBSCRIPTION_LIMIT,
+     "Query subscriptions each connection may hold (0 = disabled, default "
+     "16)."},
+    {OPTION_SUBSCRIPTION_TOTAL,
+     "Query subscriptions across all connections (0 = no limit, default "
+     "10000)."},
+    {OPTION_SUBSCRIPTION_TTL,
+     "Seconds without requests from a connection after which its "
+     "subscriptions end. UNSUBSCRIBE 0 keeps them without doing anything "
+     "else (0 = never, default 600)."},
+    {OPTION_WARMUP,
+     "Preload client sessions before accepting requests (1 = yes, 0 = no). "
+     "Requests get a NOT_READY retry until warmup finishes."},
+    {OPTION_SYNTHETIC_LATENCY,
+     "Microseconds spent in each synthetic command."},
+    {OPTION_SYNTHETIC_TASK_DELAY,
+     "Milliseconds before a synthetic task completes."},
+    {OPTION_SYNTHETIC_TASK_FAILURE, "Percentage of synthetic tasks that fail."},
+    {OPTION_SYNTHETIC_TASK_LOST,
+     "Percentage of synthetic tasks that never complete."},
+};
+
 void cleanup_globals();
 po::variables_map& variables();
 po::options_description& options();         // command line options
@@ -81,6 +240,11 @@ po::options_description& options()
             po::value<std::vector<std::string>>()->multitoken(),
             "Tcp endpoint(s).")(
             OPTION_LOG_ENDPOINT, po::value<std::string>(), "Log endpoint.");
+
+        for (const auto& tunable : tunables_) {
+            options_->add_options()(
+                tunable.name, po::value<std::string>(), tunable.description);
+        }
     }
 
     return *options_;
@@ -117,6 +281,13 @@ po::options_description& config_options()
             config_option_name(CONFIG_CLIENT_PUBKEY).c_str(),
             po::value<std::string>(),
             "Client public key");
+
+        for (const auto& tunable : tunables_) {
+            config_options_->add_options()(
+                config_option_name(tunable.name).c_str(),
+                po::value<std::string>(),
+                tunable.description);
+        }
     }
 
     return *config_options_;
@@ -183,6 +354,43 @@ std::int64_t max_option_value(std::string name)
     return std::max(command_line_value, config_file_value);
 }
 
+// Returns the command line value if present, otherwise the config file value.
+std::string string_option_value(std::string name);
+std::string string_option_value(std::string name)
+{
+    if (!variables()[name].empty()) {
+        return variables()[name].as<std::string>();
+    }
+
+    std::string config_name = config_option_name(name.c_str());
+
+    if (!variables()[config_name].empty()) {
+        return variables()[config_name].as<std::string>();
+    }
+
+    return {};
+}
+
+// Returns the command line or config file value as an integer, or the default
+// if neither is set or the value is not a number
+std::int64_t int_option_value(
+    std::string name,
+    const std::int64_t defaultValue);
+std::int64_t int_option_value(
+    std::string name,
+    const std::int64_t defaultValue)
+{
+    const auto value = string_option_value(name);
+
+    if (value.empty()) { return defaultValue; }
+
+    try {
+        return std::stoll(value);
+    } catch (const std::exception&) {
+        return defaultValue;
+    }
+}
+
 // Converts a string containing multiple items separated by spaces to a vector.
 std::vector<std::string> string_to_vector(std::string s);
 std::vector<std::string> string_to_vector(std::string s)
@@ -249,8 +457,13 @@ int main(int argc, char** argv)
             variables()[OPTION_LOG_ENDPOINT].as<std::string>());
     }
 
-    const auto& ot =
-        opentxs::OT::Start(args, std::chrono::seconds(OT_STORAGE_GC_SECONDS));
+    // With a maximum delay the agent decides when to collect garbage, so
+    // opentxs's own schedule is pushed out of the way
+    const bool agentGC = 0 < int_option_value(OPTION_GC_MAX_DELAY, 0);
+    const auto gcInterval =
+        agentGC ? OT_STORAGE_GC_DISABLED
+                : int_option_value(OPTION_GC_INTERVAL, OT_STORAGE_GC_SECONDS);
+    const auto& ot = opentxs::OT::Start(args, std::chrono::seconds(gcInterval));
 
     // Use the max of the values from the command line and the config file.
     std::int64_t clients = max_option_value(OPTION_CLIENTS);
@@ -413,10 +626,28 @@ int main(int argc, char** argv)
         section.put(OPTION_ENDPOINT, endpoints_string);
     }
 
+    // Tunables from the config file are written back so they survive the
+    // rewrite. Command line values only apply to this run.
+    pt::ptree runtime;
+
+    for (const auto& tunable : tunables_) {
+        const auto& saved = variables()[config_option_name(tunable.name)];
+        const auto& given = variables()[tunable.name];
+
+        if (false == saved.empty()) {
+            section.put(tunable.name, saved.as<std::string>());
+        }
+
+        if (false == given.empty()) {
+            runtime.put(tunable.name, given.as<std::string>());
+        }
+    }
+
     root.push_front(pt::ptree::value_type("otagent", section));
     fs::fstream settingsfile(settings_path, std::ios::out);
     pt::write_ini(settingsfile, root);
     settingsfile.close();
+    root.push_back(pt::ptree::value_type(CONFIG_RUNTIME_SECTION, runtime));
     std::unique_ptr<opentxs::agent::Agent> otagent;
     otagent.reset(new opentxs::agent::Agent(
         ot,
@@ -433,6 +664,7 @@ int main(int argc, char** argv)
     std::function<void()> shutdowncallback = [&otagent]() -> void {
         opentxs::LogNormal(OT_METHOD)(__FUNCTION__)(": Shutting down...")
             .Flush();
+        otagent->Drain();
         otagent.reset();
     };
     opentxs::OT::App().HandleSignals(&shutdowncallback);
@@ -0,0 +1,99 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "AccountOwnerCache.hpp"
+
+#include <gtest/gtest.h>
+
+namespace agent = opentxs::agent;
+
+namespace
+{
+class Test_AccountOwnerCache : public ::testing::Test
+{
+public:
+    std::vector<std::string> lookups_;
+    const agent::AccountOwnerCache::Lookup lookup_;
+
+    Test_AccountOwnerCache()
+        : lookups_()
+        , lookup_([this](const std::string& account) -> std::string {
+            lookups_.emplace_back(account);
+
+            return ("unknown" == account) ? "" : "owner-" + account;
+        })
+    {
+    }
+};
+
+TEST_F(Test_AccountOwnerCache, get)
+{
+    agent::AccountOwnerCache cache{10};
+
+    EXPECT_EQ("owner-a", cache.Get("a", lookup_));
+    EXPECT_EQ("owner-a", cache.Get("a", lookup_));
+    EXPECT_EQ(std::vector<std::string>{"a"}, lookups_);
+    EXPECT_EQ(1, cache.Hits());
+    EXPECT_EQ(1, cache.Misses());
+    EXPECT_EQ(1, cache.Size());
+}
+
+TEST_F(Test_AccountOwnerCache, unknown_not_cached)
+{
+    agent::AccountOwnerCache cache{10};
+
+    EXPECT_TRUE(cache.Get("unknown", lookup_).empty());
+    EXPECT_TRUE(cache.Get("unknown", lookup_).empty());
+    EXPECT_EQ(2, lookups_.size());
+    EXPECT_EQ(0, cache.Size());
+    EXPECT_TRUE(cache.Get("", lookup_).empty());
+    EXPECT_EQ(2, lookups_.size());
+}
+
+TEST_F(Test_AccountOwnerCache, capacity)
+{
+    agent::AccountOwnerCache cache{2};
+    cache.Add("a", "owner-a");
+    cache.Add("b", "owner-b");
+    cache.Add("a", "other");
+    cache.Add("c", "owner-c");
+
+    EXPECT_EQ(2, cache.Size());
+    EXPECT_EQ(1, cache.Evicted());
+    EXPECT_EQ("owner-b", cache.Get("b", lookup_));
+    EXPECT_EQ("owner-c", cache.Get("c", lookup_));
+    EXPECT_TRUE(lookups_.empty());
+    EXPECT_EQ("owner-a", cache.Get("a", lookup_));
+    EXPECT_EQ(std::vector<std::string>{"a"}, lookups_);
+    EXPECT_EQ(2, cache.Evicted());
+}
+
+TEST_F(Test_AccountOwnerCache, remove)
+{
+    agent::AccountOwnerCache cache{2};
+    cache.Add("a", "owner-a");
+    cache.Add("b", "owner-b");
+    cache.Remove({"a", "missing"});
+
+    EXPECT_EQ(1, cache.Size());
+
+    cache.Add("c", "owner-c");
+
+    EXPECT_EQ(0, cache.Evicted());
+    EXPECT_EQ("owner-a", cache.Get("a", lookup_));
+    EXPECT_EQ(1, cache.Evicted());
+    EXPECT_EQ("owner-c", cache.Get("c", lookup_));
+}
+
+TEST_F(Test_AccountOwnerCache, disabled)
+{
+    agent::AccountOwnerCache cache{0};
+
+    EXPECT_EQ("owner-a", cache.Get("a", lookup_));
+    EXPECT_EQ("owner-a", cache.Get("a", lookup_));
+    EXPECT_EQ(2, lookups_.size());
+    EXPECT_EQ(0, cache.Size());
+}
+}  // namespace
@@ -0,0 +1,56 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "Authenticator.hpp"
+
+#include <gtest/gtest.h>
+
+using Authenticator = opentxs::agent::Authenticator;
+
+namespace
+{
+TEST(Test_Authenticator, peer_address)
+{
+    const auto peer =
+        Authenticator::ParsePeerAddress("localhost:1000:100:4242");
+
+    ASSERT_TRUE(peer.has_value());
+    EXPECT_EQ(1000, peer->uid_);
+    EXPECT_EQ(100, peer->gid_);
+    EXPECT_EQ(4242, peer->pid_);
+}
+
+TEST(Test_Authenticator, peer_address_prefix)
+{
+    const auto bare = Authenticator::ParsePeerAddress(":0:0:1");
+    const auto colons = Authenticator::ParsePeerAddress("a:b:1:2:3");
+
+    ASSERT_TRUE(bare.has_value());
+    EXPECT_EQ(0, bare->uid_);
+    EXPECT_EQ(1, bare->pid_);
+    ASSERT_TRUE(colons.has_value());
+    EXPECT_EQ(1, colons->uid_);
+    EXPECT_EQ(3, colons->pid_);
+}
+
+TEST(Test_Authenticator, peer_address_missing_fields)
+{
+    EXPECT_FALSE(Authenticator::ParsePeerAddress(""));
+    EXPECT_FALSE(Authenticator::ParsePeerAddress("localhost"));
+    EXPECT_FALSE(Authenticator::ParsePeerAddress("127.0.0.1:5555"));
+    EXPECT_FALSE(Authenticator::ParsePeerAddress("x:1:2"));
+    EXPECT_FALSE(Authenticator::ParsePeerAddress("1000:100:5"));
+}
+
+TEST(Test_Authenticator, peer_address_malformed_fields)
+{
+    EXPECT_FALSE(Authenticator::ParsePeerAddress(":::"));
+    EXPECT_FALSE(Authenticator::ParsePeerAddress("localhost:1:2:3x"));
+    EXPECT_FALSE(Authenticator::ParsePeerAddress("localhost:1:x:3"));
+    EXPECT_FALSE(Authenticator::ParsePeerAddress("localhost:-1:2:3"));
+    EXPECT_FALSE(Authenticator::ParsePeerAddress("localhost:1:2:"));
+    EXPECT_FALSE(Authenticator::ParsePeerAddress("localhost:1:2:4294967296"));
+}
+}  // namespace
@@ -0,0 +1,171 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "Capture.hpp"
+
+#include <boost/filesystem.hpp>
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+namespace capture = opentxs::agent::capture;
+namespace fs = boost::filesystem;
+
+namespace
+{
+// Magic, version, flags and start time
+const std::uint64_t header_size_{20};
+
+class Test_Capture : public ::testing::Test
+{
+public:
+    const std::string path_;
+
+    Test_Capture()
+        : path_((fs::temp_directory_path() /
+                 fs::unique_path("otagent-capture-%%%%-%%%%"))
+                    .string())
+    {
+    }
+
+    ~Test_Capture() { fs::remove(path_); }
+};
+
+TEST_F(Test_Capture, round_trip)
+{
+    const capture::Frames first{"command", "TIMEOUT", "500"};
+    const capture::Frames second{"", std::string("\0\1", 2)};
+
+    {
+        auto writer =
+            capture::Writer::Open(path_, capture::FlagRedacted, 1 << 20);
+
+        ASSERT_TRUE(writer);
+        EXPECT_EQ(header_size_, writer->Bytes());
+        EXPECT_TRUE(writer->Write("connection", first));
+        EXPECT_TRUE(writer->Write("", second));
+        EXPECT_EQ(2, writer->Records());
+        // time, sizes of the connection and frame count, frames
+        EXPECT_EQ(
+            header_size_ + (11 + 10 + 4 * 3 + 17) + (11 + 0 + 4 * 2 + 2),
+            writer->Bytes());
+    }
+
+    auto reader = capture::Reader::Open(path_);
+
+    ASSERT_TRUE(reader);
+    EXPECT_EQ(capture::FlagRedacted, reader->Flags());
+    EXPECT_LT(0, reader->Start());
+
+    capture::Record record{};
+
+    ASSERT_TRUE(reader->Next(record));
+    EXPECT_EQ("connection", record.connection_);
+    EXPECT_EQ(first, record.frames_);
+
+    const auto time = record.time_;
+
+    ASSERT_TRUE(reader->Next(record));
+    EXPECT_TRUE(record.connection_.empty());
+    EXPECT_EQ(second, record.frames_);
+    EXPECT_LE(time, record.time_);
+    EXPECT_FALSE(reader->Next(record));
+}
+
+TEST_F(Test_Capture, size_limit)
+{
+    const capture::Frames frames{"command"};
+    // 11 bytes of sizes and the time, 4 for the frame size
+    const std::uint64_t record{11 + 1 + 4 + 7};
+
+    {
+        auto writer = capture::Writer::Open(path_, 0, header_size_ + record);
+
+        ASSERT_TRUE(writer);
+        EXPECT_TRUE(writer->Write("c", frames));
+        EXPECT_FALSE(writer->Write("c", frames));
+        EXPECT_FALSE(writer->Write("", {}));
+        EXPECT_EQ(1, writer->Records());
+        EXPECT_EQ(header_size_ + record, writer->Bytes());
+    }
+
+    EXPECT_EQ(header_size_ + record, fs::file_size(path_));
+}
+
+TEST_F(Test_Capture, oversized_connection_skipped)
+{
+    {
+        auto writer = capture::Writer::Open(path_, 0, 1 << 20);
+
+        ASSERT_TRUE(writer);
+        EXPECT_TRUE(writer->Write(std::string(256, 'c'), {"command"}));
+        EXPECT_EQ(0, writer->Records());
+        EXPECT_TRUE(writer->Write(std::string(255, 'c'), {"command"}));
+        EXPECT_EQ(1, writer->Records());
+    }
+
+    auto reader = capture::Reader::Open(path_);
+    capture::Record record{};
+
+    ASSERT_TRUE(reader);
+    ASSERT_TRUE(reader->Next(record));
+    EXPECT_EQ(255, record.connection_.size());
+    EXPECT_FALSE(reader->Next(record));
+}
+
+TEST_F(Test_Capture, truncated_record)
+{
+    {
+        auto writer = capture::Writer::Open(path_, 0, 1 << 20);
+
+        ASSERT_TRUE(writer);
+        EXPECT_TRUE(writer->Write("c", {"first"}));
+        EXPECT_TRUE(writer->Write("c", {"second"}));
+    }
+
+    fs::resize_file(path_, fs::file_size(path_) - 1);
+    auto reader = capture::Reader::Open(path_);
+    capture::Record record{};
+
+    ASSERT_TRUE(reader);
+    EXPECT_TRUE(reader->Next(record));
+    EXPECT_FALSE(reader->Next(record));
+}
+
+TEST_F(Test_Capture, not_a_capture)
+{
+    EXPECT_FALSE(capture::Reader::Open(path_));
+
+    {
+        std::ofstream file(path_, std::ios::binary);
+        file << "OTACAP";
+    }
+
+    EXPECT_FALSE(capture::Reader::Open(path_));
+
+    {
+        std::ofstream file(path_, std::ios::binary);
+        file << std::string(header_size_, 'x');
+    }
+
+    EXPECT_FALSE(capture::Reader::Open(path_));
+
+    {
+        auto writer = capture::Writer::Open(path_, 0, 1 << 20);
+
+        ASSERT_TRUE(writer);
+    }
+
+    // Unsupported version
+    {
+        std::fstream file(
+            path_, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(6);
+        file.put('\xff');
+    }
+
+    EXPECT_FALSE(capture::Reader::Open(path_));
+}
+}  // namespace
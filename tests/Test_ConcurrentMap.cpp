@@ -0,0 +1,123 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "ConcurrentMap.hpp"
+
+#include <gtest/gtest.h>
+
+namespace agent = opentxs::agent;
+
+namespace
+{
+using Map = agent::ConcurrentMap<int, std::string>;
+
+const auto odd_ = [](const int key, const std::string&) {
+    return 1 == (key % 2);
+};
+
+std::vector<int> keys(const std::vector<std::pair<int, std::string>>& entries)
+{
+    std::vector<int> output{};
+
+    for (const auto& entry : entries) { output.emplace_back(entry.first); }
+
+    return output;
+}
+
+TEST(Test_ConcurrentMap, add_set_take)
+{
+    Map map{};
+
+    EXPECT_TRUE(map.Add(1, "a"));
+    EXPECT_FALSE(map.Add(1, "b"));
+    EXPECT_EQ("a", map.Find(1).value());
+    EXPECT_FALSE(map.Set(2, "b").has_value());
+    EXPECT_EQ("b", map.Set(2, "c").value());
+    EXPECT_EQ("c", map.Take(2).value());
+    EXPECT_FALSE(map.Take(2).has_value());
+    EXPECT_TRUE(map.Erase(1));
+    EXPECT_FALSE(map.Erase(1));
+    EXPECT_EQ(0, map.Size());
+}
+
+TEST(Test_ConcurrentMap, find_action)
+{
+    Map map{};
+    map.Add(1, "a");
+    std::string seen{};
+    const auto action = [&seen](const std::string& value) { seen = value; };
+
+    EXPECT_FALSE(map.Find(2, action).has_value());
+    EXPECT_TRUE(seen.empty());
+    EXPECT_EQ("a", map.Find(1, action).value());
+    EXPECT_EQ("a", seen);
+}
+
+TEST(Test_ConcurrentMap, modify)
+{
+    Map map{};
+    map.Add(1, "a");
+    const auto append = [](std::string& value) { value += "b"; };
+
+    EXPECT_FALSE(map.Modify(2, append));
+    EXPECT_FALSE(map.Find(2).has_value());
+    EXPECT_TRUE(map.Modify(1, append));
+    EXPECT_EQ("ab", map.Find(1).value());
+}
+
+TEST(Test_ConcurrentMap, take_if_all)
+{
+    Map map{};
+
+    for (int i{0}; i < 10; ++i) { map.Add(i, std::to_string(i)); }
+
+    std::optional<int> position{};
+    const auto taken = map.TakeIf(odd_, position, 100);
+
+    EXPECT_EQ((std::vector<int>{1, 3, 5, 7, 9}), keys(taken));
+    EXPECT_EQ("3", taken.at(1).second);
+    EXPECT_FALSE(position.has_value());
+    EXPECT_EQ(5, map.Size());
+}
+
+TEST(Test_ConcurrentMap, take_if_batches)
+{
+    Map map{};
+
+    for (int i{0}; i < 10; ++i) { map.Add(i, std::to_string(i)); }
+
+    std::optional<int> position{};
+    std::vector<int> taken{};
+    std::size_t batches{0};
+
+    do {
+        const auto batch = keys(map.TakeIf(odd_, position, 3));
+        taken.insert(taken.end(), batch.begin(), batch.end());
+        ++batches;
+    } while (position.has_value());
+
+    EXPECT_EQ((std::vector<int>{1, 3, 5, 7, 9}), taken);
+    EXPECT_EQ(4, batches);
+    EXPECT_EQ(5, map.Size());
+}
+
+TEST(Test_ConcurrentMap, take_if_position_removed)
+{
+    Map map{};
+
+    for (int i{0}; i < 6; ++i) { map.Add(i, std::to_string(i)); }
+
+    std::optional<int> position{};
+    map.TakeIf(odd_, position, 2);
+
+    ASSERT_EQ(2, position.value());
+
+    // The next batch starts at the following key if position is erased
+    map.Erase(2);
+
+    EXPECT_EQ((std::vector<int>{3, 5}), keys(map.TakeIf(odd_, position, 10)));
+    EXPECT_FALSE(position.has_value());
+}
+}  // namespace
@@ -0,0 +1,136 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "GCScheduler.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+namespace agent = opentxs::agent;
+
+namespace
+{
+using Scheduler = agent::GCScheduler;
+
+const std::chrono::milliseconds wait_{5000};
+
+// Collections are due immediately and checked for every few milliseconds
+Scheduler::Settings settings()
+{
+    Scheduler::Settings output{};
+    output.interval_ = std::chrono::seconds(0);
+    output.max_delay_ = std::chrono::seconds(600);
+    output.max_request_rate_ = 1000;
+    output.max_in_flight_ = 4;
+    output.check_interval_ = std::chrono::milliseconds(10);
+
+    return output;
+}
+
+// Waits until the scheduler has run count collections
+bool wait(const Scheduler& scheduler, const std::uint64_t count)
+{
+    const auto deadline = std::chrono::steady_clock::now() + wait_;
+
+    while (scheduler.Snapshot().runs_ < count) {
+        if (std::chrono::steady_clock::now() > deadline) { return false; }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    return true;
+}
+
+TEST(Test_GCScheduler, quiet)
+{
+    std::atomic<std::uint64_t> runs{0};
+    Scheduler scheduler{
+        settings(),
+        []() { return Scheduler::Load{}; },
+        [&runs]() { ++runs; }};
+
+    ASSERT_TRUE(wait(scheduler, 2));
+
+    const auto stats = scheduler.Snapshot();
+
+    EXPECT_LE(stats.runs_, runs.load());
+    EXPECT_EQ(0, stats.forced_);
+}
+
+TEST(Test_GCScheduler, interval)
+{
+    auto config = settings();
+    config.interval_ = std::chrono::seconds(600);
+    Scheduler scheduler{
+        config, []() { return Scheduler::Load{}; }, []() {}};
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    EXPECT_EQ(0, scheduler.Snapshot().runs_);
+}
+
+TEST(Test_GCScheduler, in_flight)
+{
+    std::atomic<std::int64_t> inFlight{5};
+    Scheduler scheduler{
+        settings(),
+        [&inFlight]() { return Scheduler::Load{0, inFlight.load()}; },
+        []() {}};
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    EXPECT_EQ(0, scheduler.Snapshot().runs_);
+
+    inFlight.store(4);
+
+    ASSERT_TRUE(wait(scheduler, 1));
+    EXPECT_EQ(0, scheduler.Snapshot().forced_);
+}
+
+TEST(Test_GCScheduler, request_rate)
+{
+    std::atomic<bool> busy{true};
+    std::atomic<std::uint64_t> requests{0};
+    Scheduler scheduler{
+        settings(),
+        [&]() {
+            // Far more than max_request_rate_ per second while busy
+            if (busy.load()) { requests += 1000; }
+
+            return Scheduler::Load{requests.load(), 0};
+        },
+        []() {}};
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    EXPECT_EQ(0, scheduler.Snapshot().runs_);
+
+    busy.store(false);
+
+    ASSERT_TRUE(wait(scheduler, 1));
+    EXPECT_EQ(0, scheduler.Snapshot().forced_);
+}
+
+TEST(Test_GCScheduler, max_delay)
+{
+    auto config = settings();
+    config.max_delay_ = std::chrono::seconds(0);
+    Scheduler scheduler{
+        config, []() { return Scheduler::Load{0, 100}; }, []() {}};
+
+    ASSERT_TRUE(wait(scheduler, 1));
+    EXPECT_LE(1, scheduler.Snapshot().forced_);
+}
+
+TEST(Test_GCScheduler, waiting)
+{
+    Scheduler scheduler{
+        settings(), []() { return Scheduler::Load{0, 100}; }, []() {}};
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    const auto stats = scheduler.Snapshot();
+
+    EXPECT_EQ(0, stats.runs_);
+    EXPECT_LE(1, stats.waiting_.count());
+}
+}  // namespace
@@ -0,0 +1,109 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "HeavyHitters.hpp"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+namespace agent = opentxs::agent;
+
+namespace
+{
+const std::chrono::seconds no_decay_{0};
+
+void add(agent::HeavyHitters& sketch, const std::string& key, int count)
+{
+    while (0 < count--) { sketch.Add(key); }
+}
+
+TEST(Test_HeavyHitters, disabled)
+{
+    agent::HeavyHitters sketch{0, no_decay_};
+    sketch.Add("a");
+
+    EXPECT_FALSE(sketch.Enabled());
+    EXPECT_TRUE(sketch.Top(10).empty());
+    EXPECT_EQ(0.0, sketch.Total());
+}
+
+TEST(Test_HeavyHitters, exact_below_capacity)
+{
+    agent::HeavyHitters sketch{3, no_decay_};
+    add(sketch, "a", 2);
+    add(sketch, "b", 5);
+    add(sketch, "c", 1);
+    const auto top = sketch.Top(10);
+
+    ASSERT_EQ(3, top.size());
+    EXPECT_EQ("b", top.at(0).key_);
+    EXPECT_EQ(5.0, top.at(0).count_);
+    EXPECT_EQ("a", top.at(1).key_);
+    EXPECT_EQ("c", top.at(2).key_);
+    EXPECT_EQ(0.0, top.at(2).error_);
+    EXPECT_EQ(8.0, sketch.Total());
+    EXPECT_EQ(2, sketch.Top(2).size());
+}
+
+TEST(Test_HeavyHitters, replaces_minimum)
+{
+    agent::HeavyHitters sketch{2, no_decay_};
+    add(sketch, "a", 5);
+    add(sketch, "b", 2);
+    add(sketch, "c", 1);
+    const auto top = sketch.Top(10);
+
+    ASSERT_EQ(2, top.size());
+    EXPECT_EQ("a", top.at(0).key_);
+    EXPECT_EQ("c", top.at(1).key_);
+    EXPECT_EQ(3.0, top.at(1).count_);
+    EXPECT_EQ(2.0, top.at(1).error_);
+    EXPECT_EQ(8.0, sketch.Total());
+}
+
+TEST(Test_HeavyHitters, frequent_key_survives)
+{
+    agent::HeavyHitters sketch{4, no_decay_};
+
+    for (int i{0}; i < 1000; ++i) {
+        sketch.Add("hot");
+        sketch.Add(std::to_string(i));
+    }
+
+    const auto top = sketch.Top(1);
+
+    ASSERT_EQ(1, top.size());
+    EXPECT_EQ("hot", top.at(0).key_);
+    EXPECT_LE(1000.0, top.at(0).count_);
+    EXPECT_GE(1000.0, top.at(0).count_ - top.at(0).error_);
+}
+
+TEST(Test_HeavyHitters, truncates_keys)
+{
+    agent::HeavyHitters sketch{2, no_decay_};
+    const std::string prefix(agent::HeavyHitters::MaxKeySize, 'x');
+    sketch.Add(prefix + "a");
+    sketch.Add(prefix + "b");
+    const auto top = sketch.Top(10);
+
+    ASSERT_EQ(1, top.size());
+    EXPECT_EQ(prefix, top.at(0).key_);
+    EXPECT_EQ(2.0, top.at(0).count_);
+}
+
+TEST(Test_HeavyHitters, decay)
+{
+    agent::HeavyHitters sketch{2, std::chrono::seconds(1)};
+    add(sketch, "a", 8);
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    const auto top = sketch.Top(1);
+
+    ASSERT_EQ(1, top.size());
+    EXPECT_GT(4.1, top.at(0).count_);
+    EXPECT_LT(2.0, top.at(0).count_);
+    EXPECT_GT(4.1, sketch.Total());
+}
+}  // namespace
@@ -0,0 +1,120 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "IdempotencyCache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+namespace agent = opentxs::agent;
+
+namespace
+{
+using Cache = agent::IdempotencyCache;
+
+const std::chrono::seconds ttl_{1};
+
+Cache::Result result(const std::string& owner)
+{
+    return Cache::Result{{}, agent::TaskOwners{owner}};
+}
+
+TEST(Test_IdempotencyCache, replay)
+{
+    Cache cache{ttl_, 10};
+    const auto first = cache.Start("key", 1);
+
+    ASSERT_EQ(Cache::Status::Run, first.status_);
+
+    const auto waiting = cache.Start("key", 1);
+
+    ASSERT_EQ(Cache::Status::Replay, waiting.status_);
+
+    cache.Finish("key", first.id_, result("nym"));
+    const auto finished = cache.Start("key", 1);
+
+    ASSERT_EQ(Cache::Status::Replay, finished.status_);
+    EXPECT_EQ(agent::TaskOwners{"nym"}, waiting.future_.get().second);
+    EXPECT_EQ(agent::TaskOwners{"nym"}, finished.future_.get().second);
+    EXPECT_EQ(2, cache.Hits());
+    EXPECT_EQ(1, cache.Size());
+}
+
+TEST(Test_IdempotencyCache, conflict)
+{
+    Cache cache{ttl_, 10};
+    const auto first = cache.Start("key", 1);
+
+    EXPECT_EQ(Cache::Status::Conflict, cache.Start("key", 2).status_);
+
+    cache.Finish("key", first.id_, result("nym"));
+
+    EXPECT_EQ(Cache::Status::Conflict, cache.Start("key", 2).status_);
+    EXPECT_EQ(Cache::Status::Run, cache.Start("other", 2).status_);
+    EXPECT_EQ(0, cache.Hits());
+}
+
+TEST(Test_IdempotencyCache, abandon)
+{
+    Cache cache{ttl_, 10};
+    const auto first = cache.Start("key", 1);
+    const auto waiting = cache.Start("key", 1);
+    cache.Abandon("key", first.id_);
+
+    EXPECT_THROW(waiting.future_.get(), std::runtime_error);
+    EXPECT_EQ(0, cache.Size());
+    EXPECT_EQ(Cache::Status::Run, cache.Start("key", 1).status_);
+}
+
+TEST(Test_IdempotencyCache, capacity)
+{
+    Cache cache{ttl_, 2};
+
+    for (const auto& key : {"a", "b", "c"}) {
+        cache.Finish(key, cache.Start(key, 1).id_, result(key));
+    }
+
+    // Pruning runs when a key is started
+    EXPECT_EQ(Cache::Status::Run, cache.Start("a", 1).status_);
+    EXPECT_EQ(Cache::Status::Replay, cache.Start("b", 1).status_);
+    EXPECT_EQ(Cache::Status::Replay, cache.Start("c", 1).status_);
+}
+
+TEST(Test_IdempotencyCache, running_not_evicted_by_capacity)
+{
+    Cache cache{ttl_, 1};
+    const auto running = cache.Start("a", 1);
+
+    for (const auto& key : {"b", "c", "d"}) {
+        cache.Finish(key, cache.Start(key, 1).id_, result(key));
+    }
+
+    EXPECT_EQ(Cache::Status::Replay, cache.Start("a", 1).status_);
+
+    cache.Finish("a", running.id_, result("a"));
+    EXPECT_EQ(Cache::Status::Replay, cache.Start("a", 1).status_);
+}
+
+TEST(Test_IdempotencyCache, expiry)
+{
+    Cache cache{ttl_, 10};
+    const auto finished = cache.Start("finished", 1);
+    cache.Finish("finished", finished.id_, result("nym"));
+    const auto stuck = cache.Start("stuck", 1);
+    const auto waiting = cache.Start("stuck", 1);
+    std::this_thread::sleep_for(ttl_ + std::chrono::milliseconds(100));
+    cache.Start("other", 1);
+
+    EXPECT_EQ(1, cache.Size());
+    EXPECT_THROW(waiting.future_.get(), std::future_error);
+
+    // Late results for dropped entries are ignored
+    cache.Finish("stuck", stuck.id_, result("nym"));
+
+    EXPECT_EQ(Cache::Status::Run, cache.Start("stuck", 1).status_);
+    EXPECT_EQ(Cache::Status::Run, cache.Start("finished", 1).status_);
+}
+}  // namespace
@@ -0,0 +1,77 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "Interner.hpp"
+
+#include <gtest/gtest.h>
+
+namespace agent = opentxs::agent;
+
+namespace
+{
+TEST(Test_Interner, intern)
+{
+    agent::Interner interner{};
+    const auto a = interner.Intern("a");
+    const auto b = interner.Intern("b");
+
+    EXPECT_NE(a, b);
+    EXPECT_EQ(a, interner.Intern("a"));
+    EXPECT_EQ(2, interner.Size());
+    EXPECT_EQ("a", interner.Resolve(a));
+    EXPECT_EQ("b", interner.Resolve(b));
+    EXPECT_EQ(a, interner.Find("a").value());
+    EXPECT_FALSE(interner.Find("c").has_value());
+}
+
+TEST(Test_Interner, references)
+{
+    agent::Interner interner{};
+    const auto a = interner.Intern("a");
+    interner.Intern("a");
+    interner.Reference(a);
+    interner.Release(a);
+    interner.Release(a);
+
+    EXPECT_EQ(a, interner.Find("a").value());
+    EXPECT_EQ(1, interner.Size());
+
+    interner.Release(a);
+
+    EXPECT_FALSE(interner.Find("a").has_value());
+    EXPECT_EQ(0, interner.Size());
+}
+
+TEST(Test_Interner, find_adds_no_reference)
+{
+    agent::Interner interner{};
+    const auto a = interner.Intern("a");
+    interner.Find("a");
+    interner.Release(a);
+
+    EXPECT_FALSE(interner.Find("a").has_value());
+}
+
+TEST(Test_Interner, reuse)
+{
+    agent::Interner interner{};
+    const auto a = interner.Intern("a");
+    const auto b = interner.Intern("b");
+    interner.Release(a);
+    const auto c = interner.Intern("c");
+
+    EXPECT_EQ(a, c);
+    EXPECT_EQ("c", interner.Resolve(c));
+    EXPECT_EQ("b", interner.Resolve(b));
+    EXPECT_FALSE(interner.Find("a").has_value());
+    EXPECT_EQ(c, interner.Find("c").value());
+
+    const auto d = interner.Intern("d");
+
+    EXPECT_NE(b, d);
+    EXPECT_NE(c, d);
+    EXPECT_EQ(3, interner.Size());
+}
+}  // namespace
@@ -0,0 +1,97 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "Protocol.hpp"
+
+#include <gtest/gtest.h>
+
+namespace agent = opentxs::agent;
+namespace zmq = opentxs::network::zeromq;
+
+namespace
+{
+// Returns the options from a request holding frames after the command
+agent::RequestOptions parse(
+    const std::vector<std::string>& frames,
+    const std::size_t trailing = 0)
+{
+    auto message = zmq::Message::Factory();
+    message->AddFrame();
+    message->AddFrame("command");
+
+    for (const auto& frame : frames) { message->AddFrame(frame); }
+
+    const auto& body = message->Body();
+
+    return agent::ParseOptions(body, 1, body.size() - trailing);
+}
+
+std::chrono::milliseconds timeout(const std::string& value)
+{
+    return parse({"TIMEOUT", value}).timeout_;
+}
+
+TEST(Test_Protocol, no_options)
+{
+    const auto options = parse({});
+
+    EXPECT_TRUE(options.idempotency_key_.empty());
+    EXPECT_EQ(0, options.timeout_.count());
+}
+
+TEST(Test_Protocol, options)
+{
+    const auto options =
+        parse({"IDEMPOTENCY_KEY", "key", "TIMEOUT", "1500"});
+
+    EXPECT_EQ("key", options.idempotency_key_);
+    EXPECT_EQ(1500, options.timeout_.count());
+}
+
+TEST(Test_Protocol, unknown_options)
+{
+    const auto options =
+        parse({"PRIORITY", "high", "TIMEOUT", "10", "idempotency_key", "x"});
+
+    EXPECT_TRUE(options.idempotency_key_.empty());
+    EXPECT_EQ(10, options.timeout_.count());
+}
+
+TEST(Test_Protocol, option_without_value)
+{
+    const auto options = parse({"TIMEOUT", "10", "IDEMPOTENCY_KEY"});
+
+    EXPECT_TRUE(options.idempotency_key_.empty());
+    EXPECT_EQ(10, options.timeout_.count());
+}
+
+TEST(Test_Protocol, range)
+{
+    const auto options = parse({"TIMEOUT", "10", "IDEMPOTENCY_KEY", "x"}, 2);
+
+    EXPECT_TRUE(options.idempotency_key_.empty());
+    EXPECT_EQ(10, options.timeout_.count());
+}
+
+TEST(Test_Protocol, timeout_limits)
+{
+    EXPECT_EQ(1, timeout("1").count());
+    EXPECT_EQ(86400000, timeout("86400000").count());
+    EXPECT_EQ(0, timeout("86400001").count());
+    EXPECT_EQ(0, timeout("0").count());
+    EXPECT_EQ(0, timeout("-5").count());
+    EXPECT_EQ(0, timeout("99999999999999999999").count());
+}
+
+TEST(Test_Protocol, malformed_timeout)
+{
+    EXPECT_EQ(0, timeout("").count());
+    EXPECT_EQ(0, timeout("abc").count());
+    EXPECT_EQ(0, timeout("10ms").count());
+    EXPECT_EQ(0, timeout(" 10").count());
+    EXPECT_EQ(0, timeout("1.5").count());
+    EXPECT_EQ(0, timeout(std::string("10\0", 3)).count());
+}
+}  // namespace
@@ -0,0 +1,139 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "PushBuffer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+namespace agent = opentxs::agent;
+
+namespace
+{
+const std::chrono::seconds max_age_{1};
+
+std::vector<std::string> payloads(const agent::PushBuffer::Entries& entries)
+{
+    std::vector<std::string> output{};
+
+    for (const auto& entry : entries) { output.emplace_back(entry.payload_); }
+
+    return output;
+}
+
+TEST(Test_PushBuffer, disabled)
+{
+    agent::PushBuffer perNym{0, 10, max_age_};
+    agent::PushBuffer total{10, 0, max_age_};
+
+    EXPECT_FALSE(perNym.Enabled());
+    EXPECT_FALSE(perNym.Add("a", "1"));
+    EXPECT_FALSE(perNym.Contains("a"));
+    EXPECT_FALSE(total.Add("a", "1"));
+    EXPECT_FALSE(total.Contains("a"));
+}
+
+TEST(Test_PushBuffer, take)
+{
+    agent::PushBuffer buffer{10, 10, max_age_};
+
+    EXPECT_TRUE(buffer.Add("a", "1"));
+    EXPECT_TRUE(buffer.Add("a", "2"));
+    EXPECT_TRUE(buffer.Add("b", "3"));
+    EXPECT_TRUE(buffer.Contains("a"));
+    EXPECT_EQ((std::vector<std::string>{"1", "2"}), payloads(buffer.Take("a")));
+    EXPECT_FALSE(buffer.Contains("a"));
+    EXPECT_TRUE(buffer.Take("a").empty());
+
+    const auto stats = buffer.Snapshot();
+
+    EXPECT_EQ(1, stats.nyms_);
+    EXPECT_EQ(1, stats.buffered_);
+    EXPECT_EQ(2, stats.delivered_);
+}
+
+TEST(Test_PushBuffer, per_nym_limit)
+{
+    agent::PushBuffer buffer{3, 10, max_age_};
+
+    for (const auto& payload : {"1", "2", "3", "4", "5"}) {
+        buffer.Add("a", payload);
+    }
+
+    buffer.Add("b", "6");
+    const auto stats = buffer.Snapshot();
+
+    EXPECT_EQ(4, stats.buffered_);
+    EXPECT_EQ(2, stats.evicted_);
+    EXPECT_EQ(
+        (std::vector<std::string>{"3", "4", "5"}), payloads(buffer.Take("a")));
+}
+
+TEST(Test_PushBuffer, total_limit)
+{
+    agent::PushBuffer buffer{3, 4, max_age_};
+    buffer.Add("a", "1");
+    buffer.Add("b", "2");
+    buffer.Add("a", "3");
+    buffer.Add("c", "4");
+    buffer.Add("b", "5");
+    buffer.Add("b", "6");
+    const auto stats = buffer.Snapshot();
+
+    EXPECT_EQ(4, stats.buffered_);
+    EXPECT_EQ(2, stats.evicted_);
+    EXPECT_EQ((std::vector<std::string>{"3"}), payloads(buffer.Take("a")));
+    EXPECT_EQ(
+        (std::vector<std::string>{"5", "6"}), payloads(buffer.Take("b")));
+    EXPECT_EQ((std::vector<std::string>{"4"}), payloads(buffer.Take("c")));
+}
+
+TEST(Test_PushBuffer, total_limit_removes_empty_nym)
+{
+    agent::PushBuffer buffer{3, 1, max_age_};
+    buffer.Add("a", "1");
+    buffer.Add("b", "2");
+
+    EXPECT_FALSE(buffer.Contains("a"));
+    EXPECT_EQ(1, buffer.Snapshot().nyms_);
+}
+
+TEST(Test_PushBuffer, restore)
+{
+    agent::PushBuffer buffer{3, 10, max_age_};
+    buffer.Add("a", "1");
+    buffer.Add("a", "2");
+    auto entries = buffer.Take("a");
+    buffer.Add("a", "3");
+    buffer.Add("a", "4");
+    buffer.Restore("a", std::move(entries));
+    const auto stats = buffer.Snapshot();
+
+    EXPECT_EQ(0, stats.delivered_);
+    EXPECT_EQ(1, stats.evicted_);
+    EXPECT_EQ(
+        (std::vector<std::string>{"2", "3", "4"}), payloads(buffer.Take("a")));
+}
+
+TEST(Test_PushBuffer, age)
+{
+    agent::PushBuffer buffer{10, 10, max_age_};
+    buffer.Add("a", "1");
+    buffer.Add("b", "2");
+    std::this_thread::sleep_for(max_age_ + std::chrono::milliseconds(100));
+
+    EXPECT_TRUE(buffer.Take("a").empty());
+
+    buffer.Add("c", "3");
+    const auto stats = buffer.Snapshot();
+
+    EXPECT_FALSE(buffer.Contains("b"));
+    EXPECT_EQ(1, stats.nyms_);
+    EXPECT_EQ(1, stats.buffered_);
+    EXPECT_EQ(2, stats.expired_);
+    EXPECT_EQ(0, stats.delivered_);
+}
+}  // namespace
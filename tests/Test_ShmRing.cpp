@@ -0,0 +1,216 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "ShmRing.hpp"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <string>
+
+
+namespace shm = opentxs::agent::shm;
+
+namespace
+{
+const std::uint32_t ring_size_{64};
+const std::chrono::milliseconds no_wait_{0};
+
+class Test_ShmRing : public ::testing::Test
+{
+public:
+    std::unique_ptr<shm::Segment> segment_;
+
+    Test_ShmRing()
+        : segment_(shm::Segment::Create(
+              "/otagent-test-" + std::to_string(::getpid()),
+              1,
+              ring_size_))
+    {
+    }
+
+    shm::Ring& ring() { return segment_->channel(0).request_; }
+    char* data() { return segment_->request_data(0); }
+
+    // Writes raw bytes at the ring's head and publishes them
+    void inject(const std::vector<std::uint32_t>& words)
+    {
+        auto head = ring().head_.load();
+
+        for (const auto word : words) {
+            for (std::size_t i{0}; i < sizeof(word); ++i, ++head) {
+                data()[head & (ring_size_ - 1)] =
+                    reinterpret_cast<const char*>(&word)[i];
+            }
+        }
+
+        ring().head_.store(head);
+    }
+};
+
+TEST_F(Test_ShmRing, round_trip)
+{
+    ASSERT_TRUE(segment_);
+
+    const shm::Frames message{"command", "", "TIMEOUT", "500"};
+    shm::Frames output{};
+
+    EXPECT_FALSE(shm::TryRead(ring(), data(), ring_size_, output));
+    EXPECT_TRUE(shm::Write(
+        ring(), data(), ring_size_, message, no_wait_, nullptr, 0));
+    EXPECT_TRUE(shm::TryRead(ring(), data(), ring_size_, output));
+    EXPECT_EQ(message, output);
+    EXPECT_EQ(ring().head_.load(), ring().tail_.load());
+}
+
+TEST_F(Test_ShmRing, wraps_around)
+{
+    ASSERT_TRUE(segment_);
+
+    const shm::Frames message{"0123456789", "abcdefghij"};
+    shm::Frames output{};
+
+    for (int i{0}; i < 10; ++i) {
+        ASSERT_TRUE(shm::Write(
+            ring(), data(), ring_size_, message, no_wait_, nullptr, 0));
+        ASSERT_TRUE(shm::TryRead(ring(), data(), ring_size_, output));
+        EXPECT_EQ(message, output);
+    }
+}
+
+TEST_F(Test_ShmRing, full_ring)
+{
+    ASSERT_TRUE(segment_);
+
+    const shm::Frames message{std::string(20, 'x')};
+    const shm::Frames oversized{std::string(ring_size_, 'x')};
+
+    EXPECT_FALSE(shm::Write(
+        ring(), data(), ring_size_, oversized, no_wait_, nullptr, 0));
+    EXPECT_TRUE(shm::Write(
+        ring(), data(), ring_size_, message, no_wait_, nullptr, 0));
+    EXPECT_TRUE(shm::Write(
+        ring(), data(), ring_size_, message, no_wait_, nullptr, 0));
+    EXPECT_FALSE(shm::Write(
+        ring(), data(), ring_size_, message, no_wait_, nullptr, 0));
+}
+
+TEST_F(Test_ShmRing, head_beyond_ring)
+{
+    ASSERT_TRUE(segment_);
+
+    shm::Frames output{};
+    ring().head_.store(ring().tail_.load() + ring_size_ + 8);
+
+    EXPECT_FALSE(shm::TryRead(ring(), data(), ring_size_, output));
+    EXPECT_EQ(ring().head_.load(), ring().tail_.load());
+}
+
+TEST_F(Test_ShmRing, head_behind_tail)
+{
+    ASSERT_TRUE(segment_);
+
+    shm::Frames output{};
+    ring().tail_.store(16);
+    ring().head_.store(8);
+
+    EXPECT_FALSE(shm::TryRead(ring(), data(), ring_size_, output));
+    EXPECT_EQ(ring().head_.load(), ring().tail_.load());
+}
+
+TEST_F(Test_ShmRing, message_size_beyond_ring)
+{
+    ASSERT_TRUE(segment_);
+
+    shm::Frames output{};
+    inject({0xffffffff, 1, 4, 0});
+
+    EXPECT_FALSE(shm::TryRead(ring(), data(), ring_size_, output));
+    EXPECT_EQ(ring().head_.load(), ring().tail_.load());
+}
+
+TEST_F(Test_ShmRing, message_size_beyond_head)
+{
+    ASSERT_TRUE(segment_);
+
+    shm::Frames output{};
+    inject({32, 1, 4, 0});
+
+    EXPECT_FALSE(shm::TryRead(ring(), data(), ring_size_, output));
+    EXPECT_EQ(ring().head_.load(), ring().tail_.load());
+}
+
+TEST_F(Test_ShmRing, frame_size_beyond_message)
+{
+    ASSERT_TRUE(segment_);
+
+    shm::Frames output{};
+    inject({16, 1, 0xfffffff0, 0});
+
+    EXPECT_FALSE(shm::TryRead(ring(), data(), ring_size_, output));
+    EXPECT_TRUE(output.empty());
+}
+
+TEST_F(Test_ShmRing, frame_count_beyond_message)
+{
+    ASSERT_TRUE(segment_);
+
+    shm::Frames output{};
+    inject({16, 3, 0, 0});
+
+    EXPECT_FALSE(shm::TryRead(ring(), data(), ring_size_, output));
+}
+
+TEST_F(Test_ShmRing, next_message_after_malformed)
+{
+    ASSERT_TRUE(segment_);
+
+    const shm::Frames message{"command"};
+    shm::Frames output{};
+    inject({16, 1, 0xfffffff0, 0});
+
+    EXPECT_FALSE(shm::TryRead(ring(), data(), ring_size_, output));
+    EXPECT_TRUE(shm::Write(
+        ring(), data(), ring_size_, message, no_wait_, nullptr, 0));
+    EXPECT_TRUE(shm::TryRead(ring(), data(), ring_size_, output));
+    EXPECT_EQ(message, output);
+}
+
+TEST_F(Test_ShmRing, stale_generation)
+{
+    ASSERT_TRUE(segment_);
+
+    const shm::Frames message{"response"};
+    auto& channel = segment_->channel(0);
+    const auto head = channel.response_.head_.load();
+    ++channel.generation_;
+    const auto current = channel.generation_.load();
+
+    EXPECT_FALSE(shm::Write(
+        channel.response_,
+        segment_->response_data(0),
+        ring_size_,
+        message,
+        no_wait_,
+        &channel.generation_,
+        current - 1));
+    EXPECT_EQ(head, channel.response_.head_.load());
+    EXPECT_TRUE(shm::Write(
+        channel.response_,
+        segment_->response_data(0),
+        ring_size_,
+        message,
+        no_wait_,
+        &channel.generation_,
+        current));
+}
+
+TEST_F(Test_ShmRing, segment_parameters)
+{
+    EXPECT_FALSE(shm::Segment::Create("/otagent-test-invalid", 1, 48));
+    EXPECT_FALSE(shm::Segment::Create("/otagent-test-invalid", 0, 64));
+    EXPECT_FALSE(shm::Segment::Open("/otagent-test-missing"));
+}
+}  // namespace
@@ -0,0 +1,203 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "Subscriptions.hpp"
+
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace agent = opentxs::agent;
+
+namespace
+{
+using Items = agent::Subscriptions::Items;
+
+const std::chrono::seconds no_ttl_{0};
+const std::chrono::seconds wait_{5};
+
+// Serves a fixed result to every query and records the deltas sent
+class Test_Subscriptions : public ::testing::Test
+{
+public:
+    struct Delta {
+        std::string connection_{};
+        std::uint64_t id_{0};
+        Items added_{};
+        Items removed_{};
+    };
+
+    std::mutex lock_;
+    std::condition_variable cv_;
+    Items items_;
+    bool deliver_;
+    std::vector<Delta> deltas_;
+    const agent::Subscriptions::QueryFunction query_;
+    const agent::Subscriptions::SendFunction send_;
+
+    Test_Subscriptions()
+        : lock_()
+        , cv_()
+        , items_()
+        , deliver_(true)
+        , deltas_()
+        , query_([this](
+                     const std::string&,
+                     Items& items,
+                     agent::Subscriptions::Nyms& nyms) {
+            std::lock_guard<std::mutex> lock(lock_);
+            items = items_;
+            nyms = {"nym"};
+
+            return true;
+        })
+        , send_([this](
+                    const std::string& connection,
+                    const std::uint64_t id,
+                    const std::string&,
+                    const Items& added,
+                    const Items& removed) {
+            std::lock_guard<std::mutex> lock(lock_);
+            deltas_.push_back(Delta{connection, id, added, removed});
+            cv_.notify_all();
+
+            return deliver_;
+        })
+    {
+    }
+
+    // Waits until count deltas have been sent
+    bool wait(const std::size_t count)
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+
+        return cv_.wait_for(
+            lock, wait_, [&]() { return deltas_.size() >= count; });
+    }
+};
+
+TEST_F(Test_Subscriptions, connection_limit)
+{
+    agent::Subscriptions subscriptions{2, 0, no_ttl_, query_, send_};
+
+    EXPECT_NE(0, subscriptions.Add("a", "command"));
+    EXPECT_NE(0, subscriptions.Add("a", "command"));
+    EXPECT_EQ(0, subscriptions.Add("a", "command"));
+    EXPECT_NE(0, subscriptions.Add("b", "command"));
+}
+
+TEST_F(Test_Subscriptions, total_limit)
+{
+    agent::Subscriptions subscriptions{2, 3, no_ttl_, query_, send_};
+    subscriptions.Add("a", "command");
+    subscriptions.Add("a", "command");
+    const auto id = subscriptions.Add("b", "command");
+
+    EXPECT_NE(0, id);
+    EXPECT_EQ(0, subscriptions.Add("c", "command"));
+    EXPECT_EQ(3, subscriptions.Snapshot().subscriptions_);
+    EXPECT_TRUE(subscriptions.Remove("b", id));
+    EXPECT_NE(0, subscriptions.Add("c", "command"));
+}
+
+TEST_F(Test_Subscriptions, remove)
+{
+    agent::Subscriptions subscriptions{1, 0, no_ttl_, query_, send_};
+    const auto id = subscriptions.Add("a", "command");
+
+    EXPECT_FALSE(subscriptions.Remove("b", id));
+    EXPECT_FALSE(subscriptions.Remove("a", id + 1));
+    EXPECT_TRUE(subscriptions.Remove("a", id));
+    EXPECT_FALSE(subscriptions.Remove("a", id));
+    EXPECT_NE(0, subscriptions.Add("a", "command"));
+}
+
+TEST_F(Test_Subscriptions, deltas)
+{
+    agent::Subscriptions subscriptions{1, 0, no_ttl_, query_, send_};
+    const auto id = subscriptions.Add("a", "command");
+
+    // The first result is sent even though it's empty
+    ASSERT_TRUE(wait(1));
+
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+
+        EXPECT_EQ("a", deltas_.at(0).connection_);
+        EXPECT_EQ(id, deltas_.at(0).id_);
+        EXPECT_TRUE(deltas_.at(0).added_.empty());
+        EXPECT_TRUE(deltas_.at(0).removed_.empty());
+        items_ = {"2", "1"};
+    }
+
+    subscriptions.Notify("other");
+    subscriptions.Notify("nym");
+
+    ASSERT_TRUE(wait(2));
+
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+
+        EXPECT_EQ((Items{"1", "2"}), deltas_.at(1).added_);
+        EXPECT_TRUE(deltas_.at(1).removed_.empty());
+        items_ = {"3", "1"};
+    }
+
+    subscriptions.Notify("nym");
+
+    ASSERT_TRUE(wait(3));
+
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+
+        EXPECT_EQ(Items{"3"}, deltas_.at(2).added_);
+        EXPECT_EQ(Items{"2"}, deltas_.at(2).removed_);
+        EXPECT_EQ(3, deltas_.size());
+    }
+}
+
+TEST_F(Test_Subscriptions, failed_send)
+{
+    deliver_ = false;
+    agent::Subscriptions subscriptions{1, 0, no_ttl_, query_, send_};
+    const auto id = subscriptions.Add("a", "command");
+
+    ASSERT_TRUE(wait(1));
+
+    for (int i{0}; i < 50; ++i) {
+        if (1 == subscriptions.Snapshot().dropped_) { break; }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    const auto stats = subscriptions.Snapshot();
+
+    EXPECT_EQ(1, stats.dropped_);
+    EXPECT_EQ(0, stats.subscriptions_);
+    EXPECT_FALSE(subscriptions.Remove("a", id));
+}
+
+TEST_F(Test_Subscriptions, idle_connections)
+{
+    agent::Subscriptions subscriptions{
+        2, 3, std::chrono::seconds(1), query_, send_};
+    subscriptions.Add("a", "command");
+    subscriptions.Add("a", "command");
+    subscriptions.Add("b", "command");
+
+    for (int i{0}; i < 10; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        subscriptions.Touch("b");
+    }
+
+    const auto stats = subscriptions.Snapshot();
+
+    EXPECT_EQ(1, stats.subscriptions_);
+    EXPECT_EQ(2, stats.expired_);
+    EXPECT_NE(0, subscriptions.Add("c", "command"));
+}
+}  // namespace
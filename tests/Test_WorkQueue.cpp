@@ -0,0 +1,132 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "WorkQueue.hpp"
+
+#include <gtest/gtest.h>
+
+#include <future>
+
+namespace agent = opentxs::agent;
+
+namespace
+{
+using Queue = agent::WorkQueue<std::string>;
+
+// Pops everything queued, in order
+std::vector<std::string> drain(Queue& queue)
+{
+    std::vector<std::string> output{};
+
+    while (0 < queue.Size()) { output.emplace_back(queue.Pop().value()); }
+
+    return output;
+}
+
+void push(Queue& queue, const std::string& key, const std::string& item)
+{
+    EXPECT_EQ(Queue::Status::Queued, queue.Push(key, std::string{item}));
+}
+
+TEST(Test_WorkQueue, fifo_within_flow)
+{
+    Queue queue{1, {}, 0};
+    push(queue, "a", "a1");
+    push(queue, "a", "a2");
+    push(queue, "a", "a3");
+
+    EXPECT_EQ(1, queue.Flows());
+    EXPECT_EQ(3, queue.Size());
+    EXPECT_EQ((std::vector<std::string>{"a1", "a2", "a3"}), drain(queue));
+    EXPECT_EQ(0, queue.Flows());
+}
+
+TEST(Test_WorkQueue, round_robin)
+{
+    Queue queue{1, {}, 0};
+
+    for (const auto& item : {"a1", "a2", "a3"}) { push(queue, "a", item); }
+
+    push(queue, "b", "b1");
+    push(queue, "c", "c1");
+    push(queue, "c", "c2");
+
+    EXPECT_EQ(3, queue.Flows());
+    EXPECT_EQ(
+        (std::vector<std::string>{"a1", "b1", "c1", "a2", "c2", "a3"}),
+        drain(queue));
+}
+
+TEST(Test_WorkQueue, weights)
+{
+    Queue queue{1, {{"a", 2}, {"c", 0}}, 0};
+
+    for (const auto& item : {"a1", "a2", "a3", "a4"}) {
+        push(queue, "a", item);
+    }
+
+    push(queue, "b", "b1");
+    push(queue, "b", "b2");
+    push(queue, "c", "c1");
+    push(queue, "c", "c2");
+
+    EXPECT_EQ(
+        (std::vector<std::string>{
+            "a1", "a2", "b1", "c1", "a3", "a4", "b2", "c2"}),
+        drain(queue));
+}
+
+TEST(Test_WorkQueue, zero_default_weight)
+{
+    Queue queue{0, {}, 0};
+    push(queue, "a", "a1");
+    push(queue, "a", "a2");
+    push(queue, "b", "b1");
+
+    EXPECT_EQ((std::vector<std::string>{"a1", "b1", "a2"}), drain(queue));
+}
+
+TEST(Test_WorkQueue, idle_flow_loses_credit)
+{
+    Queue queue{3, {}, 0};
+    push(queue, "a", "a1");
+    push(queue, "b", "b1");
+
+    EXPECT_EQ("a1", queue.Pop().value());
+
+    // a emptied after one of its three pops, so it rejoins at the back
+    push(queue, "a", "a2");
+    push(queue, "a", "a3");
+    push(queue, "b", "b2");
+
+    EXPECT_EQ(
+        (std::vector<std::string>{"b1", "b2", "a2", "a3"}), drain(queue));
+}
+
+TEST(Test_WorkQueue, capacity)
+{
+    Queue queue{1, {}, 2};
+    push(queue, "a", "a1");
+    push(queue, "b", "b1");
+
+    EXPECT_EQ(Queue::Status::Full, queue.Push("c", "c1"));
+    EXPECT_EQ(2, queue.Size());
+    EXPECT_EQ("a1", queue.Pop().value());
+    EXPECT_EQ(Queue::Status::Queued, queue.Push("c", "c1"));
+}
+
+TEST(Test_WorkQueue, shutdown)
+{
+    Queue queue{1, {}, 0};
+    auto waiting = std::async(std::launch::async, [&queue]() {
+        return queue.Pop();
+    });
+    queue.Shutdown();
+
+    EXPECT_FALSE(waiting.get().has_value());
+    EXPECT_EQ(Queue::Status::Stopped, queue.Push("a", "a1"));
+    EXPECT_FALSE(queue.Pop().has_value());
+}
+}  // namespace
@@ -0,0 +1,375 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "opentxs/opentxs.hpp"
+
+#include "Replay.hpp"
+
+#include <zmq.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+
+#define PUSH_FRAME "PUSH"
+
+namespace opentxs::agent::replay
+{
+static std::int64_t percentile(
+    const std::vector<std::int64_t>& sorted,
+    const double fraction)
+{
+    if (sorted.empty()) { return 0; }
+
+    const auto position = static_cast<std::size_t>(
+        fraction * static_cast<double>(sorted.size()));
+
+    return sorted.at(std::min(position, sorted.size() - 1));
+}
+
+static void print_row(
+    std::ostream& output,
+    const std::string& name,
+    std::vector<std::int64_t>& latency)
+{
+    std::sort(latency.begin(), latency.end());
+    const auto mean =
+        latency.empty()
+            ? 0
+            : std::accumulate(latency.begin(), latency.end(), std::int64_t{0}) /
+                  static_cast<std::int64_t>(latency.size());
+    output << std::setw(8) << name << std::setw(10) << latency.size();
+
+    for (const auto fraction : {0.5, 0.9, 0.99, 0.999}) {
+        output << std::setw(10) << percentile(latency, fraction);
+    }
+
+    output << std::setw(10) << (latency.empty() ? 0 : latency.back())
+           << std::setw(10) << mean << '\n';
+}
+
+Replay::Replay(const Settings& settings)
+    : settings_(settings)
+    , context_(zmq_ctx_new())
+    , sockets_()
+    , connection_socket_()
+    , pending_()
+    , outstanding_(0)
+    , sent_(0)
+    , send_failures_(0)
+    , pushes_(0)
+    , unmatched_(0)
+    , rejected_()
+    , latency_()
+{
+}
+
+bool Replay::connect()
+{
+    if (nullptr == context_) { return false; }
+
+    const auto count = std::max<std::size_t>(settings_.connections_, 1);
+    const int linger{0};
+
+    for (std::size_t i{0}; i < count; ++i) {
+        auto* socket = zmq_socket(context_, ZMQ_DEALER);
+
+        if (nullptr == socket) { return false; }
+
+        sockets_.emplace_back(socket);
+        zmq_setsockopt(socket, ZMQ_LINGER, &linger, sizeof(linger));
+
+        if (false == settings_.server_key_.empty()) {
+            const bool keys =
+                (0 == zmq_setsockopt(
+                          socket,
+                          ZMQ_CURVE_SERVERKEY,
+                          settings_.server_key_.c_str(),
+                          settings_.server_key_.size())) &&
+                (0 == zmq_setsockopt(
+                          socket,
+                          ZMQ_CURVE_PUBLICKEY,
+                          settings_.client_public_key_.c_str(),
+                          settings_.client_public_key_.size())) &&
+                (0 == zmq_setsockopt(
+                          socket,
+                          ZMQ_CURVE_SECRETKEY,
+                          settings_.client_secret_key_.c_str(),
+                          settings_.client_secret_key_.size()));
+
+            if (false == keys) { return false; }
+        }
+
+        if (0 != zmq_connect(socket, settings_.endpoint_.c_str())) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void Replay::handle_reply(
+    const std::size_t index,
+    std::vector<std::string>&& reply)
+{
+    if (reply.empty()) {
+        ++unmatched_;
+
+        return;
+    }
+
+    if (PUSH_FRAME == reply.front()) {
+        ++pushes_;
+
+        return;
+    }
+
+    proto::RPCResponse response{};
+
+    if (false == response.ParseFromString(reply.front())) {
+        ++unmatched_;
+
+        return;
+    }
+
+    auto it = pending_.find({index, response.cookie()});
+
+    if (pending_.end() == it) {
+        ++unmatched_;
+
+        return;
+    }
+
+    auto& queue = it->second;
+    const auto& request = queue.front();
+    latency_[request.type_].emplace_back(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            Clock::now() - request.sent_)
+            .count());
+    queue.pop_front();
+
+    if (queue.empty()) { pending_.erase(it); }
+
+    --outstanding_;
+
+    // Refused requests carry the reason in a second frame
+    if (1 < reply.size()) { ++rejected_[reply.at(1)]; }
+}
+
+void Replay::poll(const std::chrono::milliseconds timeout)
+{
+    std::vector<zmq_pollitem_t> items{};
+    items.reserve(sockets_.size());
+
+    for (auto* socket : sockets_) {
+        items.push_back(zmq_pollitem_t{socket, 0, ZMQ_POLLIN, 0});
+    }
+
+    const auto ready = zmq_poll(
+        items.data(), static_cast<int>(items.size()), timeout.count());
+
+    if (0 >= ready) { return; }
+
+    for (std::size_t i{0}; i < items.size(); ++i) {
+        if (0 == (items.at(i).revents & ZMQ_POLLIN)) { continue; }
+
+        std::vector<std::string> reply{};
+
+        while (receive(sockets_.at(i), reply)) {
+            handle_reply(i, std::move(reply));
+            reply = {};
+        }
+    }
+}
+
+bool Replay::receive(void* socket, std::vector<std::string>& output)
+{
+    bool more{true};
+    bool first{true};
+    bool delimiter{false};
+
+    while (more) {
+        zmq_msg_t frame{};
+        zmq_msg_init(&frame);
+
+        // Only the first frame can be missing. The rest of a message always
+        // arrives with it.
+        if (0 > zmq_msg_recv(&frame, socket, first ? ZMQ_DONTWAIT : 0)) {
+            zmq_msg_close(&frame);
+
+            return false;
+        }
+
+        first = false;
+        const auto size = zmq_msg_size(&frame);
+
+        if (delimiter || (0 < size)) {
+            output.emplace_back(
+                static_cast<const char*>(zmq_msg_data(&frame)), size);
+        } else {
+            delimiter = true;
+        }
+
+        more = (1 == zmq_msg_more(&frame));
+        zmq_msg_close(&frame);
+    }
+
+    return true;
+}
+
+void Replay::report(
+    std::ostream& output,
+    const capture::Reader& capture,
+    const Clock::duration elapsed) const
+{
+    const auto seconds =
+        std::chrono::duration_cast<std::chrono::duration<double>>(elapsed)
+            .count();
+    const auto rate =
+        (0.0 < seconds) ? static_cast<double>(sent_) / seconds : 0.0;
+    output << "Sent " << sent_ << " requests in " << std::fixed
+           << std::setprecision(3) << seconds << " s ("
+           << std::setprecision(1) << rate << " per second) at ";
+
+    if (0.0 < settings_.speed_) {
+        output << settings_.speed_ << "x the captured rate\n";
+    } else {
+        output << "full speed with a window of " << settings_.window_ << '\n';
+    }
+
+    if (0 != (capture.Flags() & capture::FlagRedacted)) {
+        output << "The capture is redacted. Commands only had their type, "
+                  "session and cookie.\n";
+    }
+
+    output << "Unanswered: " << outstanding_
+           << ", send failures: " << send_failures_
+           << ", pushes: " << pushes_
+           << ", unmatched replies: " << unmatched_ << '\n';
+
+    for (const auto& [reason, count] : rejected_) {
+        output << "Rejected " << reason << ": " << count << '\n';
+    }
+
+    output << "\nLatency in microseconds, by command type\n"
+           << std::setw(8) << "type" << std::setw(10) << "count"
+           << std::setw(10) << "p50" << std::setw(10) << "p90"
+           << std::setw(10) << "p99" << std::setw(10) << "p99.9"
+           << std::setw(10) << "max" << std::setw(10) << "mean" << '\n';
+    std::vector<std::int64_t> all{};
+
+    for (const auto& [type, values] : latency_) {
+        auto latency = values;
+        all.insert(all.end(), latency.begin(), latency.end());
+        print_row(output, std::to_string(type), latency);
+    }
+
+    print_row(output, "all", all);
+}
+
+bool Replay::Run(capture::Reader& capture, std::ostream& output)
+{
+    if (false == connect()) { return false; }
+
+    capture::Record record{};
+    auto more = capture.Next(record);
+    const auto start = Clock::now();
+
+    while (more) {
+        if (0.0 < settings_.speed_) {
+            const auto due =
+                start + std::chrono::duration_cast<Clock::duration>(
+                            std::chrono::duration<double, std::nano>(
+                                static_cast<double>(record.time_.count()) /
+                                settings_.speed_));
+            const auto now = Clock::now();
+
+            if (now < due) {
+                poll(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    due - now));
+
+                continue;
+            }
+        } else if (outstanding_ >= settings_.window_) {
+            poll(std::chrono::milliseconds(100));
+
+            continue;
+        }
+
+        send(record);
+        more = capture.Next(record);
+        poll(std::chrono::milliseconds(0));
+    }
+
+    const auto deadline = Clock::now() + settings_.timeout_;
+
+    while (0 < outstanding_) {
+        const auto now = Clock::now();
+
+        if (now >= deadline) { break; }
+
+        poll(std::min<std::chrono::milliseconds>(
+            std::chrono::milliseconds(100),
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - now)));
+    }
+
+    report(output, capture, Clock::now() - start);
+
+    return true;
+}
+
+bool Replay::send(const capture::Record& record)
+{
+    if (record.frames_.empty()) { return false; }
+
+    const auto index = socket_index(record.connection_);
+    auto* socket = sockets_.at(index);
+    proto::RPCCommand command{};
+    command.ParseFromString(record.frames_.front());
+    const auto count =
+        settings_.strip_options_ ? std::size_t{1} : record.frames_.size();
+    const Pending pending{Clock::now(), static_cast<int>(command.type())};
+    bool sent = (0 == zmq_send(socket, nullptr, 0, ZMQ_SNDMORE));
+
+    for (std::size_t i{0}; sent && (i < count); ++i) {
+        const auto& frame = record.frames_.at(i);
+        sent = (0 <= zmq_send(
+                         socket,
+                         frame.data(),
+                         frame.size(),
+                         ((i + 1) < count) ? ZMQ_SNDMORE : 0));
+    }
+
+    if (false == sent) {
+        ++send_failures_;
+
+        return false;
+    }
+
+    pending_[{index, command.cookie()}].push_back(pending);
+    ++outstanding_;
+    ++sent_;
+
+    return true;
+}
+
+std::size_t Replay::socket_index(const std::string& connection)
+{
+    // Captured connections are assigned sockets in order of appearance, so
+    // requests from one connection stay on one socket
+    const auto [it, added] =
+        connection_socket_.try_emplace(connection, connection_socket_.size());
+
+    return it->second % sockets_.size();
+}
+
+Replay::~Replay()
+{
+    for (auto* socket : sockets_) { zmq_close(socket); }
+
+    if (nullptr != context_) { zmq_ctx_term(context_); }
+}
+}  // namespace opentxs::agent::replay
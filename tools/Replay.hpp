@@ -0,0 +1,106 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef REPLAY_HPP_
+#define REPLAY_HPP_
+
+#include "Capture.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace opentxs::agent::replay
+{
+// Plays a request capture back against an agent and measures how long each
+// request takes to be answered. Requests are sent open loop at their captured
+// times, so a slow agent shows up as growing latency rather than a slower
+// replay.
+class Replay
+{
+public:
+    struct Settings {
+        std::string endpoint_{};
+        // Z85 encoded keys. CURVE is used when server_key_ is set, otherwise
+        // the agent must authenticate the endpoint by peer credentials.
+        std::string server_key_{};
+        std::string client_public_key_{};
+        std::string client_secret_key_{};
+        // Multiple of the captured rate, or zero to send as fast as the
+        // window allows
+        double speed_{1.0};
+        // Most unanswered requests when speed_ is zero
+        std::size_t window_{64};
+        // Sockets the captured connections are spread over
+        std::size_t connections_{16};
+        // How long to wait for replies after the last request is sent
+        std::chrono::seconds timeout_{10};
+        // Drops option frames. Idempotency keys would otherwise get a second
+        // replay the responses remembered from the first.
+        bool strip_options_{false};
+    };
+
+    explicit Replay(const Settings& settings);
+
+    // Returns false if the agent couldn't be reached
+    bool Run(capture::Reader& capture, std::ostream& report);
+
+    ~Replay();
+
+private:
+    using Clock = std::chrono::steady_clock;
+    // socket index, cookie
+    using PendingKey = std::pair<std::size_t, std::string>;
+
+    struct Pending {
+        Clock::time_point sent_;
+        int type_;
+    };
+
+    const Settings settings_;
+    void* context_;
+    std::vector<void*> sockets_;
+    std::map<std::string, std::size_t> connection_socket_;
+    // Cookies can repeat, so each key holds requests in the order sent
+    std::map<PendingKey, std::deque<Pending>> pending_;
+    std::size_t outstanding_;
+    std::uint64_t sent_;
+    std::uint64_t send_failures_;
+    std::uint64_t pushes_;
+    std::uint64_t unmatched_;
+    std::map<std::string, std::uint64_t> rejected_;
+    // Microseconds, by command type
+    std::map<int, std::vector<std::int64_t>> latency_;
+
+    // Returns false if no message is waiting. Output doesn't include the
+    // delimiter.
+    static bool receive(void* socket, std::vector<std::string>& output);
+
+    bool connect();
+    void handle_reply(
+        const std::size_t index,
+        std::vector<std::string>&& reply);
+    // Waits up to timeout for replies and handles all that have arrived
+    void poll(const std::chrono::milliseconds timeout);
+    void report(
+        std::ostream& output,
+        const capture::Reader& capture,
+        const Clock::duration elapsed) const;
+    bool send(const capture::Record& record);
+    std::size_t socket_index(const std::string& connection);
+
+    Replay() = delete;
+    Replay(const Replay&) = delete;
+    Replay(Replay&&) = delete;
+    Replay& operator=(const Replay&) = delete;
+    Replay& operator=(Replay&&) = delete;
+};
+}  // namespace opentxs::agent::replay
+#endif  // REPLAY_HPP_
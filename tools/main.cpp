@@ -0,0 +1,110 @@
+// Copyright (c) 2018 The Open-Transactions developers
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <boost/program_options.hpp>
+
+#include <iostream>
+
+#include "Replay.hpp"
+
+#define OPTION_CAPTURE "capture"
+#define OPTION_CLIENT_PUBLIC_KEY "client-public-key"
+#define OPTION_CLIENT_SECRET_KEY "client-secret-key"
+#define OPTION_CONNECTIONS "connections"
+#define OPTION_ENDPOINT "endpoint"
+#define OPTION_HELP "help"
+#define OPTION_SERVER_KEY "server-key"
+#define OPTION_SPEED "speed"
+#define OPTION_STRIP_OPTIONS "strip-options"
+#define OPTION_TIMEOUT "timeout"
+#define OPTION_WINDOW "window"
+
+namespace po = boost::program_options;
+
+int main(int argc, char** argv)
+{
+    opentxs::agent::replay::Replay::Settings settings{};
+    std::string path{};
+    std::int64_t timeout{settings.timeout_.count()};
+    po::options_description options{"otagent-replay"};
+    options.add_options()(OPTION_HELP, "Show this message.")(
+        OPTION_CAPTURE,
+        po::value<std::string>(&path)->required(),
+        "Capture file written by the agent's capture option.")(
+        OPTION_ENDPOINT,
+        po::value<std::string>(&settings.endpoint_)->required(),
+        "Agent endpoint, e.g. ipc:///run/user/1000/otagent.sock.")(
+        OPTION_SERVER_KEY,
+        po::value<std::string>(&settings.server_key_),
+        "Z85 agent public key. Without it the endpoint must use ipc-auth "
+        "peer.")(
+        OPTION_CLIENT_PUBLIC_KEY,
+        po::value<std::string>(&settings.client_public_key_),
+        "Z85 client public key.")(
+        OPTION_CLIENT_SECRET_KEY,
+        po::value<std::string>(&settings.client_secret_key_),
+        "Z85 client secret key.")(
+        OPTION_SPEED,
+        po::value<double>(&settings.speed_)->default_value(settings.speed_),
+        "Multiple of the captured request rate (0 = as fast as possible).")(
+        OPTION_WINDOW,
+        po::value<std::size_t>(&settings.window_)
+            ->default_value(settings.window_),
+        "Most unanswered requests when speed is 0.")(
+        OPTION_CONNECTIONS,
+        po::value<std::size_t>(&settings.connections_)
+            ->default_value(settings.connections_),
+        "Sockets to spread the captured connections over.")(
+        OPTION_TIMEOUT,
+        po::value<std::int64_t>(&timeout)->default_value(timeout),
+        "Seconds to wait for replies after the last request.")(
+        OPTION_STRIP_OPTIONS,
+        po::bool_switch(&settings.strip_options_),
+        "Send commands without their option frames.");
+    po::positional_options_description positional{};
+    positional.add(OPTION_CAPTURE, 1);
+
+    try {
+        po::variables_map variables{};
+        po::store(
+            po::command_line_parser(argc, argv)
+                .options(options)
+                .positional(positional)
+                .run(),
+            variables);
+
+        if (0 < variables.count(OPTION_HELP)) {
+            std::cout << options << std::endl;
+
+            return 0;
+        }
+
+        po::notify(variables);
+    } catch (po::error& e) {
+        std::cerr << "ERROR: " << e.what() << "\n\n" << options << std::endl;
+
+        return 1;
+    }
+
+    settings.timeout_ = std::chrono::seconds(timeout);
+    auto capture = opentxs::agent::capture::Reader::Open(path);
+
+    if (false == bool(capture)) {
+        std::cerr << "ERROR: " << path << " is not a capture file" << std::endl;
+
+        return 1;
+    }
+
+    opentxs::agent::replay::Replay replay(settings);
+
+    if (false == replay.Run(*capture, std::cout)) {
+        std::cerr << "ERROR: Unable to connect to " << settings.endpoint_
+                  << std::endl;
+
+        return 1;
+    }
+
+    return 0;
+}